@@ -3,6 +3,12 @@ apple2_CC65    := apple2
 apple2_LDFLAGS := --start-addr 0x4000 -Wl -D -Wl __HIMEM__=0xBF00
 apple2_EMUCMD  := $(AWIN_HOME)AppleWin.exe -d1
 
+# Nodes a second on a stock IIe, the same way as the C64's: tests/cyclemodel
+# prices c64skill's game at 10.2s and 37.0s a move for levels 1 and 2.  No
+# clock() worth timing with, so the rate stays where it is put.  Off until a
+# real IIe game has been timed against it
+# apple2_CFLAGS += -DSEARCH_NPS=28
+
 APPLE2_BIN := $(BUILDDIR)/apple2/$(NAME)
 APPLE2_PO  := $(BUILDDIR)/apple2/$(NAME).po
 APPLE2_DSK := $(BUILDDIR)/apple2/$(NAME).dsk
@@ -33,3 +33,9 @@ $(ATARI_DSK)/%.sys: $(ATARIDOS)/%.sys | $(ATARI_DSK)
 $(ATARI_ATR): $(ATARI_BIN) $(ATARI_DSK) $(ATRDOSOBJS)
 	$(call CP,$< $(ATARI_DSK)/$(NAME))
 	$(DIR2ATR) -b $(ATARIDOSTYPE) $@ $(ATARI_DSK)
+
+# The engine's hot scalars in zero page (src/enginezp.s).  The cfg gives cc65
+# all of $82-$FF and its runtime uses 26 bytes, so ENGZP goes in behind it.
+# Every access it moves is also a byte shorter, which counts on this port
+#atari_CFLAGS  += -DENGINE_ZP=1
+#atari_ASFLAGS += --asm-define ENGINE_ZP=1
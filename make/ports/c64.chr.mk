@@ -12,3 +12,7 @@ cprg: $(C64CHR_PRG)
 
 $(C64CHR_PRG): $(C64CHR_BIN)
 	$(call CP,$< $@)
+
+# Zero-page engine scalars, as in c64.mk
+#c64.chr_CFLAGS  += -DENGINE_ZP=1
+#c64.chr_ASFLAGS += --asm-define ENGINE_ZP=1
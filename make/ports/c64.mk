@@ -18,3 +18,25 @@ $(C64_PRG): $(C64_BIN)
 
 $(C64_D64): $(C64_BIN)
 	$(C1541) -format "$(NAME)","01" d64 $@ -attach $@ -write $< $(NAME).prg
+
+# Nodes a second through a real game on a stock C64: c64skill's levels 1-4
+# by tests/cyclemodel, fitted to the measured 11.0s and 39.7s of levels 1
+# and 2.  Turns on the timed levels; clock() is the jiffy clock, so the rate
+# then follows an accelerator or a warped emulator move by move.  Off until
+# the timed levels have been played on the machine and the rate confirmed
+# c64_CFLAGS += -DSEARCH_NPS=27 -DSEARCH_RECALIBRATE=1
+
+# The 6502 engine kernels (src/engine65.s).  Not on by default: they have to
+# give c64perft's counts and c64search's node counts before a build ships them
+#c64_CFLAGS  += -DENGINE_ASM=1
+#c64_ASFLAGS += --asm-define ENGINE_ASM=1
+
+# The engine's hot scalars in zero page (src/enginezp.s), at the ENGZP area
+# chessC64.cfg sets aside.  Off until c64profile's baseline row has priced it
+#c64_CFLAGS  += -DENGINE_ZP=1
+#c64_ASFLAGS += --asm-define ENGINE_ZP=1
+
+# Thinking on the player's move between keys, with H for the hint.  Off until
+# the code it adds has been found room for and the build measured.  The
+# default slice of 8 nodes answers a key in about a third of a second
+#c64_CFLAGS  += -DSEARCH_IDLE=1
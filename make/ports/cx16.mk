@@ -11,3 +11,7 @@ cxprg: $(CX16_PRG)
 
 $(CX16_PRG): $(CX16_BIN)
 	$(call CP,$< $@)
+
+# The banked RAM behind plat_Bank* (platCX16.c).  Not on by default: nothing
+# has measured it on an X16 yet.  Eight banks hold a 8192 entry move cache
+#cx16_CFLAGS := -DPLAT_BANKS=8 -DSEARCH_MOVE_CACHE=8192
@@ -15,3 +15,26 @@ MAC68K_R       := $(SRCDIR)/mac68k/chess.r $(SRCDIR)/mac68k/icon.r
 MAC68K_CFLAGS  := -funsigned-char -O2 -ffunction-sections -I$(SRCDIR) \
 	-DPLAT_CURSOR_JUMP
 MAC68K_LDFLAGS := -Wl,-gc-sections -Wl,--mac-strip-macsbug
+
+# The board.c options plat.h leaves to a port that has the room: B's counts
+# brought forward from what a move changed, and the turn's legal move map.
+# Room is not the question here
+MAC68K_CFLAGS  += -DPLAT_ATTACK_UPDATE=1 -DPLAT_LEGAL_MAP=1
+
+# The large-memory profile, on unless MAC68K_PROFILE=small.  The 8-bit ports
+# size everything for 64K and a 16-bit int; a Mac has neither limit.  int is
+# 32 bits here, so the node count and budgets are already wide and a fifth
+# level can have 250000 nodes.  The move cache takes the whole 16-bit key
+# space - 65536 slots, 512K from NewPtrClear - which is as big as that key
+# can use; a score table needs a 32-bit key the engine does not keep.  The
+# arena, ply limit and the F1-F3 ordering options are the rest.  small is the
+# same engine every other port runs
+MAC68K_PROFILE ?= large
+ifeq ($(MAC68K_PROFILE),large)
+MAC68K_CFLAGS += -DPLAT_HEAP=1 -DSEARCH_MOVE_CACHE=65536 -DSEARCH_ARENA=4096 \
+	-DSEARCH_MAX_PLY=24 -DSEARCH_NUM_SKILLS=5 \
+	-DSEARCH_HISTORY=1 -DSEARCH_FOLLOW_PV=1 -DSEARCH_ROOT_SCORES=1
+# Idle thinking and the H hint.  A WaitNextEvent every 256 nodes is a few
+# times a second on a Plus and lets the other applications breathe
+MAC68K_CFLAGS += -DSEARCH_IDLE=1 -DSEARCH_IDLE_SLICE=256
+endif
@@ -12,3 +12,12 @@ SPECTRUM_SNA    := $(BUILDDIR)/spectrum/chess.sna
 SPECTRUM_CFLAGS := +zx -vn -O3 -clib=default -zorg=$(SPECTRUM_ORG) \
 	-pragma-define:REGISTER_SP=$(SPECTRUM_SP) \
 	-DSEARCH_ARENA=256 -m
+
+# The Z80 engine kernels (src/spectrum/engineZ80.asm).  Off by default: a
+# build with them has to give tests/zxsearch.c's counts first.
+#   make TARGETS=spectrum SPECTRUM_ENGINE_ASM=1
+SPECTRUM_ENGINE_ASM ?= 0
+ifeq ($(SPECTRUM_ENGINE_ASM),1)
+SPECTRUM_CFLAGS += -DENGINE_ASM=1
+SPECTRUM_ASM    := $(SRCDIR)/spectrum/engineZ80.asm
+endif
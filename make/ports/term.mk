@@ -5,4 +5,10 @@ term_TEST_ARG :=
 
 TERM_BIN := $(BUILDDIR)/term/chessterm
 TERM_CFLAGS := -I$(SRCDIR) -funsigned-char
+# think on the player's move between keys, H for what it found.  a host does
+# millions of nodes a second, so a getch every 4096 still answers at once
+TERM_CFLAGS += -DSEARCH_IDLE=1 -DSEARCH_IDLE_SLICE=4096
+# the board.c options plat.h leaves to a port with room: B's counts brought
+# forward from what a move changed, and the turn's legal move map
+TERM_CFLAGS += -DPLAT_ATTACK_UPDATE=1 -DPLAT_LEGAL_MAP=1
 TERM_LIBS   := -lcurses
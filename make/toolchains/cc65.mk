@@ -17,6 +17,8 @@ ifeq ($($(TARGETLIST)_AVAILABLE),1)
 PROGRAM      := $(BUILDDIR)/$(TARGETLIST)/$(NAME)
 TARGETOBJDIR := $(OBJDIR)/$(TARGETLIST)
 CC65TARGET   := $($(TARGETLIST)_CC65)
+CFLAGS       += $($(TARGETLIST)_CFLAGS)
+ASFLAGS      += $($(TARGETLIST)_ASFLAGS)
 LDFLAGS      += $($(TARGETLIST)_LDFLAGS)
 
 SOURCES := $(wildcard $(SRCDIR)/*.c)
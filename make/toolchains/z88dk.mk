@@ -9,7 +9,7 @@ endif
 ifeq ($(TARGETLIST),spectrum)
 ifeq ($(spectrum_AVAILABLE),1)
 
-SPECTRUM_SRCS := $(ENGINE_C) $(SRCDIR)/spectrum/platSpectrum.c
+SPECTRUM_SRCS := $(ENGINE_C) $(SRCDIR)/spectrum/platSpectrum.c $(SPECTRUM_ASM)
 SPECTRUM_ABS  := $(abspath $(SPECTRUM_SRCS))
 
 $(BUILDDIR)/spectrum:
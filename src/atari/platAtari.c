@@ -480,6 +480,10 @@ int plat_ReadKeys(char blocking)
 		case KEY_U:
 			keyMask |= INPUT_UNDO;
 		break;
+
+		case KEY_H:		// 'h' - Hint
+			keyMask |= INPUT_HINT;
+		break;
 		
 		// default:		// Debug - show key code
 		// {
@@ -490,6 +490,11 @@ int plat_ReadKeys(char blocking)
     case 'u':
       keyMask |= INPUT_UNDO;
       break;
+
+    case 'H':
+    case 'h':
+      keyMask |= INPUT_HINT;
+      break;
   }
 
   return keyMask;
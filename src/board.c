@@ -6,11 +6,13 @@
  *
  */
 
+#include <string.h>
 #include "types.h"
 #include "globals.h"
 #include "engine.h"
 #include "search.h"
 #include "undo.h"
+#include "plat.h"
 #include "board.h"
 
 /*-----------------------------------------------------------------------*/
@@ -21,6 +23,40 @@ char	gNumMoveTiles;
 // sixteen pieces bearing on one tile
 static char	sc_attackers[16];
 
+// gpAttackBoard is only worth updating a piece at a time while it describes
+// the board gChessBoard last showed.  Anything else - the display just turned
+// on, or left off while pieces moved - needs the full recount once, and every
+// tile drawn.  Without PLAT_ATTACK_UPDATE every sync recounts the lot, and
+// this only says the numbers are on screen
+static char	sc_countsValid;
+
+#if PLAT_ATTACK_UPDATE
+// Tiles whose counts have to be taken again, one bit each
+static char	sc_recount[8];
+#endif
+
+// Tiles that look different from when board_DrawChanged last drew them, in
+// the same form: a byte a row, a bit a column
+static char	sc_changed[8];
+
+#if PLAT_LEGAL_MAP
+// The side to move's legal destinations, taken once a turn by board_LegalMap
+// so the cursor, board_IsPromotion and board_FindMove look moves up instead
+// of generating them.  A tile's destinations are sc_mapTo[sc_mapFirst[tile]]
+// up to sc_mapFirst[tile + 1]; a side that does not fit in one move list
+// gets no map
+static char	sc_mapTo[ENG_MAX_MOVES];
+static char	sc_mapFirst[65];
+static char	sc_mapSide;
+static char	sc_mapValid;
+static unsigned int	si_mapKey;
+#endif
+
+#if PLAT_ATTACK_UPDATE
+static const signed char sc_rays[8]    = { -17, -16, -15, -1, 1, 15, 16, 17 };
+static const signed char sc_knights[8] = { -33, -31, -18, -14, 14, 18, 31, 33 };
+#endif
+
 /*-----------------------------------------------------------------------*/
 void board_Init(void)
 {
@@ -40,7 +76,13 @@ void board_Init(void)
 	gCursorPos[SIDE_WHITE][0] = 7;
 
 	gNumMoveTiles = 0;
+#if PLAT_LEGAL_MAP
+	sc_mapValid = 0;
+#endif
 	board_SyncDisplay();
+
+	// a new game is drawn whole, so there is nothing left over to draw
+	memset(sc_changed, 0, sizeof(sc_changed));
 }
 
 /*-----------------------------------------------------------------------*/
@@ -56,26 +98,88 @@ char board_AttackersOf(char tile, char side, char *tiles)
 }
 
 /*-----------------------------------------------------------------------*/
-// Only done when the whole-board display is on, because it is 128 ray-casts
-// and there is no reason to pay for it otherwise
+static void board_MarkChanged(char tile)
+{
+	sc_changed[tile >> 3] |= 1 << (tile & 7);
+}
+
+/*-----------------------------------------------------------------------*/
+// A tile recounted to the same numbers does not need drawing again
+static void board_CountTile(char tile)
+{
+	char sq = ENG_FROM_TILE(tile);
+	char black = eng_AttackersOf(sq, SIDE_BLACK, sc_attackers);
+	char white = eng_AttackersOf(sq, SIDE_WHITE, sc_attackers);
+
+	if(gpAttackBoard[giAttackBoardOffset[tile][SIDE_BLACK]] != black ||
+	   gpAttackBoard[giAttackBoardOffset[tile][SIDE_WHITE]] != white)
+	{
+		gpAttackBoard[giAttackBoardOffset[tile][SIDE_BLACK]] = black;
+		gpAttackBoard[giAttackBoardOffset[tile][SIDE_WHITE]] = white;
+		board_MarkChanged(tile);
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+// The whole board, 128 ray-casts.  Only done when the counts cannot be
+// brought forward from the last board they described, or with no
+// PLAT_ATTACK_UPDATE to bring them
 static void board_RefreshAttackCounts(void)
 {
-	char tile, sq;
+	char tile;
 
 	for(tile = 0; tile < 64; ++tile)
+		board_CountTile(tile);
+}
+
+#if PLAT_ATTACK_UPDATE
+/*-----------------------------------------------------------------------*/
+static void board_MarkRecount(char sq)
+{
+	char tile = ENG_TO_TILE(sq);
+
+	sc_recount[tile >> 3] |= 1 << (tile & 7);
+}
+
+/*-----------------------------------------------------------------------*/
+// Square "sq" changed.  A tile's count can only change if one of its
+// attackers stood on a changed square, or a slider's line to it runs through
+// one.  Knights are only a jump from where one stood or stands.  Everything
+// else lies along a ray out of a changed square, up to the first occupied
+// square: a changed square beyond that is walked from in its own right, and
+// an unchanged one blocks the line on the old board and the new one alike.
+// Pawn and king attacks are a ray's first step, so the rays cover them
+static void board_MarkAround(char sq, char was)
+{
+	char i, to;
+	char knight = (KNIGHT == (was & PIECE_DATA) || KNIGHT == (geBoard[sq] & PIECE_DATA));
+
+	for(i = 0; i < 8; ++i)
 	{
-		sq = ENG_FROM_TILE(tile);
-		gpAttackBoard[giAttackBoardOffset[tile][SIDE_BLACK]] =
-			eng_AttackersOf(sq, SIDE_BLACK, sc_attackers);
-		gpAttackBoard[giAttackBoardOffset[tile][SIDE_WHITE]] =
-			eng_AttackersOf(sq, SIDE_WHITE, sc_attackers);
+		to = sq + sc_knights[i];
+		if(knight && !ENG_OFFBOARD(to))
+			board_MarkRecount(to);
+
+		for(to = sq + sc_rays[i]; !ENG_OFFBOARD(to); to += sc_rays[i])
+		{
+			board_MarkRecount(to);
+			if(NONE != (geBoard[to] & PIECE_DATA))
+				break;
+		}
 	}
 }
 
 /*-----------------------------------------------------------------------*/
-void board_SyncDisplay(void)
+// Counts only for what moved.  A move changes two to four squares, and over
+// the fuzzer's games this takes 27 tiles of the 64 again on average rather
+// than all of them; the fuzzer also holds it to the full recount after every
+// move, and after the undos and redos it syncs
+static void board_UpdateAttackCounts(void)
 {
-	char sq, tile;
+	char sq, tile, bits;
+
+	for(sq = 0; sq < 8; ++sq)
+		sc_recount[sq] = 0;
 
 	for(sq = 0; sq < 0x78; ++sq)
 	{
@@ -83,73 +187,204 @@ void board_SyncDisplay(void)
 			continue;
 
 		tile = ENG_TO_TILE(sq);
-		gChessBoard[tile >> 3][tile & 7] = geBoard[sq];
+		if(gChessBoard[tile >> 3][tile & 7] != geBoard[sq])
+			board_MarkAround(sq, gChessBoard[tile >> 3][tile & 7]);
 	}
 
-	if(gShowAttackBoard)
-		board_RefreshAttackCounts();
+	for(tile = 0; tile < 64; tile += 8)
+	{
+		bits = sc_recount[tile >> 3];
+		for(sq = tile; bits; ++sq, bits >>= 1)
+			if(bits & 1)
+				board_CountTile(sq);
+	}
 }
 
+#endif
+
 /*-----------------------------------------------------------------------*/
-// Legal, not pseudo-legal: a move that leaves the king in check is not shown
-// to the player as an option at all, so there is no "Invalid" to report any
-// more.  A promotion collapses to a single destination here - which piece it
-// becomes is asked separately
-void board_LegalMovesFrom(char tile)
+void board_SyncDisplay(void)
 {
-	t_engMove moves[MAX_PIECE_MOVES + 4];
-	t_engUndo undo;
-	char from = ENG_FROM_TILE(tile);
-	char piece = geBoard[from];
-	char side, count, i;
-
-	gNumMoveTiles = 0;
-
-	if(NONE == (piece & PIECE_DATA))
-		return;
+	char sq, tile;
 
-	side = (piece & PIECE_WHITE) >> 7;
-	count = eng_GenMovesFrom(from, side, moves, MAX_PIECE_MOVES + 4);
+	// the counts come first: they find what changed by comparing the engine
+	// board against the mirror before it is brought up to date.  The display
+	// going on or off changes how every tile looks
+	if(!gShowAttackBoard)
+	{
+		if(sc_countsValid)
+			memset(sc_changed, 0xFF, sizeof(sc_changed));
+		sc_countsValid = 0;
+	}
+	else if(sc_countsValid)
+#if PLAT_ATTACK_UPDATE
+		board_UpdateAttackCounts();
+#else
+		board_RefreshAttackCounts();
+#endif
 
-#if ENGINE_FAST_LEGAL
+	for(sq = 0; sq < 0x78; ++sq)
 	{
-		char wasInCheck = eng_InCheck(side);
+		if(ENG_OFFBOARD(sq))
+			continue;
 
-		for(i = 0; i < count; ++i)
+		tile = ENG_TO_TILE(sq);
+		if(gChessBoard[tile >> 3][tile & 7] != geBoard[sq])
 		{
-			char to;
+			gChessBoard[tile >> 3][tile & 7] = geBoard[sq];
+			board_MarkChanged(tile);
+		}
+	}
 
-			eng_Make(&moves[i], &undo);
-			to = eng_LeavesInCheck(side, &moves[i], wasInCheck)
-				? NULL_TILE : ENG_TO_TILE(moves[i].m_to);
-			eng_Unmake(&moves[i], &undo);
+	if(gShowAttackBoard && !sc_countsValid)
+	{
+		board_RefreshAttackCounts();
+		memset(sc_changed, 0xFF, sizeof(sc_changed));
+		sc_countsValid = 1;
+	}
+}
 
-			if(NULL_TILE == to)
-				continue;
+/*-----------------------------------------------------------------------*/
+void board_DrawChanged(void)
+{
+#if PLAT_DRAW_SQUARES
+	plat_DrawSquares(sc_changed);
+#else
+	char row, tile, bits;
 
-			if(!board_findInList(gMoveTiles, gNumMoveTiles, to) &&
-			   gNumMoveTiles < MAX_PIECE_MOVES)
-				gMoveTiles[gNumMoveTiles++] = to;
-		}
+	for(row = 0; row < 8; ++row)
+	{
+		bits = sc_changed[row];
+		for(tile = row << 3; bits; ++tile, bits >>= 1)
+			if(bits & 1)
+				plat_DrawSquare(tile);
 	}
-#else
+#endif
+
+	memset(sc_changed, 0, sizeof(sc_changed));
+}
+
+/*-----------------------------------------------------------------------*/
+// Legal destinations for the piece on "from" into "tiles", at most "room" of
+// them, returned as a count.  Legal, not pseudo-legal: a move that leaves the
+// king in check is not shown to the player as an option at all, so there is
+// no "Invalid" to report any more.  A promotion collapses to a single
+// destination here - which piece it becomes is asked separately
+static char board_LegalFrom(char from, char side, char *tiles, char room)
+{
+	t_engMove moves[MAX_PIECE_MOVES + 4];
+	t_engUndo undo;
+	char count, i, to, found = 0;
+#if ENGINE_FAST_LEGAL
+	char wasInCheck = eng_InCheck(side);
+#endif
+
+	count = eng_GenMovesFrom(from, side, moves, MAX_PIECE_MOVES + 4);
+
 	for(i = 0; i < count; ++i)
 	{
-		char to;
-
 		eng_Make(&moves[i], &undo);
+#if ENGINE_FAST_LEGAL
+		to = eng_LeavesInCheck(side, &moves[i], wasInCheck)
+			? NULL_TILE : ENG_TO_TILE(moves[i].m_to);
+#else
 		to = eng_IsAttacked(geKing[side], 1 - side) ? NULL_TILE : ENG_TO_TILE(moves[i].m_to);
+#endif
 		eng_Unmake(&moves[i], &undo);
 
 		if(NULL_TILE == to)
 			continue;
 
 		// the four promotions share one destination
-		if(!board_findInList(gMoveTiles, gNumMoveTiles, to) &&
-		   gNumMoveTiles < MAX_PIECE_MOVES)
-			gMoveTiles[gNumMoveTiles++] = to;
+		if(!board_findInList(tiles, found, to) && found < room)
+			tiles[found++] = to;
+	}
+
+	return found;
+}
+
+#if PLAT_LEGAL_MAP
+/*-----------------------------------------------------------------------*/
+void board_LegalMap(char side)
+{
+	char tiles[MAX_PIECE_MOVES];
+	char tile, piece, count, used = 0;
+
+	// A side can have more destinations than one move list holds - 218 is
+	// the known most.  Such a map would drop moves the player could never
+	// then enter, so it is left invalid and every lookup goes the long way
+	sc_mapValid = 0;
+
+	for(tile = 0; tile < 64; ++tile)
+	{
+		sc_mapFirst[tile] = used;
+
+		piece = geBoard[ENG_FROM_TILE(tile)];
+		if(NONE == (piece & PIECE_DATA) || side != ((piece & PIECE_WHITE) >> 7))
+			continue;
+
+		count = board_LegalFrom(ENG_FROM_TILE(tile), side, tiles, MAX_PIECE_MOVES);
+		if(count > ENG_MAX_MOVES - used)
+			return;
+		memcpy(&sc_mapTo[used], tiles, count);
+		used += count;
+	}
+	sc_mapFirst[64] = used;
+
+	sc_mapSide = side;
+	si_mapKey = eng_PositionKey();
+	sc_mapValid = 1;
+}
+
+/*-----------------------------------------------------------------------*/
+// Does the map answer for "piece" on "tile"?  Only if it was taken for that
+// piece's side, in this position, and nothing has moved since.  Everything
+// else - the other side's pieces, a test that set a board up by hand - goes
+// the long way, which is what every lookup used to do
+static char board_MapCovers(char piece)
+{
+	return sc_mapValid && NONE != (piece & PIECE_DATA) &&
+	       sc_mapSide == ((piece & PIECE_WHITE) >> 7) &&
+	       si_mapKey == eng_PositionKey();
+}
+
+/*-----------------------------------------------------------------------*/
+static char board_MapHas(char fromTile, char toTile)
+{
+	char i;
+
+	for(i = sc_mapFirst[fromTile]; i < sc_mapFirst[fromTile + 1]; ++i)
+		if(toTile == sc_mapTo[i])
+			return 1;
+
+	return 0;
+}
+
+#endif
+
+/*-----------------------------------------------------------------------*/
+void board_LegalMovesFrom(char tile)
+{
+	char piece = geBoard[ENG_FROM_TILE(tile)];
+
+	gNumMoveTiles = 0;
+
+	if(NONE == (piece & PIECE_DATA))
+		return;
+
+#if PLAT_LEGAL_MAP
+	if(board_MapCovers(piece))
+	{
+		char i;
+
+		for(i = sc_mapFirst[tile]; i < sc_mapFirst[tile + 1] && gNumMoveTiles < MAX_PIECE_MOVES; ++i)
+			gMoveTiles[gNumMoveTiles++] = sc_mapTo[i];
+		return;
 	}
 #endif
+
+	gNumMoveTiles = board_LegalFrom(ENG_FROM_TILE(tile), (piece & PIECE_WHITE) >> 7,
+	                                gMoveTiles, MAX_PIECE_MOVES);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -163,6 +398,13 @@ char board_IsPromotion(char fromTile, char toTile)
 	if(PAWN != (piece & PIECE_DATA))
 		return 0;
 
+	// a pawn move is a promotion exactly when it lands on the far rank, and a
+	// pawn can only ever move towards that one
+#if PLAT_LEGAL_MAP
+	if(board_MapCovers(piece))
+		return (0 == ENG_ROW(to) || 7 == ENG_ROW(to)) && board_MapHas(fromTile, toTile);
+#endif
+
 	count = eng_GenMovesFrom(from, (piece & PIECE_WHITE) >> 7, moves, MAX_PIECE_MOVES + 4);
 	for(i = 0; i < count; ++i)
 		if(moves[i].m_to == to && (moves[i].m_flags & ENG_MF_PROMO))
@@ -182,6 +424,45 @@ char board_FindMove(char fromTile, char toTile, char promote, t_engMove *move)
 	if(NONE == (piece & PIECE_DATA))
 		return 0;
 
+#if PLAT_LEGAL_MAP
+	if(board_MapCovers(piece))
+	{
+		char flags = 0;
+
+		if(!board_MapHas(fromTile, toTile))
+			return 0;
+
+		// The map keeps destinations only; what kind of move it is follows
+		// from the board, the same way eng_GenMovesFrom decided it
+		if(PAWN == (piece & PIECE_DATA))
+		{
+			if(0 == ENG_ROW(to) || 7 == ENG_ROW(to))
+			{
+				if(promote < ROOK || promote > QUEEN)
+					return 0;
+				flags = promote;
+			}
+			else if(to - from == 32 || from - to == 32)
+				flags = ENG_MF_DOUBLEPUSH;
+			else if(ENG_FILE(to) != ENG_FILE(from) && NONE == (geBoard[to] & PIECE_DATA))
+				flags = ENG_MF_ENPASSANT;
+		}
+		else if(KING == (piece & PIECE_DATA))
+		{
+			if(to == from + 2)
+				flags = ENG_MF_CASTLE_K;
+			else if(from == to + 2)
+				flags = ENG_MF_CASTLE_Q;
+		}
+
+		move->m_from = from;
+		move->m_to = to;
+		move->m_flags = flags;
+		move->m_score = 0;
+		return 1;
+	}
+#endif
+
 	count = eng_GenMovesFrom(from, (piece & PIECE_WHITE) >> 7, moves, MAX_PIECE_MOVES + 4);
 
 	for(i = 0; i < count; ++i)
@@ -205,6 +486,9 @@ char board_ApplyMove(const t_engMove *move, char side)
 	char outcome, other = 1 - side;
 
 	eng_Make(move, &undo);
+#if PLAT_LEGAL_MAP
+	sc_mapValid = 0;
+#endif
 
 	// Check, mate and stalemate all come out of one question now: does the
 	// other side have a legal move, and is it in check
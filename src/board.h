@@ -17,6 +17,7 @@
 #define _BOARD_H_
 
 #include "engine.h"
+#include "plat.h"
 
 /*-----------------------------------------------------------------------*/
 // Destination tiles for the piece the cursor is on, as 0..63
@@ -30,11 +31,28 @@ void board_Init(void);
 // the board display is switched on.  Called after anything that moves a piece
 void board_SyncDisplay(void);
 
+// Draw the tiles that look different since this was last called - the
+// pieces that moved, and with the B display on every count that changed.
+// What a move, an undo or the display toggling needs, instead of the whole
+// board.  plat_DrawBoard is still for what covered the board - the menu, the
+// promotion choice - and for a new game
+void board_DrawChanged(void);
+
 // The A and D displays ask for this directly, so it is not folded into the
 // sync - it is only ever wanted for one tile at a time
 char board_AttackersOf(char tile, char side, char *tiles);
 
 /*-----------------------------------------------------------------------*/
+// Work out every legal move "side" has, once, at the start of its turn.  The
+// three calls below answer from it for that side's pieces until a move is
+// made, and generate moves themselves for anything else, as they always did.
+// Without PLAT_LEGAL_MAP there is no map and they always generate
+#if PLAT_LEGAL_MAP
+void board_LegalMap(char side);
+#else
+#define board_LegalMap(side)
+#endif
+
 // Fill gMoveTiles with every legal destination for the piece on "tile"
 void board_LegalMovesFrom(char tile);
 
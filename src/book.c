@@ -0,0 +1,115 @@
+/*
+ *	book.c
+ *	cc65 Chess
+ *
+ *	See book.h.  The lookup is a binary search over a const array, so a book
+ *	of a thousand lines costs ten key compares a move and nothing in RAM on a
+ *	port that links its data into ROM-like CODE/RODATA.
+ */
+
+#include "types.h"
+#include "engine.h"
+#include "search.h"
+#include "book.h"
+
+#if BOOK_ON
+
+#include "bookdata.h"
+
+const unsigned int gcBookEntries = sizeof(gcBook) / sizeof(gcBook[0]);
+
+/*-----------------------------------------------------------------------*/
+unsigned int book_Key(char side)
+{
+	unsigned int key = eng_PositionKey();
+
+	return (SIDE_BLACK == side) ? key ^ BOOK_SIDE_KEY : key;
+}
+
+/*-----------------------------------------------------------------------*/
+// The same rule as cpu_MatchMove: the book names a move, the generator says
+// whether it exists.  A 16 bit key can collide, and a collision must cost a
+// search rather than put an illegal move on the board, so the entry is made
+// and checked too.  One piece's moves at a time keeps the list on the stack
+// inside cc65's 256 bytes - a queen has 27 at most
+static char bookMatch(char side, const t_bookEntry *entry, t_engMove *move)
+{
+	t_engMove moves[28];
+	t_engUndo undo;
+	char from = ENG_FROM_TILE(entry->m_from);
+	char to = ENG_FROM_TILE(entry->m_to & BOOK_TILE_MASK);
+	char promo = entry->m_to >> BOOK_PROMO_SHIFT;
+	char count, i, legal;
+
+	if(NONE == (geBoard[from] & PIECE_DATA) ||
+	   (SIDE_WHITE == side) != !!(geBoard[from] & PIECE_WHITE))
+		return 0;
+
+	count = eng_GenMovesFrom(from, side, moves, sizeof(moves) / sizeof(moves[0]));
+	for(i = 0; i < count; ++i)
+	{
+		char mp = moves[i].m_flags & ENG_MF_PROMO;
+
+		if(moves[i].m_to != to || (mp && mp != promo + 1))
+			continue;
+
+		{
+#if ENGINE_FAST_LEGAL
+			char wasInCheck = eng_InCheck(side);
+#endif
+
+			eng_HistoryEnable(0);
+			eng_Make(&moves[i], &undo);
+			legal = !eng_LeavesInCheck(side, &moves[i], wasInCheck);
+			eng_Unmake(&moves[i], &undo);
+			eng_HistoryEnable(1);
+		}
+
+		if(!legal)
+			return 0;
+		*move = moves[i];
+		return 1;
+	}
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+char book_Probe(char side, t_engMove *move)
+{
+	unsigned int key = book_Key(side);
+	unsigned int lo = 0, hi = gcBookEntries, mid, end, total, roll;
+
+	// the first entry with this key, if there is one
+	while(lo < hi)
+	{
+		mid = (lo + hi) >> 1;
+		if(gcBook[mid].m_key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	total = 0;
+	for(end = lo; end < gcBookEntries && gcBook[end].m_key == key; ++end)
+		total += (unsigned char)gcBook[end].m_weight;
+	if(!total)
+		return 0;
+
+	// Sixteen bits of roll, because a position's weights can add up past 255.
+	// Not masked like cpu.c's roll: the total is whatever the book says, and a
+	// modulo once a move is nothing beside the search it saves
+	roll = (((unsigned int)search_Random() << 8) | (unsigned char)search_Random()) % total;
+	for(; lo < end; ++lo)
+	{
+		unsigned int weight = (unsigned char)gcBook[lo].m_weight;
+
+		if(roll < weight)
+			return bookMatch(side, &gcBook[lo], move);
+		roll -= weight;
+	}
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ *	book.h
+ *	cc65 Chess
+ *
+ *	An opening book that answers at any ply, not just the first.  The two
+ *	tables in cpu.c stay exactly as they are and are asked first; this is what
+ *	the game falls through to once they have nothing to say and before it
+ *	starts a search.
+ *
+ *	The format is a sorted array of five byte records, generated into
+ *	bookdata.h by tests/mkbook from EPD or from match PGNs, and found by
+ *	binary search on a 16 bit key.  The host keeps a Polyglot-layout file with
+ *	64 bit keys for the same lines - see tests/polybook.h - because the host can
+ *	afford a key that does not collide and a 6502 cannot.
+ */
+
+#ifndef _BOOK_H_
+#define _BOOK_H_
+
+#include "types.h"
+#include "engine.h"
+
+/*-----------------------------------------------------------------------*/
+// Off by default.  Every entry is five bytes of a machine where Atari has a
+// few hundred free, so a port opts in from its make/ports/<port>.mk with
+// -DBOOK_ON=1 once the book it would carry has been measured at the board.
+// The native suite forces it on so the lookup cannot go stale
+#ifndef BOOK_ON
+#define BOOK_ON		0
+#endif
+
+/*-----------------------------------------------------------------------*/
+// One move from one position.  m_key is eng_PositionKey with BOOK_SIDE_KEY
+// folded in when black is to move.  m_to is the 0..63 tile in the low six
+// bits and the promotion piece less one in the top two, so a book can name an
+// under-promotion; m_weight is relative to the other moves with the same key
+typedef struct tag_bookEntry
+{
+	unsigned int	m_key;
+	char			m_from;
+	char			m_to;
+	char			m_weight;
+} t_bookEntry;
+
+#define BOOK_TILE_MASK		0x3F
+#define BOOK_PROMO_SHIFT	6
+
+// The side to move, which eng_PositionKey leaves out.  Any constant that is
+// not a difference of two keys in the book would do; this one is not
+#define BOOK_SIDE_KEY		0x6A09
+
+#if BOOK_ON
+/*-----------------------------------------------------------------------*/
+// The key of the position on the board with "side" to move
+unsigned int book_Key(char side);
+
+// Pick one of the book's moves for the position on the board, weighted, with
+// search_Random rolling the pick.  Returns 0 when the position is not in the
+// book or no entry for it names a legal move.  Callers only ask once the game
+// is seeded, like the tables, so the harnesses never see a book move
+char book_Probe(char side, t_engMove *move);
+
+// The book itself, for the builder and the tests
+extern const t_bookEntry gcBook[];
+extern const unsigned int gcBookEntries;
+#endif
+
+#endif //_BOOK_H_
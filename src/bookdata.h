@@ -0,0 +1,27 @@
+/*
+ *	bookdata.h
+ *	cc65 Chess
+ *
+ *	Generated by tests/mkbook - do not edit.  Rebuild with
+ *	  ./mkbook -c ../src/bookdata.h bookseed.epd
+ *
+ *	14 entries.  Sorted by key for book.c's binary search.
+ */
+
+const t_bookEntry gcBook[] =
+{
+	{ 0x192A, 62,  45, 255 },	// g1f3
+	{ 0x192A, 50,  34, 255 },	// c2c4
+	{ 0x192A, 51,  35, 255 },	// d2d4
+	{ 0x192A, 52,  36, 255 },	// e2e4
+	{ 0x19F6, 11,  27, 255 },	// d7d5
+	{ 0x19F6,  6,  21, 255 },	// g8f6
+	{ 0x3A6A, 11,  27, 255 },	// d7d5
+	{ 0x3A6A, 12,  28, 255 },	// e7e5
+	{ 0x481C, 12,  28, 255 },	// e7e5
+	{ 0x481C,  6,  21, 255 },	// g8f6
+	{ 0x4849, 11,  27, 255 },	// d7d5
+	{ 0x4849,  6,  21, 255 },	// g8f6
+	{ 0xF422, 11,  27, 255 },	// d7d5
+	{ 0xF422, 12,  28, 255 },	// e7e5
+};
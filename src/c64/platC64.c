@@ -518,6 +518,10 @@ int plat_ReadKeys(char blocking)
 		case 85:
 			keyMask |= INPUT_UNDO;
 		break;
+
+		case 72:		// 'h' - Hint
+			keyMask |= INPUT_HINT;
+		break;
 		
 		// default:		// Debug - show key code
 		// {
@@ -18,6 +18,8 @@
  *	the measurement says so.  Black's exists because a deterministic engine with
  *	one reply plays one game, and a study that thought it had thirty-two black
  *	games against Sargon II had five.
+ *
+ *	A port built with BOOK_ON asks src/book.c next, at any ply - see book.h.
  */
 
 #include "types.h"
@@ -27,8 +29,12 @@
 #include "board.h"
 #include "undo.h"
 #include "cpu.h"
+#include "book.h"
 #include "frontend.h"
 #include "plat.h"
+#if SEARCH_RECALIBRATE
+#include <time.h>
+#endif
 
 /*-----------------------------------------------------------------------*/
 // The opening move, when the engine has White and the board is untouched.
@@ -195,7 +201,7 @@ char cpu_BookMove(char side, char ply, char wFrom, char wTo, t_engMove *move)
 char cpu_Play(char side)
 {
 	t_searchResult result;
-	char outcome, from, to, ply = 0;
+	char outcome, ply = 0;
 
 	// The tables answer two questions: what to play as White into an untouched
 	// board, and how to answer White's first move as Black.  Anything else - a
@@ -220,12 +226,44 @@ char cpu_Play(char side)
 	{
 		result.m_haveMove = 1;
 	}
+#if BOOK_ON
+	// Past the tables, or where they have no entry, the book - at any ply, and
+	// under the same rule that only a seeded game ever consults it
+	else if(search_Seeded() && book_Probe(side, &result.m_move))
+	{
+		result.m_haveMove = 1;
+	}
+#endif
 	else
 	{
+		char depth = gcSearchSkill[SEARCH_NUM_SKILLS - 1].m_depth;
+		unsigned int nodes;
+#if SEARCH_RECALIBRATE
+		clock_t start;
+#endif
+
+		// a timed level's budget is worked out now, from the rate as it
+		// stands, so the last move's timing is already in it
+#if SEARCH_NUM_TIMED
+		if(gSkillLevel >= SEARCH_NUM_SKILLS)
+			nodes = search_TimedBudget(gcSearchSeconds[gSkillLevel - SEARCH_NUM_SKILLS]);
+		else
+#endif
+		{
+			depth = gcSearchSkill[gSkillLevel].m_depth;
+			nodes = gcSearchSkill[gSkillLevel].m_nodes;
+		}
+
 		plat_ShowMessage(gszThinking, HCOLOR_VALID);
 
-		search_Best(side, gcSearchSkill[gSkillLevel].m_depth,
-		            gcSearchSkill[gSkillLevel].m_nodes, &result);
+#if SEARCH_RECALIBRATE
+		start = clock();
+#endif
+		search_Best(side, depth, nodes, &result);
+#if SEARCH_RECALIBRATE
+		if(!search_Interrupted())
+			search_Calibrate(result.m_nodes, clock() - start);
+#endif
 
 		plat_ClearMessage();
 		if(search_Interrupted())
@@ -236,18 +274,11 @@ char cpu_Play(char side)
 	if(!result.m_haveMove)
 		return search_Outcome(side);
 
-	from = ENG_TO_TILE(result.m_move.m_from);
-	to = ENG_TO_TILE(result.m_move.m_to);
-
 	outcome = board_ApplyMove(&result.m_move, side);
 
-	plat_DrawSquare(from);
-	plat_DrawSquare(to);
-
-	// castling moves a rook too, and en passant clears a third tile, so the
-	// whole rank the move touched gets redrawn rather than tracking squares
-	if(result.m_move.m_flags & (ENG_MF_CASTLE | ENG_MF_ENPASSANT))
-		plat_DrawBoard(0);
+	// the two tiles, the rook castling moves too, the pawn en passant takes,
+	// and with B on every count the move changed
+	board_DrawChanged();
 
 	frontend_LogMove(0);
 
@@ -441,6 +441,11 @@ void plat_DrawSquare(char position)
 		plat_showPiece(!blackWhite, 1 + x * BOARD_PIECE_WIDTH, y * BOARD_PIECE_HEIGHT + 1, gfxTiles[piece-1][index]);
 	}
 
+	// The numbers are on the text layer, which the fill above does not touch.
+	// Wipe this tile's cells so B going off, or a count losing a digit, does
+	// not leave the old ones behind now that a move redraws only its tiles
+	clearTextLayer(1 + x * BOARD_PIECE_WIDTH, 1 + y * BOARD_PIECE_HEIGHT, BOARD_PIECE_WIDTH, BOARD_PIECE_HEIGHT);
+
 	// Show the attack numbers
 	if(gShowAttackBoard)
 	{
@@ -451,9 +456,11 @@ void plat_DrawSquare(char position)
 		sprintf(textStr, "%d",(gpAttackBoard[giAttackBoardOffset[position][0]]));
 		plat_showStrXY(COLOR_WHITE, COLOR_GREEN, 1+x*BOARD_PIECE_WIDTH,(y+1)*BOARD_PIECE_HEIGHT, textStr);
 
-		// Defenders (bottom right)
-		sprintf(textStr, "%d",(gpAttackBoard[giAttackBoardOffset[position][1]]));
-		plat_showStrXY(COLOR_WHITE, COLOR_GREEN, 1+x*BOARD_PIECE_WIDTH+3,(y+1)*BOARD_PIECE_HEIGHT, textStr);
+		// Defenders (bottom right).  A second digit goes on the left, so it
+		// stays on this tile rather than landing on the next one's cells
+		index = gpAttackBoard[giAttackBoardOffset[position][1]];
+		sprintf(textStr, "%d",index);
+		plat_showStrXY(COLOR_WHITE, COLOR_GREEN, 1+x*BOARD_PIECE_WIDTH+(index > 9 ? 2 : 3),(y+1)*BOARD_PIECE_HEIGHT, textStr);
 		
 		// Color (0 is black, 128 is white) and piece value (1=ROOK, 2=KNIGHT, 3=BISHOP, 4=QUEEN, 5=KING, 6=PAWN)
 		sprintf(textStr, "%0d",piece_value);
@@ -614,6 +621,10 @@ int plat_ReadKeys(char blocking)
 		case 85:
 			keyMask |= INPUT_UNDO;
 		break;
+
+		case 72:		// 'h' - Hint
+			keyMask |= INPUT_HINT;
+		break;
 		
 		default:		// Debug - show key code
 		// {
@@ -642,6 +653,37 @@ char plat_GetSeed()
 	return seed;
 }
 
+#if PLAT_BANKS
+/*-----------------------------------------------------------------------*/
+// Banked RAM: the bank register is $00 and the window is $A000-$BFFF.  Bank
+// 0 is the KERNAL's, and the GRAPH and FB calls expect to find it there, so
+// the table's bank b is hardware bank b + 1 and it is only mapped in for the
+// length of one copy.  Selecting is remembering
+static char sc_bank;
+
+/*-----------------------------------------------------------------------*/
+void plat_BankSelect(char bank)
+{
+	sc_bank = bank + 1;
+}
+
+/*-----------------------------------------------------------------------*/
+void plat_BankRead(unsigned int offset, void *dst, char size)
+{
+	*(char *)0x00 = sc_bank;
+	memcpy(dst, (char *)0xA000 + offset, size);
+	*(char *)0x00 = 0;
+}
+
+/*-----------------------------------------------------------------------*/
+void plat_BankWrite(unsigned int offset, const void *src, char size)
+{
+	*(char *)0x00 = sc_bank;
+	memcpy((char *)0xA000 + offset, src, size);
+	*(char *)0x00 = 0;
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Only gets called if gReturnToOS is true, which it isn't
 void plat_Shutdown()
@@ -25,11 +25,16 @@
 
 /*-----------------------------------------------------------------------*/
 char geBoard[128];
+#if !ENGINE_ZP
 char geCastle;
 char geEP;
 char geHalfmove;
 char geKing[2];
 unsigned int geHashKey;
+#endif
+#if EVAL_PAWN_HASH
+unsigned long gePawnKey[2];
+#endif
 
 /*-----------------------------------------------------------------------*/
 // Position history, for repetition detection.  A ring rather than a stack
@@ -201,8 +206,16 @@ static const signed char sc_diagonal[4]   = { -17, -15, 15, 17 };
 static const signed char sc_knight[8]     = { -33, -31, -18, -14, 14, 18, 31, 33 };
 static const signed char sc_king[8]       = { -17, -16, -15, -1, 1, 15, 16, 17 };
 
+// The kernels in engine65.s and spectrum/engineZ80.asm read the generator's
+// two statics, so with ENGINE_ASM they lose the static
+#if ENGINE_ASM
+#define ASM_SHARED
+#else
+#define ASM_SHARED	static
+#endif
+
 // How many moves the current caller has room for
-static char sc_maxMoves;
+ASM_SHARED char sc_maxMoves;
 
 // Set for the duration of one eng_GenCaptures call.  The generators are shared
 // rather than duplicated: a captures-only pass walks exactly the same squares
@@ -210,12 +223,14 @@ static char sc_maxMoves;
 // comes out is a true subsequence of the full list.  That is what lets
 // quiescence switch generators without changing a single move it searches -
 // and it is worth more than the handful of bytes a second generator would cost
-static char sc_capturesOnly;
+ASM_SHARED char sc_capturesOnly;
 
 // Squares that matter for castling rights, per side
 static const char sc_kingHome[2] = { 0x04, 0x74 };	// e8, e1
+#if !ENGINE_ASM
 static const char sc_rookK[2]    = { 0x07, 0x77 };	// h8, h1
 static const char sc_rookQ[2]    = { 0x00, 0x70 };	// a8, a1
+#endif
 
 /*-----------------------------------------------------------------------*/
 void eng_Clear(void)
@@ -264,6 +279,7 @@ void eng_SetStartPosition(void)
 // Walks out from "square" looking for anything of bySide that hits it.  Note
 // the pawn test runs backwards: a white pawn on p attacks p-17 and p-15, so a
 // white pawn attacking "square" has to be sitting on square+17 or square+15
+#if !ENGINE_ASM
 char eng_IsAttacked(char square, char bySide)
 {
 	char i, sq, piece;
@@ -325,6 +341,7 @@ char eng_IsAttacked(char square, char bySide)
 
 	return 0;
 }
+#endif
 
 /*-----------------------------------------------------------------------*/
 // Same walk, but collecting instead of stopping at the first hit
@@ -535,6 +552,11 @@ static char genStepper(char from, char side, const signed char *steps,
 }
 
 /*-----------------------------------------------------------------------*/
+#if ENGINE_ASM
+char eng_GenSlider(char from, char side, const signed char *steps, char numSteps,
+                   t_engMove *moves, char count);
+#define genSlider	eng_GenSlider
+#else
 static char genSlider(char from, char side, const signed char *steps, char numSteps,
                       t_engMove *moves, char count)
 {
@@ -559,6 +581,7 @@ static char genSlider(char from, char side, const signed char *steps, char numSt
 	}
 	return count;
 }
+#endif
 
 /*-----------------------------------------------------------------------*/
 // Castling is generated only when it is legal all the way through: rights
@@ -862,6 +885,12 @@ static unsigned int positionKey(void)
 	return key;
 }
 
+/*-----------------------------------------------------------------------*/
+unsigned int eng_PositionKey(void)
+{
+	return positionKey();
+}
+
 /*-----------------------------------------------------------------------*/
 // What "move" does to geHashKey.  Deliberately the same shape as
 // eval_MoveDelta, case for case - mover, promotion, the en passant victim
@@ -901,6 +930,64 @@ static unsigned int hashDelta(const t_engMove *move, char piece, char captured)
 	return delta;
 }
 
+#if EVAL_PAWN_HASH
+/*-----------------------------------------------------------------------*/
+// One pawn on a file, in gePawnKey's three-bit field for that file
+static const unsigned long sc_pawnFile[8] =
+{
+	0x000001UL, 0x000008UL, 0x000040UL, 0x000200UL,
+	0x001000UL, 0x008000UL, 0x040000UL, 0x200000UL,
+};
+
+/*-----------------------------------------------------------------------*/
+// What "move" does to gePawnKey: the pawn that left its file, the pawn that
+// arrived unless it promoted, and a pawn taken, which always stood on the
+// file of "to", en passant included.  A sum of counts rather than an XOR, so
+// eng_Unmake passes "undo" to take back exactly what eng_Make added
+static void pawnKeyMove(const t_engMove *move, char piece, char captured, char undo)
+{
+	char side = (piece & PIECE_WHITE) ? SIDE_WHITE : SIDE_BLACK;
+	unsigned long own = 0, taken = 0;
+
+	if(PAWN == (piece & PIECE_DATA))
+	{
+		if(!(move->m_flags & ENG_MF_PROMO))
+			own = sc_pawnFile[move->m_to & 7];
+		own -= sc_pawnFile[move->m_from & 7];
+	}
+
+	if(PAWN == (captured & PIECE_DATA))
+		taken = sc_pawnFile[move->m_to & 7];
+
+	if(undo)
+	{
+		gePawnKey[side] -= own;
+		gePawnKey[1 - side] += taken;
+	}
+	else
+	{
+		gePawnKey[side] += own;
+		gePawnKey[1 - side] -= taken;
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+void eng_PawnKeyOfBoard(unsigned long *key)
+{
+	char sq;
+
+	key[SIDE_BLACK] = key[SIDE_WHITE] = 0;
+	for(sq = 0; sq < 0x78; ++sq)
+	{
+		char piece = geBoard[sq];
+
+		if(ENG_OFFBOARD(sq) || PAWN != (piece & PIECE_DATA))
+			continue;
+		key[(piece & PIECE_WHITE) ? SIDE_WHITE : SIDE_BLACK] += sc_pawnFile[sq & 7];
+	}
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 unsigned int eng_HashOfBoard(void)
 {
@@ -984,8 +1071,30 @@ unsigned int eng_HistoryStateDigest(void)
 	}
 	return digest;
 }
+
+/*-----------------------------------------------------------------------*/
+char eng_TestSlider(char from, char diagonal, char capturesOnly, char maxMoves,
+                    t_engMove *moves, char count)
+{
+	sc_maxMoves = maxMoves;
+	sc_capturesOnly = capturesOnly;
+	count = genSlider(from, COLOR_OF(geBoard[from]),
+	                  diagonal ? sc_diagonal : sc_orthogonal, 4, moves, count);
+	sc_capturesOnly = 0;
+	return count;
+}
 #endif
 
+#if ENGINE_ASM
+// The board half of eng_Make and eng_Unmake, in engine65.s or
+// spectrum/engineZ80.asm: the pieces, the rights, the en passant square and
+// the counters.  Both return the piece that moved as it stood before the
+// move, which is what the evaluation and the key are adjusted by.  Without
+// ENGINE_ASM the same code is inline below, where it saves the 6502 a call
+// on every make and unmake
+char eng_MakeBoard(const t_engMove *move, t_engUndo *undo);
+char eng_UnmakeBoard(const t_engMove *move, const t_engUndo *undo);
+#else
 /*-----------------------------------------------------------------------*/
 // Losing a right when a rook leaves, or is taken on, its home square
 static void revokeRights(char square)
@@ -995,6 +1104,7 @@ static void revokeRights(char square)
 	else if(square == sc_rookK[SIDE_BLACK]) geCastle &= ~ENG_CASTLE_BK;
 	else if(square == sc_rookQ[SIDE_BLACK]) geCastle &= ~ENG_CASTLE_BQ;
 }
+#endif
 
 /*-----------------------------------------------------------------------*/
 void eng_HistoryEnable(char enabled)
@@ -1011,6 +1121,9 @@ void eng_RestoreEnable(char enabled)
 /*-----------------------------------------------------------------------*/
 void eng_Make(const t_engMove *move, t_engUndo *undo)
 {
+#if ENGINE_ASM
+	char piece = eng_MakeBoard(move, undo);
+#else
 	char from = move->m_from, to = move->m_to, flags = move->m_flags;
 	char piece = geBoard[from];
 	char side = COLOR_OF(piece);
@@ -1067,6 +1180,7 @@ void eng_Make(const t_engMove *move, t_engUndo *undo)
 	}
 	else if(ROOK == (piece & PIECE_DATA))
 		revokeRights(from);
+#endif
 
 #ifdef SEARCH_PROFILE
 	if(!sc_profileBoardOnly)
@@ -1079,6 +1193,9 @@ void eng_Make(const t_engMove *move, t_engUndo *undo)
 			su_profileSink = eval_PhaseDelta(move, piece, undo->m_captured);
 		if(PROFILE_EVAL_END == geSearchProfile)
 			su_profileSink = eval_EndDelta(move, piece, undo->m_captured);
+		PROFILE_COUNT(PROFILE_EVAL_MOVE, 1);
+		PROFILE_COUNT(PROFILE_EVAL_PHASE, 1);
+		PROFILE_COUNT(PROFILE_EVAL_END, 1);
 #endif
 
 		// keep the running evaluation with the pieces.  eng_Unmake subtracts
@@ -1086,6 +1203,9 @@ void eng_Make(const t_engMove *move, t_engUndo *undo)
 		geEvalScore += eval_MoveDelta(move, piece, undo->m_captured);
 		gePhase += eval_PhaseDelta(move, piece, undo->m_captured);
 		geEvalEnd += eval_EndDelta(move, piece, undo->m_captured);
+#if EVAL_PAWN_HASH
+		pawnKeyMove(move, piece, undo->m_captured, 0);
+#endif
 	}
 
 	if(sc_historyEnabled)
@@ -1093,6 +1213,7 @@ void eng_Make(const t_engMove *move, t_engUndo *undo)
 #ifdef SEARCH_PROFILE
 		if(PROFILE_HASH_DELTA == geSearchProfile)
 			su_profileSink = hashDelta(move, piece, undo->m_captured);
+		PROFILE_COUNT(PROFILE_HASH_DELTA, 1);
 #endif
 		geHashKey ^= hashDelta(move, piece, undo->m_captured);
 
@@ -1104,6 +1225,7 @@ void eng_Make(const t_engMove *move, t_engUndo *undo)
 			su_profileSink = positionKey();
 			su_hashRing[sc_hashTop & HASH_MASK] = su_profileSink;
 		}
+		PROFILE_COUNT(PROFILE_HISTORY, 1);
 #endif
 		su_hashRing[sc_hashTop & HASH_MASK] = positionKey();
 		++sc_hashTop;
@@ -1115,6 +1237,9 @@ void eng_Make(const t_engMove *move, t_engUndo *undo)
 /*-----------------------------------------------------------------------*/
 void eng_Unmake(const t_engMove *move, const t_engUndo *undo)
 {
+#if ENGINE_ASM
+	char moved = eng_UnmakeBoard(move, undo);
+#else
 	char from = move->m_from, to = move->m_to, flags = move->m_flags;
 	char piece = geBoard[to];
 	char side = COLOR_OF(piece);
@@ -1153,6 +1278,7 @@ void eng_Unmake(const t_engMove *move, const t_engUndo *undo)
 			geBoard[to+1] = NONE;
 		}
 	}
+#endif
 
 #ifdef SEARCH_PROFILE
 	if(!sc_profileBoardOnly && !sc_restoreEnabled)
@@ -1167,11 +1293,17 @@ void eng_Unmake(const t_engMove *move, const t_engUndo *undo)
 			su_profileSink = eval_PhaseDelta(move, moved, undo->m_captured);
 		if(PROFILE_EVAL_END == geSearchProfile)
 			su_profileSink = eval_EndDelta(move, moved, undo->m_captured);
+		PROFILE_COUNT(PROFILE_EVAL_MOVE, 1);
+		PROFILE_COUNT(PROFILE_EVAL_PHASE, 1);
+		PROFILE_COUNT(PROFILE_EVAL_END, 1);
 #endif
 
 		geEvalScore -= eval_MoveDelta(move, moved, undo->m_captured);
 		gePhase -= eval_PhaseDelta(move, moved, undo->m_captured);
 		geEvalEnd -= eval_EndDelta(move, moved, undo->m_captured);
+#if EVAL_PAWN_HASH
+		pawnKeyMove(move, moved, undo->m_captured, 1);
+#endif
 	}
 
 	if(sc_historyEnabled)
@@ -1179,6 +1311,8 @@ void eng_Unmake(const t_engMove *move, const t_engUndo *undo)
 #ifdef SEARCH_PROFILE
 		if(!sc_restoreEnabled && PROFILE_HASH_DELTA == geSearchProfile)
 			su_profileSink = hashDelta(move, moved, undo->m_captured);
+		if(!sc_restoreEnabled)
+			PROFILE_COUNT(PROFILE_HASH_DELTA, 1);
 #endif
 		if(!sc_restoreEnabled)
 			geHashKey ^= hashDelta(move, moved, undo->m_captured);
@@ -106,6 +106,33 @@ extern unsigned int geHashKey;
 #define ENGINE_DEDICATED_CAPTURES	0
 #endif
 
+// 6502 kernels (engine65.s) for eng_IsAttacked, the slider walk and the board
+// half of eng_Make / eng_Unmake, and the Z80 equivalents in
+// spectrum/engineZ80.asm.  The C stays the reference: the native suite runs
+// it, and c64perft / c64search / zxsearch have to give the same counts either
+// way.  On cc65 the assembler needs the switch too - --asm-define
+// ENGINE_ASM=1 - or the file assembles to nothing
+#ifndef ENGINE_ASM
+#define ENGINE_ASM	0
+#endif
+
+// The hot engine, eval and search scalars in zero page (enginezp.s), on a
+// port whose chess*.cfg places the ENGZP segment.  Like ENGINE_ASM it goes to
+// the assembler as well: --asm-define ENGINE_ZP=1.  Scalars only, so far: the
+// move-list pointers into the search's arena are still cc65 locals, and no
+// c64profile figure has priced any of it yet
+#ifndef ENGINE_ZP
+#define ENGINE_ZP	0
+#endif
+
+#if ENGINE_ZP
+#pragma zpsym ("geCastle")
+#pragma zpsym ("geEP")
+#pragma zpsym ("geHalfmove")
+#pragma zpsym ("geKing")
+#pragma zpsym ("geHashKey")
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Rebuild geHashKey from the board and start the position history again with
 // the position as it now stands.  Anything that puts pieces down without
@@ -121,6 +148,13 @@ void eng_HashReset(void);
 // evaluation - a wrong delta is silent otherwise
 unsigned int eng_HashOfBoard(void);
 
+/*-----------------------------------------------------------------------*/
+// The position key the history ring stores: geHashKey with the castling
+// rights and en passant file folded in.  Not the side to move - the ring
+// never compares positions an odd number of plies apart.  The opening book
+// keys on this, plus its own side bit
+unsigned int eng_PositionKey(void);
+
 /*-----------------------------------------------------------------------*/
 // Has the position on the board been seen "needed" times before?  1 is what
 // the search asks: inside a search line, one repeat already means neither
@@ -136,6 +170,11 @@ char eng_IsRepetition(char needed);
 // Native-test view of the invariant used by ENGINE_REPETITION_RING_KEY.
 char eng_HistoryMatchesPosition(void);
 unsigned int eng_HistoryStateDigest(void);
+// The slider walk on its own, for tests/kernelrec.c to record what the
+// assembly kernels have to reproduce: the piece on "from" along the rook
+// rays, or the bishop ones if "diagonal", into moves from "count" on
+char eng_TestSlider(char from, char diagonal, char capturesOnly, char maxMoves,
+                    t_engMove *moves, char count);
 #endif
 
 /*-----------------------------------------------------------------------*/
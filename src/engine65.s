@@ -0,0 +1,611 @@
+;
+;	engine65.s
+;	cc65 Chess
+;
+;	6502 kernels for the three hottest things the engine does: the attack
+;	walk (eng_IsAttacked), the slider generator (eng_GenSlider) and the
+;	board half of make / unmake (eng_MakeBoard / eng_UnmakeBoard).  The C in
+;	engine.c is the reference and these have to agree with it exactly - same
+;	moves in the same order, same board, same undo record - which c64perft
+;	and c64search check on the target by giving the same counts with and
+;	without them, and tests/kernelreplay.py checks on the host against
+;	every call a walk of the perft positions makes.
+;
+;	cc65 assembles every src/*.s for every port, so the whole file is behind
+;	ENGINE_ASM and costs nothing where it is not asked for.  A port that wants
+;	it sets both halves of the switch:
+;	  <port>_CFLAGS  := -DENGINE_ASM=1
+;	  <port>_ASFLAGS := --asm-define ENGINE_ASM=1
+;
+;	What the C pays for and this does not: the software stack for every local,
+;	and chars promoted to ints for every square sum.  Arguments are popped
+;	once into zero page and the walks run in A, X and Y
+;
+
+.ifndef ENGINE_ASM
+ENGINE_ASM = 0
+.endif
+
+.if ENGINE_ASM
+
+.importzp ptr1, ptr2, ptr3, ptr4, tmp1, tmp2, tmp3, tmp4, sreg
+.import popa, popax
+.import _geBoard
+.import _sc_maxMoves, _sc_capturesOnly
+.ifndef ENGINE_ZP
+ENGINE_ZP = 0
+.endif
+.if ENGINE_ZP
+.importzp _geCastle, _geEP, _geHalfmove, _geKing        ; enginezp.s
+.else
+.import _geCastle, _geEP, _geHalfmove, _geKing
+.endif
+
+.export _eng_IsAttacked, _eng_GenSlider, _eng_MakeBoard, _eng_UnmakeBoard
+
+; ----------------------------------------------------------------------
+; types.h / engine.h, which ca65 cannot read
+NONE            = 0
+ROOK            = 1
+KNIGHT          = 2
+BISHOP          = 3
+QUEEN           = 4
+KING            = 5
+PAWN            = 6
+PIECE_WHITE     = $80
+PIECE_DATA      = $07
+
+ENG_NO_SQUARE   = $7F
+ENG_CASTLE_WK   = $01
+ENG_CASTLE_WQ   = $02
+ENG_CASTLE_BK   = $04
+ENG_CASTLE_BQ   = $08
+
+ENG_MF_PROMO      = $07
+ENG_MF_ENPASSANT  = $08
+ENG_MF_CASTLE_K   = $10
+ENG_MF_CASTLE_Q   = $20
+ENG_MF_DOUBLEPUSH = $40
+
+; t_engMove and t_engUndo offsets
+M_FROM          = 0
+M_TO            = 1
+M_FLAGS         = 2
+M_SCORE         = 3
+U_CAPTURED      = 0
+U_EP            = 1
+U_CASTLE        = 2
+U_HALFMOVE      = 3
+
+; ======================================================================
+.segment "RODATA"
+
+knightSteps:    .byte   $DF, $E1, $EE, $F2, $0E, $12, $1F, $21
+kingSteps:      .byte   $EF, $F0, $F1, $FF, $01, $0F, $10, $11
+
+; orthogonal first, then diagonal - rayCheck tells them apart by index
+raySteps:       .byte   $F0, $10, $FF, $01
+                .byte   $EF, $F1, $0F, $11
+
+; a rook's home square and the right it takes with it
+rookHome:       .byte   $77, $70, $07, $00
+rookKeeps:      .byte   <~ENG_CASTLE_WK, <~ENG_CASTLE_WQ
+                .byte   <~ENG_CASTLE_BK, <~ENG_CASTLE_BQ
+
+; ======================================================================
+.segment "CODE"
+
+; ----------------------------------------------------------------------
+; char eng_IsAttacked(char square, char bySide)
+;
+; tmp1 square, tmp2 the attacker's colour bit, tmp3 the piece byte a
+; stepper test wants, tmp4 the ray step.  The C asks in a fixed order but
+; only for a yes or a no, so the stepper tables are walked backwards here
+.proc _eng_IsAttacked
+
+        tax
+        beq     :+
+        lda     #PIECE_WHITE
+:       sta     tmp2
+        jsr     popa
+        sta     tmp1
+
+        ; pawns.  A white pawn attacking the square sits below it, on +15
+        ; and +17; a black one above, on -17 and -15
+        lda     #PAWN
+        ora     tmp2
+        sta     tmp3
+        lda     tmp2
+        beq     blackPawns
+        lda     #$0F
+        jsr     probe
+        beq     yes
+        lda     #$11
+        bne     lastPawn
+blackPawns:
+        lda     #$EF
+        jsr     probe
+        beq     yes
+        lda     #$F1
+lastPawn:
+        jsr     probe
+        beq     yes
+
+        ; knights
+        lda     #KNIGHT
+        ora     tmp2
+        sta     tmp3
+        ldy     #7
+knights:
+        lda     knightSteps,y
+        jsr     probe
+        beq     yes
+        dey
+        bpl     knights
+
+        ; king
+        lda     #KING
+        ora     tmp2
+        sta     tmp3
+        ldy     #7
+kings:
+        lda     kingSteps,y
+        jsr     probe
+        beq     yes
+        dey
+        bpl     kings
+
+        ; rook, bishop and queen along the rays.  Y 7..4 are the diagonals
+        ldy     #7
+rays:
+        lda     raySteps,y
+        sta     tmp4
+        lda     tmp1
+step:
+        clc
+        adc     tmp4
+        tax
+        and     #$88
+        bne     nextRay
+        lda     _geBoard,x
+        and     #PIECE_DATA
+        bne     blocker
+        txa
+        jmp     step
+blocker:
+        cmp     #QUEEN
+        beq     colour
+        cpy     #4
+        bcs     diagonal
+        cmp     #ROOK
+        bne     nextRay
+        beq     colour
+diagonal:
+        cmp     #BISHOP
+        bne     nextRay
+colour:
+        lda     _geBoard,x
+        and     #PIECE_WHITE
+        cmp     tmp2
+        beq     yes
+nextRay:
+        dey
+        bpl     rays
+
+        lda     #0
+        tax
+        rts
+
+yes:
+        lda     #1
+        ldx     #0
+        rts
+
+; A is a step from the square; Z set when the piece in tmp3 stands there.
+; Keeps Y
+probe:
+        clc
+        adc     tmp1
+        tax
+        and     #$88
+        bne     :+
+        lda     _geBoard,x
+        and     #(PIECE_WHITE | PIECE_DATA)
+        cmp     tmp3
+:       rts
+
+.endproc
+
+; ----------------------------------------------------------------------
+; char eng_GenSlider(char from, char side, const signed char *steps, char numSteps,
+;                    t_engMove *moves, char count)
+;
+; ptr1 the next free move (moves + count * 4, so Y never has to reach past
+; 255), ptr2 steps, ptr3 the step, ptr4 the mover's colour bit, tmp1 from,
+; tmp2 the step index, tmp3 numSteps, tmp4 count
+.proc _eng_GenSlider
+
+        sta     tmp4
+        jsr     popax
+        sta     ptr1
+        stx     ptr1+1
+        jsr     popa
+        sta     tmp3
+        jsr     popax
+        sta     ptr2
+        stx     ptr2+1
+        jsr     popa
+        tax
+        beq     :+
+        lda     #PIECE_WHITE
+:       sta     ptr4
+        jsr     popa
+        sta     tmp1
+
+        ; ptr1 += count * 4
+        lda     #0
+        sta     ptr3+1
+        lda     tmp4
+        asl     a
+        rol     ptr3+1
+        asl     a
+        rol     ptr3+1
+        clc
+        adc     ptr1
+        sta     ptr1
+        lda     ptr3+1
+        adc     ptr1+1
+        sta     ptr1+1
+
+        lda     #0
+        sta     tmp2
+ray:
+        ldy     tmp2
+        cpy     tmp3
+        bcs     done
+        lda     (ptr2),y
+        sta     ptr3
+        lda     tmp1
+step:
+        clc
+        adc     ptr3
+        tax
+        and     #$88
+        bne     nextRay
+        lda     _geBoard,x
+        and     #PIECE_DATA
+        bne     blocker
+
+        ; captures-only still walks the ray to find the blocker, it just
+        ; does not write the empty squares down on the way
+        lda     _sc_capturesOnly
+        bne     :+
+        jsr     addMove
+:       txa
+        jmp     step
+
+blocker:
+        lda     _geBoard,x
+        and     #PIECE_WHITE
+        cmp     ptr4
+        beq     nextRay
+        jsr     addMove
+nextRay:
+        inc     tmp2
+        jmp     ray
+
+done:
+        lda     tmp4
+        ldx     #0
+        rts
+
+; X is the square moved to.  addMove in engine.c, bound by sc_maxMoves the
+; same way.  Keeps X
+addMove:
+        lda     tmp4
+        cmp     _sc_maxMoves
+        bcs     :+
+        ldy     #M_FROM
+        lda     tmp1
+        sta     (ptr1),y
+        iny
+        txa
+        sta     (ptr1),y
+        iny
+        lda     #0
+        sta     (ptr1),y
+        iny
+        sta     (ptr1),y
+        inc     tmp4
+        lda     ptr1
+        clc
+        adc     #4
+        sta     ptr1
+        bcc     :+
+        inc     ptr1+1
+:       rts
+
+.endproc
+
+; ----------------------------------------------------------------------
+; Shared by make and unmake, with tmp1 from, tmp2 to, tmp3 flags and tmp4
+; the piece whose colour decides which way is forward.
+
+; X = the square behind "to": the en passant victim, or the en passant
+; target after a double push
+epSquare:
+        lda     tmp4
+        bmi     :+
+        lda     tmp2
+        sec
+        sbc     #16
+        tax
+        rts
+:       lda     tmp2
+        clc
+        adc     #16
+        tax
+        rts
+
+; A = a square; a rook leaving it or taken on it loses that right
+revokeRights:
+        ldx     #3
+:       cmp     rookHome,x
+        beq     :+
+        dex
+        bpl     :-
+        rts
+:       lda     rookKeeps,x
+        and     _geCastle
+        sta     _geCastle
+        rts
+
+; X = 0 or 1, the side of the piece in tmp4
+sideOf:
+        lda     tmp4
+        asl     a
+        lda     #0
+        rol     a
+        tax
+        rts
+
+; from, to and flags out of the move in ptr1
+loadMove:
+        ldy     #M_FROM
+        lda     (ptr1),y
+        sta     tmp1
+        iny
+        lda     (ptr1),y
+        sta     tmp2
+        iny
+        lda     (ptr1),y
+        sta     tmp3
+        rts
+
+; ----------------------------------------------------------------------
+; char eng_MakeBoard(const t_engMove *move, t_engUndo *undo)
+;
+; ptr1 move, ptr2 undo.  Returns the piece that moved
+.proc _eng_MakeBoard
+
+        sta     ptr2
+        stx     ptr2+1
+        jsr     popax
+        sta     ptr1
+        stx     ptr1+1
+        jsr     loadMove
+        ldx     tmp1
+        lda     _geBoard,x
+        sta     tmp4
+
+        ldy     #U_EP
+        lda     _geEP
+        sta     (ptr2),y
+        iny
+        lda     _geCastle
+        sta     (ptr2),y
+        iny
+        lda     _geHalfmove
+        sta     (ptr2),y
+        ldy     #U_CAPTURED
+        lda     #NONE
+        sta     (ptr2),y
+
+        lda     #ENG_NO_SQUARE
+        sta     _geEP
+        inc     _geHalfmove
+
+        lda     tmp3
+        and     #ENG_MF_ENPASSANT
+        beq     notEP
+        ; the pawn taken sits beside the moving pawn, not on the target square
+        jsr     epSquare
+        lda     _geBoard,x
+        ldy     #U_CAPTURED
+        sta     (ptr2),y
+        lda     #NONE
+        sta     _geBoard,x
+        sta     _geHalfmove
+        beq     place
+
+notEP:
+        ldx     tmp2
+        lda     _geBoard,x
+        and     #PIECE_DATA
+        beq     place
+        lda     _geBoard,x
+        ldy     #U_CAPTURED
+        sta     (ptr2),y
+        txa
+        jsr     revokeRights
+        lda     #0
+        sta     _geHalfmove
+
+place:
+        lda     tmp3
+        and     #ENG_MF_PROMO
+        beq     :+
+        sta     sreg
+        lda     tmp4
+        and     #PIECE_WHITE
+        ora     sreg
+        bne     :++
+:       lda     tmp4
+:       ldx     tmp2
+        sta     _geBoard,x
+        ldx     tmp1
+        lda     #NONE
+        sta     _geBoard,x
+
+        lda     tmp4
+        and     #PIECE_DATA
+        cmp     #PAWN
+        bne     notPawn
+        lda     #0
+        sta     _geHalfmove
+        lda     tmp3
+        and     #ENG_MF_DOUBLEPUSH
+        beq     done
+        jsr     epSquare
+        stx     _geEP
+        jmp     done
+
+notPawn:
+        cmp     #KING
+        bne     notKing
+        jsr     sideOf
+        lda     tmp2
+        sta     _geKing,x
+        lda     tmp4
+        bmi     :+
+        lda     #<~(ENG_CASTLE_BK | ENG_CASTLE_BQ)
+        bne     :++
+:       lda     #<~(ENG_CASTLE_WK | ENG_CASTLE_WQ)
+:       and     _geCastle
+        sta     _geCastle
+
+        ldx     tmp2
+        lda     tmp3
+        and     #ENG_MF_CASTLE_K
+        beq     :+
+        lda     _geBoard+1,x
+        sta     _geBoard-1,x
+        lda     #NONE
+        sta     _geBoard+1,x
+        beq     done
+:       lda     tmp3
+        and     #ENG_MF_CASTLE_Q
+        beq     done
+        lda     _geBoard-2,x
+        sta     _geBoard+1,x
+        lda     #NONE
+        sta     _geBoard-2,x
+        beq     done
+
+notKing:
+        cmp     #ROOK
+        bne     done
+        lda     tmp1
+        jsr     revokeRights
+
+done:
+        lda     tmp4
+        ldx     #0
+        rts
+
+.endproc
+
+; ----------------------------------------------------------------------
+; char eng_UnmakeBoard(const t_engMove *move, const t_engUndo *undo)
+;
+; ptr1 move, ptr2 undo, sreg the piece that moved.  Returns that piece, a
+; promoted one turned back into its pawn
+.proc _eng_UnmakeBoard
+
+        sta     ptr2
+        stx     ptr2+1
+        jsr     popax
+        sta     ptr1
+        stx     ptr1+1
+        jsr     loadMove
+        ldx     tmp2
+        lda     _geBoard,x
+        sta     tmp4
+
+        lda     tmp3
+        and     #ENG_MF_PROMO
+        beq     :+
+        lda     tmp4
+        and     #PIECE_WHITE
+        ora     #PAWN
+        bne     :++
+:       lda     tmp4
+:       sta     sreg
+
+        ldy     #U_EP
+        lda     (ptr2),y
+        sta     _geEP
+        iny
+        lda     (ptr2),y
+        sta     _geCastle
+        iny
+        lda     (ptr2),y
+        sta     _geHalfmove
+
+        ldx     tmp1
+        lda     sreg
+        sta     _geBoard,x
+        ldx     tmp2
+        lda     #NONE
+        sta     _geBoard,x
+
+        ldy     #U_CAPTURED
+        lda     tmp3
+        and     #ENG_MF_ENPASSANT
+        beq     notEP
+        jsr     epSquare
+        lda     (ptr2),y
+        sta     _geBoard,x
+        jmp     king
+
+notEP:
+        lda     (ptr2),y
+        and     #PIECE_DATA
+        beq     king
+        lda     (ptr2),y
+        sta     _geBoard,x
+
+king:
+        lda     sreg
+        and     #PIECE_DATA
+        cmp     #KING
+        bne     done
+        jsr     sideOf
+        lda     tmp1
+        sta     _geKing,x
+
+        ldx     tmp2
+        lda     tmp3
+        and     #ENG_MF_CASTLE_K
+        beq     :+
+        lda     _geBoard-1,x
+        sta     _geBoard+1,x
+        lda     #NONE
+        sta     _geBoard-1,x
+        beq     done
+:       lda     tmp3
+        and     #ENG_MF_CASTLE_Q
+        beq     done
+        lda     _geBoard+1,x
+        sta     _geBoard-2,x
+        lda     #NONE
+        sta     _geBoard+1,x
+
+done:
+        lda     sreg
+        ldx     #0
+        rts
+
+.endproc
+
+.endif
@@ -0,0 +1,56 @@
+;
+;	enginezp.s
+;	cc65 Chess
+;
+;	The engine's hottest scalars, in zero page.  cc65 can only address a
+;	variable as zero page if it is told so with #pragma zpsym, and it can only
+;	put a C variable in a segment the assembler treats as absolute, so the
+;	storage is declared here instead and the C files drop their own
+;	definitions under ENGINE_ZP.  Every access is a byte shorter and a cycle
+;	quicker, and an int read or written as a pair saves two of each.
+;
+;	The board is not here.  It is 128 bytes, more than any port has free, and
+;	it is only ever indexed: "lda geBoard,x" costs the same 4 cycles from
+;	anywhere.
+;
+;	The ENGZP segment is placed by the port's chess*.cfg, which knows what is
+;	free on that machine.  A port that does not define it cannot set
+;	ENGINE_ZP.  The switch goes to the assembler as well as the compiler:
+;	  <port>_CFLAGS  := -DENGINE_ZP=1
+;	  <port>_ASFLAGS := --asm-define ENGINE_ZP=1
+;
+;	The startup code never clears zero page the way it clears BSS.  Nothing
+;	here needs it to: eng_Clear, eval_Refresh and search_Best set all of it
+;	before any of it is read.
+;
+
+.ifndef ENGINE_ZP
+ENGINE_ZP = 0
+.endif
+
+.if ENGINE_ZP
+
+.exportzp _geCastle, _geEP, _geHalfmove, _geKing, _geHashKey
+.exportzp _geEvalScore, _geEvalEnd, _gePhase
+.exportzp _si_nodes, _si_budget, _si_arenaTop
+
+.segment "ENGZP": zeropage
+
+; engine.c
+_geCastle:      .res    1
+_geEP:          .res    1
+_geHalfmove:    .res    1
+_geKing:        .res    2
+_geHashKey:     .res    2
+
+; eval.c
+_geEvalScore:   .res    2
+_geEvalEnd:     .res    2
+_gePhase:       .res    2
+
+; search.c
+_si_nodes:      .res    2
+_si_budget:     .res    2
+_si_arenaTop:   .res    2
+
+.endif
@@ -208,9 +208,11 @@ static const signed char *sc_pst[PAWN+1] =
 char geEvalTerms = EVAL_ALL;
 #endif
 
+#if !ENGINE_ZP
 int geEvalScore;
 int geEvalEnd;
 int gePhase;
+#endif
 
 #if EVAL_DEV_ON
 int geDevScore;
@@ -256,7 +258,8 @@ int gePawnStruct;
 
 #ifdef __CC65__
 int pawnStructScore(void);		/* pawnstruct.s */
-#else
+#elif !EVAL_PAWN_HASH || defined(EVAL_TUNING)
+// with the pawn hash, only the tuning build's reference paths still walk
 /*-----------------------------------------------------------------------*/
 static int pawnStructScore(void)
 {
@@ -301,6 +304,122 @@ static int pawnStructScore(void)
 	return score;
 }
 #endif
+
+#if EVAL_PAWN_HASH
+/*-----------------------------------------------------------------------*/
+// The structure score of recently seen pawn skeletons, one side at a time:
+// doubled and isolated only compare a side's pawns with its own, so each half
+// of gePawnKey is an entry of its own.  The lock is the side's whole key,
+// which is its eight file counts, so a hit is the walk's answer and never
+// another skeleton's; two skeletons sharing a slot only evict each other.
+// A zeroed table is already correct: key 0 is a side with no pawns, and that
+// scores 0
+typedef struct tag_pawnEntry
+{
+	unsigned long	m_key;
+	int				m_score;
+} t_pawnEntry;
+
+static t_pawnEntry st_pawnHash[EVAL_PAWN_HASH];
+
+#ifdef EVAL_TUNING
+static unsigned long sl_pawnProbes;
+static unsigned long sl_pawnHits;
+static char sc_pawnHashOff;
+#endif
+
+/*-----------------------------------------------------------------------*/
+// One side's doubled and isolated penalty from its key.  The same doses as
+// pawnStructScore, read from the counts instead of the board, so a miss does
+// not walk either
+static int pawnSideScore(unsigned long key)
+{
+	char counts[8];
+	char f;
+	int term;
+
+	for(f = 0; f < 8; ++f)
+	{
+		counts[f] = (char)key & 7;
+		key >>= 3;
+	}
+
+	term = 0;
+	for(f = 0; f < 8; ++f)
+	{
+		char n = counts[f];
+
+		if(!n)
+			continue;
+		if(n > 1)
+			term -= (int)(n - 1) << 3;
+		if((!f || !counts[f - 1]) && (f == 7 || !counts[f + 1]))
+			term -= (int)n << 4;
+	}
+	return term;
+}
+
+/*-----------------------------------------------------------------------*/
+static int pawnSideCached(unsigned long key)
+{
+	t_pawnEntry *entry = &st_pawnHash[((unsigned int)key ^ (unsigned int)(key >> 12)) &
+	                                  (EVAL_PAWN_HASH - 1)];
+
+#ifdef EVAL_TUNING
+	++sl_pawnProbes;
+#endif
+	if(entry->m_key != key)
+	{
+		entry->m_key = key;
+		entry->m_score = pawnSideScore(key);
+	}
+#ifdef EVAL_TUNING
+	else
+		++sl_pawnHits;
+#endif
+	return entry->m_score;
+}
+
+/*-----------------------------------------------------------------------*/
+static int pawnStructCached(void)
+{
+#ifdef EVAL_TUNING
+	if(sc_pawnHashOff)
+		return pawnStructScore();
+#endif
+	return pawnSideCached(gePawnKey[SIDE_WHITE]) -
+	       pawnSideCached(gePawnKey[SIDE_BLACK]);
+}
+
+#ifdef EVAL_TUNING
+/*-----------------------------------------------------------------------*/
+void eval_PawnHashStats(unsigned long *probes, unsigned long *hits)
+{
+	*probes = sl_pawnProbes;
+	*hits = sl_pawnHits;
+}
+
+/*-----------------------------------------------------------------------*/
+void eval_PawnHashReset(void)
+{
+	int i;
+
+	for(i = 0; i < EVAL_PAWN_HASH; ++i)
+	{
+		st_pawnHash[i].m_key = 0;
+		st_pawnHash[i].m_score = 0;
+	}
+	sl_pawnProbes = 0;
+	sl_pawnHits = 0;
+}
+
+/*-----------------------------------------------------------------------*/
+void eval_PawnHashUse(char on)
+{
+	sc_pawnHashOff = !on;
+}
+#endif
+#endif
 #endif
 
 /*-----------------------------------------------------------------------*/
@@ -308,8 +427,7 @@ static int pawnStructScore(void)
 // at the start, 0 with bare kings.  Carried by make/unmake like the score,
 // because working it out per node was what killed this term the first time -
 // the cost was never the table, it was touching 32 pieces to decide which
-// table to use
-#define PHASE_ENDGAME		3200
+// table to use.  PHASE_ENDGAME, where the endgame tables start, is in eval.h
 int eval_PhaseDelta(const t_engMove *move, char piece, char captured)
 {
 	char promote = move->m_flags & ENG_MF_PROMO;
@@ -383,6 +501,20 @@ int eval_EndDelta(const t_engMove *move, char piece, char captured)
 	return delta;
 }
 
+#ifdef EVAL_TUNING
+/*-----------------------------------------------------------------------*/
+// The middlegame table a kind reads, which in the tuning build depends on
+// which queen candidate is switched on
+static const signed char *tuningTable(char kind)
+{
+	if(QUEEN == kind && EVAL_HAS(EVAL_QUEENHOME))
+		return sc_pstQueenHome;
+	if(QUEEN == kind && EVAL_HAS(EVAL_QUEENOUT))
+		return sc_pstQueenOut;
+	return sc_pst[kind];
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 // What one piece standing on one square is worth, always signed white-positive
 // so the totals add without caring whose turn it is
@@ -406,14 +538,7 @@ static int pieceScore(char piece, char sq)
 		if(EVAL_HAS(EVAL_MATERIAL))
 			value += gcPieceValue[kind];
 		if(EVAL_HAS(EVAL_PST))
-		{
-			if(QUEEN == kind && EVAL_HAS(EVAL_QUEENHOME))
-				value += sc_pstQueenHome[index];
-			else if(QUEEN == kind && EVAL_HAS(EVAL_QUEENOUT))
-				value += sc_pstQueenOut[index];
-			else
-				value += sc_pst[kind][index];
-		}
+			value += tuningTable(kind)[index];
 
 		return (piece & PIECE_WHITE) ? value : -value;
 	}
@@ -453,6 +578,11 @@ void eval_Refresh(void)
 		geEvalEnd += endBonus(geBoard[sq], sq);
 	}
 
+#if EVAL_PAWN_HASH
+	// the pawn key is carried with these totals, so it is rebuilt with them
+	eng_PawnKeyOfBoard(gePawnKey);
+#endif
+
 	// the phase has to be rebuilt from the board for the same reason the score
 	// does - pieces got here without going through eng_Make
 	gePhase = 0;
@@ -511,14 +641,14 @@ int eval_MoveDelta(const t_engMove *move, char piece, char captured)
 // 0 on the middle four squares and 6 in a corner
 static const signed char sc_centreDist[8] = { 3, 2, 1, 0, 0, 1, 2, 3 };
 
-// How far ahead the winning side has to be before chasing the enemy king is
-// the right idea.  A minor piece: below that the position is not won, and
-// walking your king at an opponent who still has material is how you lose it
-#define DRIVE_GATE			400
-
-// And how little has to be left on the board.  **This bound is the whole
-// difference between a term that works and one that lost a match**, and it was
-// found by playing Sargon II rather than by any test in tests/.
+// DRIVE_GATE (eval.h) is how far ahead the winning side has to be before
+// chasing the enemy king is the right idea.  A minor piece: below that the
+// position is not won, and walking your king at an opponent who still has
+// material is how you lose it.
+//
+// DRIVE_PHASE is how little has to be left on the board.  **This bound is the
+// whole difference between a term that works and one that lost a match**, and
+// it was found by playing Sargon II rather than by any test in tests/.
 //
 // The first version gated only on PHASE_ENDGAME, which is 3200 - so the drive
 // was live with two rooks and two minors still on, where "walk the enemy king
@@ -532,7 +662,6 @@ static const signed char sc_centreDist[8] = { 3, 2, 1, 0, 0, 1, 2, 3 };
 // above what has actually been verified rather than at a guess about what else
 // might benefit - queen against a lone minor is 1220 and is *not* covered,
 // deliberately, because nothing here has measured it
-#define DRIVE_PHASE			1100
 
 /*-----------------------------------------------------------------------*/
 // Two things, and they are the whole of every basic mate.  Push the losing
@@ -663,10 +792,15 @@ int eval_Position(char side)
 #if EVAL_PAWNSTRUCT_ON
 	// Doubled and isolated sit outside geEvalScore: not a property of a piece
 	// on a square.  Scanned from the board here - see the note above the
-	// helper for why this is not incremental
+	// helper for why this is not incremental - unless the pawn hash already
+	// holds this skeleton
 	if(EVAL_HAS(EVAL_PAWNSTRUCT))
 	{
+#if EVAL_PAWN_HASH
+		gePawnStruct = pawnStructCached();
+#else
 		gePawnStruct = pawnStructScore();
+#endif
 		score += gePawnStruct;
 	}
 #endif
@@ -729,3 +863,176 @@ int eval_Position(char side)
 
 	return (side == SIDE_WHITE) ? score : -score;
 }
+
+#ifdef EVAL_TUNING
+/*-----------------------------------------------------------------------*/
+// See eval.h.  The same walk as eval_Refresh, keeping the parts apart instead
+// of adding them up
+void eval_Coefficients(t_evalCoeffs *coeffs)
+{
+	char sq, kind;
+
+	for(kind = 0; kind <= PAWN; ++kind)
+	{
+		coeffs->m_count[kind] = 0;
+		coeffs->m_phaseCount[kind] = 0;
+		coeffs->m_pst[kind] = 0;
+	}
+	coeffs->m_endPawn = coeffs->m_endKing = 0;
+
+	for(sq = 0; sq < 0x78; ++sq)
+	{
+		char piece = geBoard[sq], index;
+		int sign;
+
+		kind = piece & PIECE_DATA;
+		if(ENG_OFFBOARD(sq) || NONE == kind)
+			continue;
+
+		index = (piece & PIECE_WHITE) ? ENG_TO_TILE(sq) : (ENG_TO_TILE(sq) ^ 56);
+		sign = (piece & PIECE_WHITE) ? 1 : -1;
+
+		coeffs->m_count[kind] += sign;
+		if(PAWN != kind && KING != kind)
+			++coeffs->m_phaseCount[kind];
+		coeffs->m_pst[kind] += sign * tuningTable(kind)[index];
+		if(PAWN == kind)
+			coeffs->m_endPawn += sign * sc_pstPawnEnd[index];
+		else if(KING == kind)
+			coeffs->m_endKing += sign * sc_pstKingEnd[index];
+	}
+
+	coeffs->m_drive[SIDE_WHITE] = coeffs->m_drive[SIDE_BLACK] = 0;
+	if(EVAL_MATEDRIVE_ON && EVAL_HAS(EVAL_MATEDRIVE))
+	{
+		char side;
+
+		for(side = SIDE_BLACK; side <= SIDE_WHITE; ++side)
+		{
+#if EVAL_KBN_ON
+			coeffs->m_drive[side] = EVAL_HAS(EVAL_KBN) ? kbnDrive(side) : 0;
+			if(!coeffs->m_drive[side])
+#endif
+				coeffs->m_drive[side] = mateDrive(geKing[side], geKing[1 - side]);
+		}
+	}
+
+	coeffs->m_fixed = 0;
+#if EVAL_DEV_ON
+	if(EVAL_HAS(EVAL_DEV))
+		coeffs->m_fixed += devScore();
+#endif
+#if EVAL_PAWNSTRUCT_ON
+	if(EVAL_HAS(EVAL_PAWNSTRUCT))
+		coeffs->m_fixed += pawnStructScore();
+#endif
+}
+
+/*-----------------------------------------------------------------------*/
+// See eval.h.  eval_Position in slow motion: the same terms in the same
+// order, each kept apart, and the board walked for material and tables
+// rather than read from the running total that mixes them
+void eval_Trace(char side, t_evalTrace *trace)
+{
+	char sq;
+	int score;
+
+	trace->m_material = trace->m_pst = 0;
+	for(sq = 0; sq < 0x78; ++sq)
+	{
+		char piece = geBoard[sq], kind = piece & PIECE_DATA, index;
+		int sign;
+
+		if(ENG_OFFBOARD(sq) || NONE == kind)
+			continue;
+
+		index = (piece & PIECE_WHITE) ? ENG_TO_TILE(sq) : (ENG_TO_TILE(sq) ^ 56);
+		sign = (piece & PIECE_WHITE) ? 1 : -1;
+		if(EVAL_HAS(EVAL_MATERIAL))
+			trace->m_material += sign * gcPieceValue[kind];
+		if(EVAL_HAS(EVAL_PST))
+			trace->m_pst += sign * tuningTable(kind)[index];
+	}
+
+	trace->m_dev = trace->m_pawnStruct = 0;
+#if EVAL_DEV_ON
+	if(EVAL_HAS(EVAL_DEV))
+		trace->m_dev = devScore();
+#endif
+#if EVAL_PAWNSTRUCT_ON
+	if(EVAL_HAS(EVAL_PAWNSTRUCT))
+		trace->m_pawnStruct = pawnStructScore();
+#endif
+
+	score = trace->m_material + trace->m_pst + trace->m_dev + trace->m_pawnStruct;
+	trace->m_endgame = trace->m_mateDrive = trace->m_kbn = 0;
+	trace->m_phase = gePhase;
+
+	if(gePhase < PHASE_ENDGAME)
+	{
+		if(EVAL_HAS(EVAL_ENDGAME))
+		{
+			int adj = geEvalEnd;
+
+			switch((char)((PHASE_ENDGAME - gePhase) >> 10))
+			{
+				case 0:  trace->m_endgame = adj >> 2;               break;
+				case 1:  trace->m_endgame = adj >> 1;               break;
+				case 2:  trace->m_endgame = (adj >> 1) + (adj >> 2); break;
+				default: trace->m_endgame = adj;                    break;
+			}
+			score += trace->m_endgame;
+		}
+
+		if(EVAL_MATEDRIVE_ON && EVAL_HAS(EVAL_MATEDRIVE) && gePhase <= DRIVE_PHASE &&
+		   (score > DRIVE_GATE || score < -DRIVE_GATE))
+		{
+			char winner = (score > 0) ? SIDE_WHITE : SIDE_BLACK;
+			int sign = (SIDE_WHITE == winner) ? 1 : -1;
+
+#if EVAL_KBN_ON
+			trace->m_kbn = EVAL_HAS(EVAL_KBN) ? sign * kbnDrive(winner) : 0;
+			if(!trace->m_kbn)
+#endif
+				trace->m_mateDrive = sign * mateDrive(geKing[winner], geKing[1 - winner]);
+		}
+	}
+
+	if(SIDE_BLACK == side)
+	{
+		trace->m_material = -trace->m_material;
+		trace->m_pst = -trace->m_pst;
+		trace->m_endgame = -trace->m_endgame;
+		trace->m_mateDrive = -trace->m_mateDrive;
+		trace->m_kbn = -trace->m_kbn;
+		trace->m_dev = -trace->m_dev;
+		trace->m_pawnStruct = -trace->m_pawnStruct;
+	}
+	trace->m_total = trace->m_material + trace->m_pst + trace->m_endgame +
+	                 trace->m_mateDrive + trace->m_kbn + trace->m_dev + trace->m_pawnStruct;
+}
+
+/*-----------------------------------------------------------------------*/
+int eval_TablePeak(char kind, char endgame)
+{
+	const signed char *table;
+	int peak = 0;
+	char i;
+
+	if(endgame)
+		table = (PAWN == kind) ? sc_pstPawnEnd : (KING == kind) ? sc_pstKingEnd : 0;
+	else
+		table = (kind && kind <= PAWN) ? tuningTable(kind) : 0;
+	if(!table)
+		return 0;
+
+	for(i = 0; i < 64; ++i)
+	{
+		int cell = table[i] < 0 ? -table[i] : table[i];
+
+		if(cell > peak)
+			peak = cell;
+	}
+	return peak;
+}
+#endif
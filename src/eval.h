@@ -163,6 +163,19 @@ extern char geEvalTerms;
 #define EVAL_PAWNSTRUCT_ON	0
 #endif
 
+// E1 pawn hash: entries in a direct-mapped table of structure scores, keyed
+// by per-file pawn counts that make/unmake carry beside the eval totals.
+// A probe replaces the board walk whenever the skeleton was seen recently,
+// which is most nodes - pawns move in few of them.  Power of two; 0 is the
+// walk at every evaluation, and without EVAL_PAWNSTRUCT_ON there is nothing
+// to cache, so no key and no table either
+#if !EVAL_PAWNSTRUCT_ON
+#undef EVAL_PAWN_HASH
+#define EVAL_PAWN_HASH		0
+#elif !defined(EVAL_PAWN_HASH)
+#define EVAL_PAWN_HASH		0
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Queen developed while a home-square bishop or knight has not moved (E3).
 // Default off: dose 16 was +1.95σ / +1.67σ, short of +2σ; dose 48 was worse
@@ -193,6 +206,28 @@ extern int geEvalScore;
 extern int gePawnStruct;
 #endif
 
+#if EVAL_PAWN_HASH
+/*-----------------------------------------------------------------------*/
+// Each side's pawns counted by file, three bits a file from a at the bottom,
+// indexed by SIDE_*.  The counts are all the structure score reads, so the
+// key is exact rather than a hash.  Kept by eng_Make and eng_Unmake with the
+// eval totals rather than with geHashKey, because quiescence evaluates and
+// the position hash is off there.  It lives in engine.c beside the other
+// running state; eval_Refresh rebuilds it from the board through
+// eng_PawnKeyOfBoard, which the fuzzer also checks it against
+extern unsigned long gePawnKey[2];
+void eng_PawnKeyOfBoard(unsigned long *key);
+
+#ifdef EVAL_TUNING
+// Probes and hits since the last reset, for the purpose test and the hit rate.
+// eval_PawnHashUse(0) scores every evaluation by the walk, as a build without
+// the table would, so a search can be compared with and without it
+void eval_PawnHashStats(unsigned long *probes, unsigned long *hits);
+void eval_PawnHashReset(void);
+void eval_PawnHashUse(char on);
+#endif
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Non-pawn material left on the board, both sides, carried by make/unmake the
 // same way the score is.  It decides how far into the endgame the position is,
@@ -200,6 +235,14 @@ extern int gePawnStruct;
 extern int gePhase;
 int eval_PhaseDelta(const t_engMove *move, char piece, char captured);
 
+// Where the phase starts to matter.  The endgame tables blend in below
+// PHASE_ENDGAME; the mate drive fires at or below DRIVE_PHASE, and only for a
+// side DRIVE_GATE ahead.  eval.c says why each number is what it is.  They
+// live here so tests/texel.c models the same blend instead of a copy of it
+#define PHASE_ENDGAME		3200
+#define DRIVE_GATE			400
+#define DRIVE_PHASE			1100
+
 /*-----------------------------------------------------------------------*/
 // How much more the position is worth once the endgame tables apply.  Carried
 // by make/unmake like the score, and blended in by eval_Position according to
@@ -208,6 +251,12 @@ int eval_PhaseDelta(const t_engMove *move, char piece, char captured);
 extern int geEvalEnd;
 int eval_EndDelta(const t_engMove *move, char piece, char captured);
 
+#if ENGINE_ZP
+#pragma zpsym ("geEvalScore")
+#pragma zpsym ("gePhase")
+#pragma zpsym ("geEvalEnd")
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Position score from "side"'s point of view; positive is good for side.  Now
 // just a read of geEvalScore, negated for black
@@ -235,4 +284,55 @@ int eval_MoveDelta(const t_engMove *move, char piece, char captured);
 #define EVAL_PAWN_DOUBLED	(-8)
 #define EVAL_PAWN_ISOLATED	(-16)
 
+#ifdef EVAL_TUNING
+/*-----------------------------------------------------------------------*/
+// The position as the tuner sees it: for every number a fit may move, how
+// often this board counts it.  The score is linear in piece values and table
+// scales apart from the blend step and the drive gate, so these and the
+// thresholds above are enough to rebuild eval_Position at any other numbers -
+// from the tables in eval.c, not from a copy that has to be kept in step.
+//
+// Everything is white-positive.  m_drive is what the drive would add for each
+// side as the winner, already chosen between KBN and the plain drive;
+// m_fixed is the terms no fit moves (dev, pawn structure) as they stand
+typedef struct tag_evalCoeffs
+{
+	int		m_count[PAWN+1];		// white minus black, by kind
+	int		m_phaseCount[PAWN+1];	// both sides, by kind; gePhase sums these
+	int		m_pst[PAWN+1];			// middlegame table cells, by kind
+	int		m_endPawn;				// endgame table cells, whole rather
+	int		m_endKing;				// than the difference geEvalEnd holds
+	int		m_drive[2];				// by winning side
+	int		m_fixed;
+} t_evalCoeffs;
+
+// Coefficients of the position on the board.  Walks it, so off the hot path
+void eval_Coefficients(t_evalCoeffs *coeffs);
+
+// The largest magnitude in a kind's middlegame or endgame table, so a fitted
+// scale can be held to what a signed char can store.  0 for a missing table
+int eval_TablePeak(char kind, char endgame);
+
+/*-----------------------------------------------------------------------*/
+// Why a position scored what it did, one term at a time, from "side"'s point
+// of view.  The parts add up to m_total, which is eval_Position(side); a term
+// that is switched off or compiled out reads 0.  m_endgame is the share of
+// the endgame tables the blend let in, not the whole difference, and m_kbn
+// and m_mateDrive never both fire.  Walks the board, so off the hot path
+typedef struct tag_evalTrace
+{
+	int		m_material;
+	int		m_pst;
+	int		m_endgame;
+	int		m_mateDrive;
+	int		m_kbn;
+	int		m_dev;
+	int		m_pawnStruct;
+	int		m_phase;		// gePhase, which is not side-relative
+	int		m_total;
+} t_evalTrace;
+
+void eval_Trace(char side, t_evalTrace *trace);
+#endif
+
 #endif //_EVAL_H_
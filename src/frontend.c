@@ -17,6 +17,13 @@
 // All menu's in the games are the same height
 #define MENU_HEIGHT 6
 
+// except the skill menu, when a port's timed levels make it longer than that
+#if SEARCH_NUM_SKILLS + SEARCH_NUM_TIMED < MENU_HEIGHT
+#define SKILL_MENU_HEIGHT MENU_HEIGHT
+#else
+#define SKILL_MENU_HEIGHT (SEARCH_NUM_SKILLS + SEARCH_NUM_TIMED + 1)
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Show the main menu and deal with the selection.	If a confirmation or
 // side-selection is needed, show that and deal with that oucome as well.
@@ -101,9 +108,10 @@ char frontend_Menu(char activeGame)
 		{
 			if(gUserMode != 3)
 			{
-				char skill = plat_Menu(gSkillMenu, MENU_HEIGHT, gszAbout);
+				char skill = plat_Menu(gSkillMenu, SKILL_MENU_HEIGHT, gszAbout);
 				// The three tuning knobs the old AI had are now one level,
-				// which picks a search depth and a node budget
+				// which picks a search depth and a node budget - or a time a
+				// move that becomes one, past the node levels
 				if(skill)
 					gSkillLevel = skill - 1;
 				else
@@ -8,6 +8,7 @@
 
 #include "types.h"
 #include "globals.h"
+#include "search.h"
 
 /*-----------------------------------------------------------------------*/
 char		gChessBoard[8][8];							// Display mirror of the engine board
@@ -20,7 +21,7 @@ char		gTile[2];									// [0] = src tile, [1] = dst, as 0..63 for the log
 char		gPiece[2];									// [0] = piece moved, [1] = piece taken
 char		gColor[2];									// [0] = color of the piece that moved
 char		gOutcome;									// Result of the last move, for the log
-char		gSkillLevel;								// 0..3, indexes gcSearchSkill
+char		gSkillLevel;								// gcSearchSkill, then gcSearchSeconds past it
 char		gReturnToOS;								// =1 can quit game; =0 cannot quit game
 char		gCursorPos[2][2];							// Remember last cursor pos for human players
 #ifdef PLAT_CURSOR_JUMP
@@ -37,13 +38,23 @@ char		gszNoUndo[] = "No Undo";
 char		gszNoRedo[] = "No Redo";
 char		gszInvalid[] = "Invalid";
 char		gszThinking[] = "Think";
+#if SEARCH_IDLE
+char		gszNoHint[] = "No hint";
+#endif
 char		gszAbout[] = "cc65 Chess V2.0 by S. Wessels, 2026.    ";
 char		gszResume[] = "Resume Game    ";
 char		gszQuit[] = "Quit Game      ";
 char		gszSelect[] = "    Select     ";
 char		gszpromote[] = "Select a rank to promote the pawn to. ";
 char*		gMainMenu[] = {gszSelect, "1 Human player ","2 Human players","Both players AI",gszQuit, 0, 0};
-char*		gSkillMenu[] = {gszSelect, "  Very Easy    ","  Easy         ","  Harder       ","  Very Hard    ", 0};
+char*		gSkillMenu[] = {gszSelect, "  Very Easy    ","  Easy         ","  Harder       ","  Very Hard    ",
+#if SEARCH_NUM_SKILLS > 4
+							"  Deep         ",
+#endif
+#if SEARCH_NUM_TIMED
+							"  15 sec/move  ","  30 sec/move  ","  1 min/move   ",
+#endif
+							0};
 char*		gColorMenu[] = {gszSelect,"  Play White   ","  Play Black   ", 0};
 char*		gAreYouSureMenu[] = {" Are you sure? ","  Absolutely!  ","  Not so much  ",0};
 char*		gPromoteMenu[] = {"Promotion", "  Queen  ", "  Rook   ", "  Bishop ", "  Knight ", 0};
@@ -37,7 +37,7 @@ extern char		gTile[2];									// [0] = src tile, [1] = dst, as 0..63 for the lo
 extern char		gPiece[2];									// [0] = piece moved, [1] = piece taken
 extern char		gColor[2];									// [0] = color of the piece that moved
 extern char		gOutcome;									// Result of the last move, for the log
-extern char		gSkillLevel;								// 0..3, indexes gcSearchSkill
+extern char		gSkillLevel;								// gcSearchSkill, then gcSearchSeconds past it
 extern char		gReturnToOS;								// =1 can quit game; =0 cannot quit game
 extern char		gCursorPos[2][2];							// Remember last cursor pos for human players
 #ifdef PLAT_CURSOR_JUMP
@@ -58,6 +58,7 @@ extern char		gszNoUndo[];
 extern char		gszNoRedo[];
 extern char		gszInvalid[];
 extern char		gszThinking[];
+extern char		gszNoHint[];
 extern char		gszAbout[];
 extern char		gszResume[];
 extern char		gszQuit[];
@@ -11,6 +11,7 @@
 #include "engine.h"
 #include "undo.h"
 #include "board.h"
+#include "search.h"
 #include "human.h"
 #include "frontend.h"
 #include "plat.h"
@@ -24,6 +25,83 @@ void human_ProcessToggle(int keyMask, char side, char tile);
 // Track the user controlled cursor on the board
 static char sc_cursorX, sc_cursorY;
 
+#if SEARCH_IDLE
+/*-----------------------------------------------------------------------*/
+// The deepest idle thinking done on the position in front of the player, and
+// whether there is any more to do.  A key ends an idle search and the next
+// one starts again from depth 1, so this keeps the best any of them reached
+static t_searchResult st_hint;
+static char sc_idleDone;
+
+// The hint as the message area shows it: the move, then the score in tenths
+// of a pawn for the side to move, so "E2E4+3".  Seven characters at most,
+// which is all the C64's message area has
+static char sc_hintStr[8];
+
+/*-----------------------------------------------------------------------*/
+static void human_ShowHint(void)
+{
+	char from, to, tenths;
+	int score;
+
+	if(!st_hint.m_depth)
+	{
+		plat_ShowMessage(gszNoHint, HCOLOR_INVALID);
+		return;
+	}
+
+	from = ENG_TO_TILE(st_hint.m_move.m_from);
+	to = ENG_TO_TILE(st_hint.m_move.m_to);
+	sc_hintStr[0] = 'A' + (from & 7);
+	sc_hintStr[1] = '8' - (from / 8);
+	sc_hintStr[2] = 'A' + (to & 7);
+	sc_hintStr[3] = '8' - (to / 8);
+
+	score = st_hint.m_score;
+	sc_hintStr[4] = '+';
+	if(score < 0)
+	{
+		sc_hintStr[4] = '-';
+		score = -score;
+	}
+	// a mate, or near enough, reads as 99
+	tenths = score >= 1000 ? 99 : score / 10;
+	if(tenths >= 10)
+	{
+		sc_hintStr[5] = '0' + tenths / 10;
+		sc_hintStr[6] = '0' + tenths % 10;
+		sc_hintStr[7] = 0;
+	}
+	else
+	{
+		sc_hintStr[5] = '0' + tenths;
+		sc_hintStr[6] = 0;
+	}
+
+	plat_ShowMessage(sc_hintStr, HCOLOR_VALID);
+}
+
+/*-----------------------------------------------------------------------*/
+// Each depth an idle search finishes.  A restarted search comes back through
+// the shallow depths first, and those say nothing new
+static void human_IdleShown(const t_searchResult *result)
+{
+	if(result->m_depth < st_hint.m_depth)
+		return;
+
+	st_hint = *result;
+	human_ShowHint();
+}
+
+/*-----------------------------------------------------------------------*/
+// A new position: nothing thought about it yet
+static void human_IdleReset(void)
+{
+	st_hint.m_depth = 0;
+	sc_idleDone = 0;
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Handle the cursor movement
 void human_ProcessInput(int keyMask)
@@ -83,7 +161,7 @@ void human_ProcessToggle(int keyMask, char side, char tile)
 			gShowAttackBoard = 1 - gShowAttackBoard;
 			// the counts are only kept up to date while the display is on
 			board_SyncDisplay();
-			plat_DrawBoard(0);
+			board_DrawChanged();
 		break;
 
 		case INPUT_TOGGLE_A:
@@ -131,6 +209,13 @@ char human_Play(char side)
 	gGotoTile = 255;
 #endif
 
+	// every move this side has, worked out before the first key rather than
+	// again each time the cursor lands on a piece
+	board_LegalMap(side);
+#if SEARCH_IDLE
+	human_IdleReset();
+#endif
+
 	do
 	{
 		char cursorTile = MK_POS(sc_cursorY, sc_cursorX);
@@ -148,8 +233,15 @@ char human_Play(char side)
 			// If no piece selected and the cursor moved, work out where the
 			// piece under it could go.  These are legal moves, not merely
 			// possible ones, so a move offered can never be refused
+			// The other side's pieces are never offered, so their moves are
+			// not worth working out
 			if(!selector)
-				board_LegalMovesFrom(srcTile);
+			{
+				if(pieceColor == side)
+					board_LegalMovesFrom(srcTile);
+				else
+					gNumMoveTiles = 0;
+			}
 			else
 			{
 				validMove = board_findInList(gMoveTiles, gNumMoveTiles, dstTile);
@@ -177,8 +269,22 @@ char human_Play(char side)
 			human_ProcessToggle(INPUT_TOGGLE_A, side, cursorTile);
 		}
 
-		// Get input
+		// Get input.  With SEARCH_IDLE the wait is spent thinking about the
+		// position, and the key that ends the thinking is the one acted on
+#if SEARCH_IDLE
+		keyMask = 0;
+		if(!sc_idleDone)
+		{
+			t_searchResult result;
+
+			keyMask = search_Idle(side, &result, human_IdleShown);
+			sc_idleDone = !keyMask;
+		}
+		if(!keyMask)
+			keyMask = plat_ReadKeys(1);
+#else
 		keyMask = plat_ReadKeys(1);
+#endif
 
 		// Always clear the message area once a key is pressed
 		plat_ClearMessage();
@@ -215,6 +321,13 @@ char human_Play(char side)
 			// Handle the toggle-show-attackers-defenders-board state changes
 			human_ProcessToggle(keyMask & INPUT_TOGGLE, side, cursorTile);
 		}
+#if SEARCH_IDLE
+		else if(keyMask & INPUT_HINT)
+		{
+			// what the thinking so far says, without waiting for any more
+			human_ShowHint();
+		}
+#endif
 		else if(keyMask & INPUT_BACKUP)
 		{
 			// If a piece was selected, deselect the piece
@@ -262,7 +375,7 @@ char human_Play(char side)
 				} while(--numUndo);
 
 				board_SyncDisplay();
-				plat_DrawBoard(0);
+				board_DrawChanged();
 
 				// put the cursor where the restored move came from
 				undo_FindUndoLine(0);
@@ -275,6 +388,10 @@ char human_Play(char side)
 				if(gUserMode == (USER_BLACK | USER_WHITE))
 					return OUTCOME_OK;
 
+				board_LegalMap(side);
+#if SEARCH_IDLE
+				human_IdleReset();
+#endif
 				keyMask = INPUT_MOTION;
 			}
 			else
@@ -312,13 +429,9 @@ char human_Play(char side)
 				{
 					gOutcome = board_ApplyMove(&move, side);
 
-					plat_DrawSquare(srcTile);
-					plat_DrawSquare(dstTile);
-
-					// castling also moves a rook, en passant clears a third
-					// tile, and a promotion changed the piece - redraw
-					if(move.m_flags & (ENG_MF_CASTLE | ENG_MF_ENPASSANT))
-						plat_DrawBoard(0);
+					// castling also moves a rook and en passant clears a
+					// third tile; the sync knows which
+					board_DrawChanged();
 
 					frontend_LogMove(0);
 					done = 1;
@@ -418,6 +418,8 @@ static int map_key(char ch, unsigned char key, char autoRepeat)
 		return INPUT_UNDO;
 	if(ch == 'r')
 		return INPUT_REDO;
+	if(ch == 'h')
+		return INPUT_HINT;
 	return 0;
 }
 
@@ -916,3 +918,15 @@ char plat_GetSeed(void)
 	/* TickCount is 60 Hz.  a wrong read repeats openings. */
 	return (char)TickCount();
 }
+
+#if PLAT_HEAP
+/*-----------------------------------------------------------------------*/
+/* a nonrelocatable block, already zeroed.  the partition is Retro68APPL.r's
+   1 MB; if that cannot spare it the search runs without the table. */
+void *plat_HeapAlloc(unsigned long size)
+{
+	Ptr p = NewPtrClear((Size)size);
+
+	return (MemError() == noErr) ? (void *)p : 0;
+}
+#endif
@@ -96,9 +96,6 @@ void mainLoop()
 					outcome = human_Play(sideToGo);
 				else
 					outcome = cpu_Play(sideToGo);
-					
-				if(gShowAttackBoard)
-					plat_DrawBoard(0);
 
 				// Only switch sides if not coming from a menu and it's not STALEMATE
 				if(outcome != OUTCOME_MENU && outcome != OUTCOME_STALEMATE)
@@ -34,4 +34,77 @@ void plat_Shutdown(void);
 // bad seed makes the openings repeat, which is exactly what happens now.
 char plat_GetSeed(void);
 
+// Memory beyond the main 64K, for search tables to grow into: the X16's
+// banked RAM at $A000, a C64 REU, the IIe's aux bank, the 130XE's PORTB
+// banks.  A machine has PLAT_BANKS banks of PLAT_BANK_WINDOW bytes, reached
+// one at a time, and tables keep fixed-size records in them - read and
+// written by copy, because on most of these machines the window is not
+// where the engine's pointers can reach, or not for long.
+//
+// PLAT_BANKS is 0 unless a port's build sets it, and with it 0 none of this
+// is declared, so a port that has not written the three functions builds
+// exactly as before - the freeze above is what that protects.  Bank numbers
+// are the table's, 0 to PLAT_BANKS - 1; which hardware bank that is, and
+// which ones the OS keeps, is the port's business.  tests/platStub.c
+// simulates them and counts the switches.
+#ifndef PLAT_BANKS
+#define PLAT_BANKS			0
+#endif
+
+#if PLAT_BANKS
+#ifndef PLAT_BANK_WINDOW
+#define PLAT_BANK_WINDOW	8192
+#endif
+
+// Make "bank" the one the window shows.  Read and write never switch
+void plat_BankSelect(char bank);
+// "size" bytes at "offset" in the window; offset + size <= PLAT_BANK_WINDOW
+void plat_BankRead(unsigned int offset, void *dst, char size);
+void plat_BankWrite(unsigned int offset, const void *src, char size);
+#endif
+
+// Memory a machine can simply hand over: the Mac's Memory Manager heap.
+// PLAT_HEAP is 0 unless a port's build sets it, the same as PLAT_BANKS.
+// plat_HeapAlloc returns "size" bytes, zeroed, that stay put for the life of
+// the program - or 0 when there are not that many, and a table that gets 0
+// goes without rather than stopping the game.  tests/platStub.c uses calloc
+#ifndef PLAT_HEAP
+#define PLAT_HEAP			0
+#endif
+
+#if PLAT_HEAP
+void *plat_HeapAlloc(unsigned long size);
+#endif
+
+// Draw several tiles at once, for a port where that is cheaper than a
+// plat_DrawSquare each - one pass down the bitmap rather than eight short
+// ones, say.  "changed" is eight bytes, one a row from the top, bit n for
+// column n; a port that would rather not batch a move's two tiles calls
+// plat_DrawSquare for those itself.  Off unless a port's build sets it,
+// like the two above
+#ifndef PLAT_DRAW_SQUARES
+#define PLAT_DRAW_SQUARES	0
+#endif
+
+#if PLAT_DRAW_SQUARES
+void plat_DrawSquares(const char *changed);
+#endif
+
+// The B display's counts brought forward from the squares a move changed,
+// rather than all 64 tiles counted again after every move.  Faster on the
+// human's turn, but it is code and an eight byte bitset board.c does not
+// otherwise carry, and Atari and the Apple II have no bytes to spare that
+// anyone has measured.  0 unless a port's build sets it, like the above
+#ifndef PLAT_ATTACK_UPDATE
+#define PLAT_ATTACK_UPDATE	0
+#endif
+
+// The side to move's legal destinations worked out once a turn, so the cursor
+// looks moves up instead of generating them on every piece it lands on.  193
+// bytes of BSS and the lookups, which have not been sized on Atari or the
+// Apple II either; 0 unless a port's build sets it
+#ifndef PLAT_LEGAL_MAP
+#define PLAT_LEGAL_MAP		0
+#endif
+
 #endif //_PLAT_H_
@@ -96,10 +96,11 @@ static const char sc_hcolor[7] =
 };
 
 /*-----------------------------------------------------------------------*/
-// HID usage codes for the thirteen keys this game uses
+// HID usage codes for the fourteen keys this game uses
 #define KEY_A					0x04
 #define KEY_B					0x05
 #define KEY_D					0x07
+#define KEY_H					0x0B
 #define KEY_M					0x10
 #define KEY_R					0x15
 #define KEY_U					0x18
@@ -468,6 +469,11 @@ void plat_DrawSquare(char position)
 
 	plat_showPiece(1 + x * BOARD_PIECE_WIDTH, 1 + y * BOARD_PIECE_HEIGHT, glyph, fore, back);
 
+	// The numbers live on the other plane, so drawing the piece leaves them.
+	// Clear this tile's text cells: a move redraws only its own tiles now,
+	// and B going off or a count losing a digit must not leave old ones
+	plat_clearText(1 + x * BOARD_PIECE_WIDTH, 1 + y * BOARD_PIECE_HEIGHT, BOARD_PIECE_WIDTH, BOARD_PIECE_HEIGHT);
+
 	// Show the attack numbers.  These go on the text plane over the piece,
 	// transparent so the piece stays visible behind them
 	if(gShowAttackBoard)
@@ -480,10 +486,12 @@ void plat_DrawSquare(char position)
 		plat_showStrXY(piece_color ? COL_ERROR : COL_LABEL, COL_CLEAR,
 		               1 + x * BOARD_PIECE_WIDTH, (y + 1) * BOARD_PIECE_HEIGHT, textStr);
 
-		// Defenders (bottom right)
-		sprintf(textStr, "%d", (gpAttackBoard[giAttackBoardOffset[position][1]]));
+		// Defenders (bottom right).  A second digit goes on the left, so it
+		// stays on this tile's cells instead of the next one's
+		index = gpAttackBoard[giAttackBoardOffset[position][1]];
+		sprintf(textStr, "%d", index);
 		plat_showStrXY(!piece_color ? COL_ERROR : COL_LABEL, COL_CLEAR,
-		               1 + x * BOARD_PIECE_WIDTH + 3, (y + 1) * BOARD_PIECE_HEIGHT, textStr);
+		               1 + x * BOARD_PIECE_WIDTH + (index > 9 ? 2 : 3), (y + 1) * BOARD_PIECE_HEIGHT, textStr);
 
 		// Piece value top left (1=ROOK, 2=KNIGHT, 3=BISHOP, 4=QUEEN, 5=KING, 6=PAWN)
 		sprintf(textStr, "%0d", piece_value);
@@ -605,6 +613,7 @@ static int plat_KeyMask(char code)
 		case KEY_ENTER:		return INPUT_SELECT;
 		case KEY_R:			return INPUT_REDO;
 		case KEY_U:			return INPUT_UNDO;
+		case KEY_H:			return INPUT_HINT;
 	}
 	return 0;
 }
@@ -28,6 +28,13 @@
 #ifdef SEARCH_PROFILE
 #include "c64profile.h"
 #endif
+#if SEARCH_MOVE_CACHE
+#include <string.h>
+#include "plat.h"			// only for the banks or heap the cache may live in
+#endif
+#if SEARCH_RECALIBRATE
+#include <time.h>			// CLOCKS_PER_SEC, for the ticks cpu.c measures in
+#endif
 
 /*-----------------------------------------------------------------------*/
 // One shared move arena, carved up a ply at a time.  Quiescence asks
@@ -53,16 +60,84 @@
 #endif
 
 static t_engMove	st_arena[SEARCH_ARENA];
+#if ENGINE_ZP
+// in zero page with the engine's scalars - enginezp.s
+extern unsigned int	si_arenaTop;
+extern unsigned int	si_nodes;
+extern unsigned int	si_budget;
+#pragma zpsym ("si_arenaTop")
+#pragma zpsym ("si_nodes")
+#pragma zpsym ("si_budget")
+#else
 static unsigned int	si_arenaTop;
+#endif
 
 // Two killers per ply: quiet moves that caused a beta cutoff here before, and
 // so are worth trying early in sibling positions
 static t_engMove	st_killers[SEARCH_MAX_PLY][2];
 
+#if !ENGINE_ZP
 static unsigned int	si_nodes;
 static unsigned int	si_budget;
+#endif
 static char			sc_abort;
 static char			sc_userStop;
+#if SEARCH_IDLE
+static char				sc_idle;
+static int				si_idleKey;
+static t_searchIdleFn	sf_idleShown;
+#endif
+
+#if SEARCH_STATS
+static t_searchStats	st_stats;
+#define STAT(x)			(x)
+
+/*-----------------------------------------------------------------------*/
+static void statArena(void)
+{
+	if(si_arenaTop > st_stats.m_arenaPeak)
+		st_stats.m_arenaPeak = si_arenaTop;
+}
+
+/*-----------------------------------------------------------------------*/
+void search_Stats(t_searchStats *stats)
+{
+	*stats = st_stats;
+}
+#else
+#define STAT(x)
+#endif
+
+#if SEARCH_TRACE
+static t_searchTraceFn	sf_trace;
+static const t_engMove	sc_noMove;
+#define TRACE(x)		do { if(sf_trace) trace x; } while(0)
+
+/*-----------------------------------------------------------------------*/
+void search_SetTrace(t_searchTraceFn fn)
+{
+	sf_trace = fn;
+}
+
+/*-----------------------------------------------------------------------*/
+static void trace(char event, char ply, char depth, const t_engMove *move,
+                  int alpha, int beta, int score)
+{
+	t_searchTrace node;
+
+	node.m_node = si_nodes;
+	node.m_event = event;
+	node.m_ply = ply;
+	node.m_depth = depth;
+	node.m_move = *move;
+	node.m_alpha = alpha;
+	node.m_beta = beta;
+	node.m_score = score;
+	sf_trace(&node);
+}
+#else
+#define TRACE(x)
+#endif
 
 // plat_ReadKeys is the one question the search asks the UI: did anyone
 // hit M or RUN/STOP.  declared here so search.c does not pull plat.h
@@ -79,6 +154,18 @@ static char outOfTime(void)
 		sc_abort = 1;
 		return 1;
 	}
+#if SEARCH_IDLE
+	// any key at all ends an idle search, and is kept for the caller
+	if(sc_idle)
+	{
+		if(!(si_nodes & (SEARCH_IDLE_SLICE - 1)) && 0 != (si_idleKey = plat_ReadKeys(0)))
+		{
+			sc_abort = 1;
+			return 1;
+		}
+		return 0;
+	}
+#endif
 	if(!(si_nodes & 63) &&
 	   (plat_ReadKeys(0) & (INPUT_MENU | INPUT_BACKUP)))
 	{
@@ -92,12 +179,16 @@ static char outOfTime(void)
 #if SEARCH_RESTORE_UNMAKE
 // Four 16-bit values for each reachable move-making ply: 96 bytes, kept out
 // of the user undo ring.  A ply's slot is reused only after its child returns.
+// The pawn hash adds its two keys when it is compiled in
 typedef struct tag_searchState
 {
 	unsigned int m_hash;
 	int m_eval;
 	int m_end;
 	int m_phase;
+#if EVAL_PAWN_HASH
+	unsigned long m_pawnKey[2];
+#endif
 } t_searchState;
 
 static t_searchState st_state[SEARCH_MAX_PLY];
@@ -111,6 +202,10 @@ static void saveState(char ply)
 	state->m_eval = geEvalScore;
 	state->m_end = geEvalEnd;
 	state->m_phase = gePhase;
+#if EVAL_PAWN_HASH
+	state->m_pawnKey[SIDE_BLACK] = gePawnKey[SIDE_BLACK];
+	state->m_pawnKey[SIDE_WHITE] = gePawnKey[SIDE_WHITE];
+#endif
 }
 
 /*-----------------------------------------------------------------------*/
@@ -122,6 +217,10 @@ static void restoreState(char ply)
 	geEvalScore = state->m_eval;
 	geEvalEnd = state->m_end;
 	gePhase = state->m_phase;
+#if EVAL_PAWN_HASH
+	gePawnKey[SIDE_BLACK] = state->m_pawnKey[SIDE_BLACK];
+	gePawnKey[SIDE_WHITE] = state->m_pawnKey[SIDE_WHITE];
+#endif
 }
 #else
 #define saveState(ply)
@@ -134,6 +233,10 @@ static void restoreState(char ply)
 // overhead, and makes it possible to interleave them in one emulator run.
 char geSearchProfile;
 static t_engMove st_profileMoves[127];
+#if PROFILE_COUNTS
+unsigned long glProfileCalls[PROFILE_COMPONENTS + 1];
+unsigned long glProfileUnits[PROFILE_COMPONENTS + 1];
+#endif
 #endif
 
 #ifdef EVAL_TUNING
@@ -185,7 +288,27 @@ typedef struct tag_mcEntry
 	char			m_occ;
 } t_mcEntry;
 
+// Slots are indexed by an unsigned int, and the clear loop counts one up to
+// the size, so the size itself has to fit: 65536 needs a 32-bit int.  It is
+// also as far as the size goes: past that the 16-bit key has run out of bits
+typedef char t_mcIndex[(SEARCH_MOVE_CACHE <= (unsigned int)~0u &&
+                        SEARCH_MOVE_CACHE <= 65536L) ? 1 : -1];
+
+#if PLAT_HEAP
+// One block from the port's heap, asked for by the first search.  If the
+// heap cannot spare it the cache is simply not there: a load finds an empty
+// slot and a save goes nowhere
+static t_mcEntry		*sp_mc;
+static char				sc_mcAsked;
+#elif PLAT_BANKS
+// Behind plat_Bank*: entries never straddle a window, and the bank the window
+// shows is remembered so a probe into the same bank does not switch again
+#define MC_PER_BANK		(PLAT_BANK_WINDOW / sizeof(t_mcEntry))
+typedef char t_mcFits[(SEARCH_MOVE_CACHE <= PLAT_BANKS * MC_PER_BANK) ? 1 : -1];
+static char				sc_mcBank = (char)0xFF;
+#else
 static t_mcEntry		st_mc[SEARCH_MOVE_CACHE];
+#endif
 static unsigned long	sl_mcProbes;
 static unsigned long	sl_mcOccupied;
 static unsigned long	sl_mcLocks;
@@ -250,6 +373,19 @@ char search_Seeded(void)
 	return sc_rand != 0;
 }
 
+/*-----------------------------------------------------------------------*/
+unsigned int search_SeedState(void)
+{
+	return ((unsigned int)sc_randMoves << 8) | sc_rand;
+}
+
+/*-----------------------------------------------------------------------*/
+void search_RestoreSeed(unsigned int state)
+{
+	sc_rand = (char)state;
+	sc_randMoves = (char)(state >> 8);
+}
+
 /*-----------------------------------------------------------------------*/
 // How many moves will still fit in the arena, clamped to what a char can hold
 static char arenaRoom(void)
@@ -308,8 +444,65 @@ const t_searchSkill gcSearchSkill[SEARCH_NUM_SKILLS] =
 	{ 4,  1200 },	// easy       - 39.7s mean; bank B3+B4 rather than buy ~8 Elo
 	{ 5, 18000 },	// harder     - reinvest the 17.2%; 15 extra whole-book depths
 	{ 6, 65000u },	// very hard  - 16-bit headroom; 23 extra whole-book depths
+#if SEARCH_NUM_SKILLS > 4
+	{ 9, 250000u },	// deep       - mac68k large profile; unmeasured on the target
+#endif
 };
 
+#if SEARCH_NUM_SKILLS > 4
+typedef char t_searchWideNodes[(sizeof(unsigned int) >= 4) ? 1 : -1];
+#endif
+
+#if SEARCH_NUM_TIMED
+/*-----------------------------------------------------------------------*/
+// A quick move, a considered one, and the minute a move people ask for.  At
+// the C64's rate 15 is the shortest that buys more than level 1 already does
+const unsigned char gcSearchSeconds[SEARCH_NUM_TIMED] = { 15, 30, 60 };
+
+// Starts at the port's measured rate and, with SEARCH_RECALIBRATE, follows
+// the machine it is actually running on
+static unsigned int si_nodeRate = SEARCH_NPS;
+
+/*-----------------------------------------------------------------------*/
+unsigned int search_TimedBudget(unsigned char seconds)
+{
+	unsigned long nodes = (unsigned long)seconds * si_nodeRate;
+
+	// a 16-bit port runs out of budget before a fast machine runs out of
+	// seconds; the depth cap is what stops it then
+	if(nodes > (unsigned int)~0u)
+		nodes = (unsigned int)~0u;
+	if(nodes < gcSearchSkill[0].m_nodes)
+		nodes = gcSearchSkill[0].m_nodes;
+
+	return (unsigned int)nodes;
+}
+
+/*-----------------------------------------------------------------------*/
+unsigned int search_NodeRate(void)
+{
+	return si_nodeRate;
+}
+
+#if SEARCH_RECALIBRATE
+/*-----------------------------------------------------------------------*/
+void search_Calibrate(unsigned int nodes, unsigned long ticks)
+{
+	unsigned long rate;
+
+	if(ticks < CLOCKS_PER_SEC)
+		return;
+
+	rate = (unsigned long)nodes * CLOCKS_PER_SEC / ticks;
+	rate = (3ul * si_nodeRate + rate) / 4;
+	if(rate > (unsigned int)~0u)
+		rate = (unsigned int)~0u;
+
+	si_nodeRate = rate ? (unsigned int)rate : 1;
+}
+#endif
+#endif
+
 /*-----------------------------------------------------------------------*/
 static char isCapture(const t_engMove *move)
 {
@@ -458,25 +651,72 @@ static unsigned int mcKey(void)
 	return geHashKey;
 }
 
+#if PLAT_HEAP
+/*-----------------------------------------------------------------------*/
+static void mcLoad(unsigned int slot, t_mcEntry *e)
+{
+	if(sp_mc)
+		*e = sp_mc[slot];
+	else
+		e->m_occ = 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static void mcSave(unsigned int slot, const t_mcEntry *e)
+{
+	if(sp_mc)
+		sp_mc[slot] = *e;
+}
+#elif PLAT_BANKS
+/*-----------------------------------------------------------------------*/
+static unsigned int mcWindow(unsigned int slot)
+{
+	char bank = (char)(slot / MC_PER_BANK);
+
+	if(bank != sc_mcBank)
+	{
+		plat_BankSelect(bank);
+		sc_mcBank = bank;
+	}
+	return (unsigned int)((slot % MC_PER_BANK) * sizeof(t_mcEntry));
+}
+
+/*-----------------------------------------------------------------------*/
+static void mcLoad(unsigned int slot, t_mcEntry *e)
+{
+	plat_BankRead(mcWindow(slot), e, sizeof(*e));
+}
+
+/*-----------------------------------------------------------------------*/
+static void mcSave(unsigned int slot, const t_mcEntry *e)
+{
+	plat_BankWrite(mcWindow(slot), e, sizeof(*e));
+}
+#else
+#define mcLoad(slot, e)		(*(e) = st_mc[slot])
+#define mcSave(slot, e)		(st_mc[slot] = *(e))
+#endif
+
 /*-----------------------------------------------------------------------*/
 static char mcProbe(t_engMove *moves, char count)
 {
 	unsigned int key = mcKey();
-	t_mcEntry *e = &st_mc[key & (SEARCH_MOVE_CACHE - 1)];
+	t_mcEntry e;
 	char i;
 
 	++sl_mcProbes;
-	if(!e->m_occ)
+	mcLoad(key & (SEARCH_MOVE_CACHE - 1), &e);
+	if(!e.m_occ)
 		return 0;
 	++sl_mcOccupied;
-	if(e->m_lock != key)
+	if(e.m_lock != key)
 		return 0;
 	++sl_mcLocks;
 	for(i = 0; i < count; ++i)
 	{
-		if(moves[i].m_from == e->m_from &&
-		   moves[i].m_to == e->m_to &&
-		   moves[i].m_flags == e->m_flags)
+		if(moves[i].m_from == e.m_from &&
+		   moves[i].m_to == e.m_to &&
+		   moves[i].m_flags == e.m_flags)
 		{
 			++sl_mcFound;
 			// 254 sits under the previous-iteration root 255
@@ -492,13 +732,14 @@ static char mcProbe(t_engMove *moves, char count)
 static void mcStore(const t_engMove *move)
 {
 	unsigned int key = mcKey();
-	t_mcEntry *e = &st_mc[key & (SEARCH_MOVE_CACHE - 1)];
-
-	e->m_lock = key;
-	e->m_from = move->m_from;
-	e->m_to = move->m_to;
-	e->m_flags = move->m_flags;
-	e->m_occ = 1;
+	t_mcEntry e;
+
+	e.m_lock = key;
+	e.m_from = move->m_from;
+	e.m_to = move->m_to;
+	e.m_flags = move->m_flags;
+	e.m_occ = 1;
+	mcSave(key & (SEARCH_MOVE_CACHE - 1), &e);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -634,6 +875,7 @@ static int quiesce(char side, int alpha, int beta, char ply)
 	if(outOfTime())
 		return 0;
 	++si_nodes;
+	STAT(++st_stats.m_qNodes);
 
 	// Being in check changes what this function is allowed to do, and getting
 	// that wrong is how the engine came to hang mate in one.  Two things follow
@@ -683,11 +925,13 @@ static int quiesce(char side, int alpha, int beta, char ply)
 		(void)eng_GenMoves(side, st_profileMoves, arenaRoom());
 	else if(!inCheck && PROFILE_GEN_CAPTURES == geSearchProfile)
 		(void)eng_GenCaptures(side, st_profileMoves, arenaRoom());
+	PROFILE_COUNT(inCheck ? PROFILE_GEN_MOVES : PROFILE_GEN_CAPTURES, 1);
 #endif
 
 	count = inCheck ? eng_GenMoves(side, moves, arenaRoom())
 	                : eng_GenCaptures(side, moves, arenaRoom());
 	si_arenaTop += count;
+	STAT(statArena());
 
 #if SEARCH_SCORE_FIRST
 	scoreMoves(moves, count, ply, 1);
@@ -696,6 +940,7 @@ static int quiesce(char side, int alpha, int beta, char ply)
 #endif
 
 #ifdef SEARCH_PROFILE
+	PROFILE_COUNT(PROFILE_SCORE, count);
 	if(PROFILE_SCORE == geSearchProfile)
 #if SEARCH_SCORE_FIRST
 		scoreMoves(moves, count, ply, 1);
@@ -717,6 +962,8 @@ static int quiesce(char side, int alpha, int beta, char ply)
 			pickBest(moves, count, i);
 		if(PROFILE_BOARD == geSearchProfile)
 			eng_ProfileBoardPair(&moves[i]);
+		PROFILE_COUNT(PROFILE_SELECT, count - i);
+		PROFILE_COUNT(PROFILE_BOARD, 1);
 #endif
 
 		saveState(ply);
@@ -726,12 +973,14 @@ static int quiesce(char side, int alpha, int beta, char ply)
 #ifdef SEARCH_PROFILE
 		if(PROFILE_LEGALITY == geSearchProfile)
 			(void)eng_LeavesInCheck(side, &moves[i], wasInCheck);
+		PROFILE_COUNT(PROFILE_LEGALITY, 1);
 #endif
 		if(eng_LeavesInCheck(side, &moves[i], wasInCheck))
 #else
 #ifdef SEARCH_PROFILE
 		if(PROFILE_LEGALITY == geSearchProfile)
 			(void)eng_IsAttacked(geKing[side], 1 - side);
+		PROFILE_COUNT(PROFILE_LEGALITY, 1);
 #endif
 		if(eng_IsAttacked(geKing[side], 1 - side))
 #endif
@@ -742,7 +991,11 @@ static int quiesce(char side, int alpha, int beta, char ply)
 		}
 		++legal;
 
+		TRACE((SEARCH_TRACE_ENTER | SEARCH_TRACE_QUIESCE, ply + 1, 0,
+		       &moves[i], -beta, -alpha, 0));
 		score = -quiesce(1 - side, -beta, -alpha, ply + 1);
+		TRACE((SEARCH_TRACE_LEAVE | SEARCH_TRACE_QUIESCE, ply + 1, 0,
+		       &moves[i], -beta, -alpha, -score));
 		eng_Unmake(&moves[i], &undo);
 		restoreState(ply);
 
@@ -784,6 +1037,9 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 #endif
 	int score;
 	unsigned int arenaSave;
+#if SEARCH_STATS
+	int alphaIn = alpha;
+#endif
 
 	if(outOfTime())
 		return 0;
@@ -811,18 +1067,27 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 #ifdef SEARCH_PROFILE
 	if(SEARCH_REPETITION && PROFILE_REPETITION == geSearchProfile)
 		(void)eng_IsRepetition(1);
+	if(SEARCH_REPETITION)
+		PROFILE_COUNT(PROFILE_REPETITION, 1);
 #endif
 
 	if(SEARCH_REPETITION && eng_IsRepetition(1))
+	{
+		STAT(++st_stats.m_drawNodes);
 		return 0;
+	}
 
 	// the fifty move rule, so the search cannot convince itself that shuffling
 	// forever is winning
 	if(geHalfmove >= 100)
+	{
+		STAT(++st_stats.m_drawNodes);
 		return 0;
+	}
 
 	if(0 == depth)
 	{
+		STAT(++st_stats.m_horizonNodes);
 #if SEARCH_QUIESCE_HISTORY
 		return quiesce(side, alpha, beta, ply);
 #else
@@ -845,10 +1110,14 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 #ifdef SEARCH_PROFILE
 	if(PROFILE_GEN_MOVES == geSearchProfile)
 		(void)eng_GenMoves(side, st_profileMoves, arenaRoom());
+	PROFILE_COUNT(PROFILE_GEN_MOVES, 1);
 #endif
 
 	count = eng_GenMoves(side, moves, arenaRoom());
 	si_arenaTop += count;
+	STAT(statArena());
+	STAT(++st_stats.m_genNodes);
+	STAT(st_stats.m_genMoves += count);
 
 #if SEARCH_SCORE_FIRST
 	scoreMoves(moves, count, ply, 1);
@@ -863,6 +1132,7 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 #endif
 
 #ifdef SEARCH_PROFILE
+	PROFILE_COUNT(PROFILE_SCORE, count);
 	if(PROFILE_SCORE == geSearchProfile)
 #if SEARCH_SCORE_FIRST
 		scoreMoves(moves, count, ply, 1);
@@ -883,6 +1153,8 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 			pickBest(moves, count, i);
 		if(PROFILE_BOARD == geSearchProfile)
 			eng_ProfileBoardPair(&moves[i]);
+		PROFILE_COUNT(PROFILE_SELECT, count - i);
+		PROFILE_COUNT(PROFILE_BOARD, 1);
 #endif
 
 		saveState(ply);
@@ -892,12 +1164,14 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 #ifdef SEARCH_PROFILE
 		if(PROFILE_LEGALITY == geSearchProfile)
 			(void)eng_LeavesInCheck(side, &moves[i], inCheck);
+		PROFILE_COUNT(PROFILE_LEGALITY, 1);
 #endif
 		if(eng_LeavesInCheck(side, &moves[i], inCheck))
 #else
 #ifdef SEARCH_PROFILE
 		if(PROFILE_LEGALITY == geSearchProfile)
 			(void)eng_IsAttacked(geKing[side], 1 - side);
+		PROFILE_COUNT(PROFILE_LEGALITY, 1);
 #endif
 		if(eng_IsAttacked(geKing[side], 1 - side))
 #endif
@@ -907,6 +1181,7 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 			continue;
 		}
 		++legal;
+		STAT(++st_stats.m_searched);
 
 #if SEARCH_FOLLOW_PV_ON
 		wasOnPV = sc_onPV;
@@ -925,10 +1200,18 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 			if(inCheck && ply + 1 < SEARCH_MAX_PLY)
 				nextDepth = depth;
 
+			TRACE((SEARCH_TRACE_ENTER, ply + 1, nextDepth, &moves[i],
+			       -beta, -alpha, 0));
 			score = -negamax(1 - side, nextDepth, -beta, -alpha, ply + 1);
+			TRACE((SEARCH_TRACE_LEAVE, ply + 1, nextDepth, &moves[i],
+			       -beta, -alpha, -score));
 		}
 #else
+		TRACE((SEARCH_TRACE_ENTER, ply + 1, depth - 1, &moves[i],
+		       -beta, -alpha, 0));
 		score = -negamax(1 - side, depth - 1, -beta, -alpha, ply + 1);
+		TRACE((SEARCH_TRACE_LEAVE, ply + 1, depth - 1, &moves[i],
+		       -beta, -alpha, -score));
 #endif
 #if SEARCH_FOLLOW_PV_ON
 		sc_onPV = wasOnPV;
@@ -944,6 +1227,21 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 
 		if(score >= beta)
 		{
+#if SEARCH_STATS
+			++st_stats.m_cutNodes;
+			if(1 == legal)
+				++st_stats.m_firstCuts;
+			if(!isCapture(&moves[i]))
+			{
+				++st_stats.m_quietCuts;
+				if(ply < SEARCH_MAX_PLY &&
+				   ((st_killers[ply][0].m_from == moves[i].m_from &&
+				     st_killers[ply][0].m_to == moves[i].m_to) ||
+				    (st_killers[ply][1].m_from == moves[i].m_from &&
+				     st_killers[ply][1].m_to == moves[i].m_to)))
+					++st_stats.m_killerCuts;
+			}
+#endif
 			// a quiet move good enough to cut off here is worth trying first
 			// in the sibling positions
 			if(!isCapture(&moves[i]))
@@ -983,8 +1281,17 @@ static int negamax(char side, char depth, int alpha, int beta, char ply)
 	// This is the whole of the old board_CheckForMate, board_UpdateAttackGrid
 	// and board_CheckLineAttack, and it needs no attack database
 	if(!legal)
+	{
+		STAT(++st_stats.m_allNodes);
 		return inCheck ? -EVAL_MATE_IN(ply) : 0;
+	}
 
+#if SEARCH_STATS
+	if(alpha > alphaIn)
+		++st_stats.m_pvNodes;
+	else
+		++st_stats.m_allNodes;
+#endif
 	return alpha;
 }
 
@@ -1068,10 +1375,12 @@ static int searchRoot(char side, char depth, int alpha, int beta, t_searchResult
 #ifdef SEARCH_PROFILE
 	if(PROFILE_GEN_MOVES == geSearchProfile)
 		(void)eng_GenMoves(side, st_profileMoves, arenaRoom());
+	PROFILE_COUNT(PROFILE_GEN_MOVES, 1);
 #endif
 
 	count = eng_GenMoves(side, moves, arenaRoom());
 	si_arenaTop += count;
+	STAT(statArena());
 
 	// Root must use plain scoring: randomisation and the previous iteration's
 	// move still adjust scores after this, so placing the best now would change
@@ -1083,6 +1392,7 @@ static int searchRoot(char side, char depth, int alpha, int beta, t_searchResult
 #endif
 
 #ifdef SEARCH_PROFILE
+	PROFILE_COUNT(PROFILE_SCORE, count);
 	if(PROFILE_SCORE == geSearchProfile)
 #if SEARCH_SCORE_FIRST
 		scoreMoves(moves, count, 0, 0);
@@ -1141,6 +1451,8 @@ static int searchRoot(char side, char depth, int alpha, int beta, t_searchResult
 			pickBest(moves, count, i);
 		if(PROFILE_BOARD == geSearchProfile)
 			eng_ProfileBoardPair(&moves[i]);
+		PROFILE_COUNT(PROFILE_SELECT, count - i);
+		PROFILE_COUNT(PROFILE_BOARD, 1);
 #endif
 
 		saveState(0);
@@ -1150,12 +1462,14 @@ static int searchRoot(char side, char depth, int alpha, int beta, t_searchResult
 #ifdef SEARCH_PROFILE
 		if(PROFILE_LEGALITY == geSearchProfile)
 			(void)eng_LeavesInCheck(side, &moves[i], wasInCheck);
+		PROFILE_COUNT(PROFILE_LEGALITY, 1);
 #endif
 		if(eng_LeavesInCheck(side, &moves[i], wasInCheck))
 #else
 #ifdef SEARCH_PROFILE
 		if(PROFILE_LEGALITY == geSearchProfile)
 			(void)eng_IsAttacked(geKing[side], 1 - side);
+		PROFILE_COUNT(PROFILE_LEGALITY, 1);
 #endif
 		if(eng_IsAttacked(geKing[side], 1 - side))
 #endif
@@ -1187,7 +1501,9 @@ static int searchRoot(char side, char depth, int alpha, int beta, t_searchResult
 			                 moves[i].m_to == st_prevPV[0].m_to &&
 			                 moves[i].m_flags == st_prevPV[0].m_flags);
 #endif
+		TRACE((SEARCH_TRACE_ENTER, 1, depth - 1, &moves[i], -beta, -alpha, 0));
 		score = -negamax(1 - side, depth - 1, -beta, -alpha, 1);
+		TRACE((SEARCH_TRACE_LEAVE, 1, depth - 1, &moves[i], -beta, -alpha, -score));
 #if SEARCH_FOLLOW_PV_ON
 		sc_onPV = wasOnPV;
 #endif
@@ -1246,6 +1562,14 @@ void search_Best(char side, char maxDepth, unsigned int nodeBudget, t_searchResu
 
 	si_nodes = 0;
 	si_budget = nodeBudget;
+#if SEARCH_STATS
+	{
+		static const t_searchStats sc_noStats;
+
+		st_stats = sc_noStats;
+		st_stats.m_arenaSize = SEARCH_ARENA;
+	}
+#endif
 	si_arenaTop = 0;
 	sc_abort = 0;
 	sc_userStop = 0;
@@ -1270,12 +1594,21 @@ void search_Best(char side, char maxDepth, unsigned int nodeBudget, t_searchResu
 				st_history[hp][ht] = 0;
 	}
 #endif
-#if SEARCH_MOVE_CACHE
+#if SEARCH_MOVE_CACHE && PLAT_HEAP
+	if(!sc_mcAsked)
+	{
+		sc_mcAsked = 1;
+		sp_mc = (t_mcEntry *)plat_HeapAlloc((unsigned long)SEARCH_MOVE_CACHE * sizeof(t_mcEntry));
+	}
+	if(sp_mc)
+		memset(sp_mc, 0, (unsigned long)SEARCH_MOVE_CACHE * sizeof(t_mcEntry));
+#elif SEARCH_MOVE_CACHE
 	{
+		static const t_mcEntry sc_mcEmpty;
 		unsigned int mi;
 
 		for(mi = 0; mi < SEARCH_MOVE_CACHE; ++mi)
-			st_mc[mi].m_occ = 0;
+			mcSave(mi, &sc_mcEmpty);
 	}
 #endif
 #if SEARCH_RESTORE_UNMAKE
@@ -1332,7 +1665,9 @@ void search_Best(char side, char maxDepth, unsigned int nodeBudget, t_searchResu
 		}
 #endif
 		working = *result;
+		TRACE((SEARCH_TRACE_ENTER, 0, depth, &sc_noMove, alpha, beta, 0));
 		score = searchRoot(side, depth, alpha, beta, &working);
+		TRACE((SEARCH_TRACE_LEAVE, 0, depth, &sc_noMove, alpha, beta, score));
 
 #if SEARCH_ASPIRATION_ON
 		// fail low or fail high: throw this attempt away and search
@@ -1341,20 +1676,34 @@ void search_Best(char side, char maxDepth, unsigned int nodeBudget, t_searchResu
 		if(SEARCH_ASPIRATION && !sc_abort && depth > 1 &&
 		   (score <= alpha || score >= beta))
 		{
+			STAT(++st_stats.m_researches);
 			working = *result;
+			TRACE((SEARCH_TRACE_ENTER, 0, depth, &sc_noMove,
+			       -EVAL_INFINITY, EVAL_INFINITY, 0));
 			score = searchRoot(side, depth, -EVAL_INFINITY, EVAL_INFINITY,
 			                   &working);
+			TRACE((SEARCH_TRACE_LEAVE, 0, depth, &sc_noMove,
+			       -EVAL_INFINITY, EVAL_INFINITY, score));
 		}
 #endif
 
 		// an aborted iteration is incomplete, so keep the last one that
 		// finished
 		if(sc_abort)
+		{
+			STAT(st_stats.m_aborted = 1);
+			STAT(st_stats.m_userStop = sc_userStop);
 			break;
+		}
 
 		*result = working;
 		result->m_score = score;
 		result->m_depth = depth;
+		STAT(st_stats.m_iterNodes[depth] = si_nodes);
+#if SEARCH_IDLE
+		if(sc_idle && sf_idleShown)
+			sf_idleShown(result);
+#endif
 
 #if SEARCH_FOLLOW_PV_ON
 		if(SEARCH_FOLLOW_PV)
@@ -1407,6 +1756,29 @@ char search_Interrupted(void)
 	return sc_userStop;
 }
 
+#if SEARCH_IDLE
+/*-----------------------------------------------------------------------*/
+// Not one of the game's moves, so it leaves the opening randomiser exactly
+// where it found it - the generator as well as the count - and the game
+// plays the same whether anyone sat and thought first or not
+int search_Idle(char side, t_searchResult *result, t_searchIdleFn shown)
+{
+	char rand = sc_rand, randMoves = sc_randMoves;
+
+	sc_idle = 1;
+	si_idleKey = 0;
+	sf_idleShown = shown;
+
+	search_Best(side, gcSearchSkill[SEARCH_NUM_SKILLS - 1].m_depth,
+	            (unsigned int)~0u, result);
+
+	sc_idle = 0;
+	sc_rand = rand;
+	sc_randMoves = randMoves;
+	return si_idleKey;
+}
+#endif
+
 #ifdef EVAL_TUNING
 /*-----------------------------------------------------------------------*/
 char search_TestPVLength(void)
@@ -1445,6 +1817,14 @@ unsigned int search_TestHistoryUsed(void)
 #endif
 }
 
+#if SEARCH_NUM_TIMED
+/*-----------------------------------------------------------------------*/
+void search_TestSetNodeRate(unsigned int rate)
+{
+	si_nodeRate = rate;
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Classic scoring without first placement - the baseline pickBest starts from.
 static void scoreMovesClassic(t_engMove *moves, char count, char ply)
@@ -17,8 +17,12 @@
 #include "types.h"
 #include "engine.h"
 
-// Deepest the quiescence search may run past the main search
+// Deepest the quiescence search may run past the main search.  Every per-ply
+// table is sized by it, and the triangular PV by its square, so a port only
+// raises it when it has the memory and a skill level that gets that deep
+#ifndef SEARCH_MAX_PLY
 #define SEARCH_MAX_PLY		12
+#endif
 
 // Exact-state switch keeps the old quiescence path for target A/B measurement.
 #ifndef SEARCH_QUIESCE_HISTORY
@@ -202,10 +206,60 @@ typedef struct tag_searchSkill
 	unsigned int	m_nodes;
 } t_searchSkill;
 
+// A port with a 32-bit int and the speed to spend it can add a fifth level
+// with -DSEARCH_NUM_SKILLS=5.  Its budget is over 65535, which is why int has
+// to be wide: the node count, the budget and this table are all unsigned int,
+// and search.c will not compile the level where that is 16 bits
+#ifndef SEARCH_NUM_SKILLS
 #define SEARCH_NUM_SKILLS	4
+#endif
 
 extern const t_searchSkill gcSearchSkill[SEARCH_NUM_SKILLS];
 
+// Levels set in seconds a move rather than nodes.  The node levels take
+// eleven minutes a move at "harder" on a stock C64 and a fraction of that on
+// an 8 MHz CX16, and nobody can ask either for "a minute a move".  A port that
+// has measured its rate - tests/c64search.c or its own equivalent, through a
+// real game rather than the opening - sets it in its make/ports file with
+// -DSEARCH_NPS, and gets SEARCH_NUM_TIMED more levels after the node ones.
+// The seconds become a node budget when the move starts; the depth cap is the
+// deepest node level's.  With SEARCH_NPS 0 there are none, and the node
+// levels are the same either way
+#ifndef SEARCH_NPS
+#define SEARCH_NPS			0
+#endif
+
+// With a clock() the port trusts, the rate can follow what the machine does:
+// an accelerator, a turbo mode, an emulator in warp, or a port nobody has
+// measured yet.  cpu.c times every search and hands the result over
+#ifndef SEARCH_RECALIBRATE
+#define SEARCH_RECALIBRATE	0
+#endif
+
+#if SEARCH_NPS
+#define SEARCH_NUM_TIMED	3
+#else
+#define SEARCH_NUM_TIMED	0
+#endif
+
+#if SEARCH_NUM_TIMED
+extern const unsigned char gcSearchSeconds[SEARCH_NUM_TIMED];
+
+// What "seconds" buys at the current rate, never less than the easiest node
+// level and never more than an unsigned int holds
+unsigned int search_TimedBudget(unsigned char seconds);
+
+// Nodes a second as things stand
+unsigned int search_NodeRate(void);
+
+#if SEARCH_RECALIBRATE
+// A search of "nodes" took "ticks" of clock().  Under a second says more
+// about the clock than the machine and is ignored; otherwise the rate moves a
+// quarter of the way toward it, so one odd position does not swing the level
+void search_Calibrate(unsigned int nodes, unsigned long ticks);
+#endif
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Search "side" to at most maxDepth, stopping early if nodeBudget is spent.
 // Iterative deepening means there is always a usable move from the last
@@ -216,6 +270,35 @@ void search_Best(char side, char maxDepth, unsigned int nodeBudget, t_searchResu
 // the menu, not because the node budget ran out
 char search_Interrupted(void);
 
+/*-----------------------------------------------------------------------*/
+// Thinking while nobody is at the keys.  With SEARCH_IDLE, human_Play runs
+// search_Idle on the position in front of the player instead of waiting in
+// plat_ReadKeys(1), so the hint key has an answer ready.  It is search_Best at
+// the deepest level's depth with all the nodes an unsigned int holds, with
+// three differences: every SEARCH_IDLE_SLICE nodes it asks plat_ReadKeys
+// whether anything at all was pressed, and stops and hands the key back if
+// so; each depth it finishes goes to "shown"; and it is not one of the game's
+// moves, so the opening randomiser is left where it was.
+//
+// The slice is the latency.  A 1 MHz machine manages a node in about a
+// thirtieth of a second, so 8 nodes is a key answered in a third of a
+// second, and a kbhit every 8 nodes costs nothing next to the nodes.  A fast
+// machine wants far more, or it spends its time asking.  A power of two
+#ifndef SEARCH_IDLE
+#define SEARCH_IDLE			0
+#endif
+
+#ifndef SEARCH_IDLE_SLICE
+#define SEARCH_IDLE_SLICE	8
+#endif
+
+#if SEARCH_IDLE
+typedef void (*t_searchIdleFn)(const t_searchResult *result);
+
+// The key that stopped it, or 0 when it ran to the end of its depth
+int search_Idle(char side, t_searchResult *result, t_searchIdleFn shown);
+#endif
+
 /*-----------------------------------------------------------------------*/
 // Start a game's opening randomisation from this seed, and restart the count
 // of randomised moves.  Called once a game, by the game.  Zero means no
@@ -229,6 +312,12 @@ void search_SetSeed(char seed);
 char search_Random(void);
 char search_Seeded(void);
 
+// The randomiser's whole state, the generator and how many moves it has
+// randomised, as one word.  For a harness that runs unseeded searches in the
+// middle of a seeded session and has to hand the session back as it found it
+unsigned int search_SeedState(void);
+void search_RestoreSeed(unsigned int state);
+
 /*-----------------------------------------------------------------------*/
 // Is the side to move mated, stalemated or fine?  Returns OUTCOME_CHECKMATE,
 // OUTCOME_STALEMATE or OUTCOME_OK.  With a real search this is just "are
@@ -254,6 +343,83 @@ char search_TestRootStored(void);
 
 // Non-zero history entries after the last search.  Zero when History is off.
 unsigned int search_TestHistoryUsed(void);
+
+#if SEARCH_NUM_TIMED
+// Put the node rate back where a test found it, after recalibrating it.
+void search_TestSetNodeRate(unsigned int rate);
+#endif
+#endif
+
+/*-----------------------------------------------------------------------*/
+// What the last search_Best spent its nodes on, for tuning move ordering
+// against without an ad-hoc build.  Host only: it is off unless a build asks,
+// and with it off not one counter is compiled, so the 8-bit targets pay
+// nothing.  tests/uci prints it as "info string stats" after every search
+#ifndef SEARCH_STATS
+#define SEARCH_STATS		0
+#endif
+
+#if SEARCH_STATS
+typedef struct tag_searchStats
+{
+	// every node the budget counted is one of these, except those the budget
+	// itself abandoned part way
+	unsigned long	m_pvNodes;		// raised alpha and did not cut
+	unsigned long	m_cutNodes;		// failed high
+	unsigned long	m_allNodes;		// failed low, mated or stalemated
+	unsigned long	m_drawNodes;	// a repetition or the fifty move rule
+	unsigned long	m_horizonNodes;	// depth 0, handed to quiescence
+	unsigned long	m_qNodes;		// quiescence
+
+	unsigned long	m_firstCuts;	// cut nodes whose first legal move cut
+	unsigned long	m_quietCuts;	// cutoffs by a quiet move
+	unsigned long	m_killerCuts;	// ... that was already a killer at its ply
+	unsigned long	m_genNodes;		// full-width nodes that generated
+	unsigned long	m_genMoves;		// moves they generated
+	unsigned long	m_searched;		// legal moves they searched
+
+	unsigned long	m_iterNodes[SEARCH_MAX_PLY + 1];	// nodes when depth d finished
+	unsigned int	m_arenaPeak;	// move arena high-water, of m_arenaSize
+	unsigned int	m_arenaSize;
+	char			m_researches;	// aspiration windows that failed
+	char			m_aborted;		// an iteration was abandoned on the budget
+	char			m_userStop;		// ... or on a key
+} t_searchStats;
+
+void search_Stats(t_searchStats *stats);
+#endif
+
+/*-----------------------------------------------------------------------*/
+// Every node as it is entered and left, handed to a host callback, so two
+// builds that should search the same tree can be shown to - or shown where
+// they stop.  Host only and off unless a build asks, like SEARCH_STATS; the
+// callback keeps stdio out of this file.  tests/searchtrace records and
+// compares the streams
+#ifndef SEARCH_TRACE
+#define SEARCH_TRACE		0
+#endif
+
+#if SEARCH_TRACE
+#define SEARCH_TRACE_ENTER	'E'		// about to search m_move, window as the child sees it
+#define SEARCH_TRACE_LEAVE	'L'		// ... and what it returned, from the child's side
+#define SEARCH_TRACE_QUIESCE	0x80	// or'd into the event when the child is quiescence
+
+typedef struct tag_searchTrace
+{
+	unsigned int	m_node;		// the node count at the event
+	char			m_event;
+	char			m_ply;		// the child's; 0 is the root, once per iteration
+	char			m_depth;	// remaining at the child, 0 in quiescence
+	t_engMove		m_move;		// the move into the child, empty at the root
+	int				m_alpha;
+	int				m_beta;
+	int				m_score;	// LEAVE only
+} t_searchTrace;
+
+typedef void (*t_searchTraceFn)(const t_searchTrace *event);
+
+// NULL switches it off again
+void search_SetTrace(t_searchTraceFn fn);
 #endif
 
 #if SEARCH_MOVE_CACHE
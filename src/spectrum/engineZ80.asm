@@ -0,0 +1,724 @@
+;
+;	engineZ80.asm
+;	cc65 Chess
+;
+;	Z80 kernels for the same three hot paths engine65.s covers on the 6502:
+;	the attack walk (eng_IsAttacked), the slider generator (eng_GenSlider)
+;	and the board half of make / unmake (eng_MakeBoard / eng_UnmakeBoard).
+;	engine.c is the reference and these have to agree with it exactly;
+;	zxsearch.c checks that on the machine by giving the same perft and search
+;	counts with and without them, and tests/kernelreplay.py checks on the
+;	host against every call a walk of the perft positions makes.
+;
+;	Only in the build when make/ports/spectrum.mk asks for it, which also
+;	sets ENGINE_ASM so engine.c drops its own versions.
+;
+;	What the Z80 has that sccz80 does not use here: (ix+d) reaches a fixed
+;	step from a square without an address sum, so the pawn, knight and king
+;	tests are unrolled off IX parked on the square; and IX parked on the
+;	argument block reads a parameter in one instruction rather than an
+;	HL = SP + n walk each time.
+;
+;	Calling convention is sccz80's default, which is what engine.c's plain
+;	prototypes get: arguments pushed left to right, a char as a word, caller
+;	pops, result in HL.  IX is the caller's and is saved; IY belongs to the
+;	ROM's interrupt handler and is not touched.
+;
+
+	SECTION	code_user
+
+	PUBLIC	_eng_IsAttacked
+	PUBLIC	_eng_GenSlider
+	PUBLIC	_eng_MakeBoard
+	PUBLIC	_eng_UnmakeBoard
+
+	EXTERN	_geBoard
+	EXTERN	_geCastle
+	EXTERN	_geEP
+	EXTERN	_geHalfmove
+	EXTERN	_geKing
+	EXTERN	_sc_maxMoves
+	EXTERN	_sc_capturesOnly
+
+; types.h / engine.h
+	defc	NONE		= 0
+	defc	ROOK		= 1
+	defc	KNIGHT		= 2
+	defc	BISHOP		= 3
+	defc	QUEEN		= 4
+	defc	KING		= 5
+	defc	PAWN		= 6
+
+	defc	ENG_NO_SQUARE	= $7F
+
+; ----------------------------------------------------------------------
+; HL = &geBoard[A].  Keeps BC and DE
+boardAt:
+	ld	hl,_geBoard
+	add	a,l
+	ld	l,a
+	adc	a,h
+	sub	l
+	ld	h,a
+	ret
+
+; ----------------------------------------------------------------------
+; char eng_IsAttacked(char square, char bySide)
+;
+; B the attacker's colour bit, C the square, D the piece byte a stepper test
+; wants.  The C asks in a fixed order but only for a yes or a no, so the
+; order here is free
+_eng_IsAttacked:
+	push	ix
+	ld	hl,4
+	add	hl,sp
+	ld	a,(hl)			; bySide
+	inc	hl
+	inc	hl
+	ld	c,(hl)			; square
+	or	a
+	jr	z,ia_side
+	ld	a,$80
+ia_side:
+	ld	b,a
+	ld	a,c
+	call	boardAt
+	push	hl
+	pop	ix			; IX = &geBoard[square]
+
+	; pawns.  A white pawn attacking the square sits below it, on +15 and
+	; +17; a black one above, on -17 and -15
+	ld	a,PAWN
+	or	b
+	ld	d,a
+	ld	a,b
+	or	a
+	jr	z,ia_blackPawns
+
+	ld	a,c
+	add	a,15
+	and	$88
+	jr	nz,ia_wp1
+	ld	a,(ix+15)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_wp1:
+	ld	a,c
+	add	a,17
+	and	$88
+	jr	nz,ia_knights
+	ld	a,(ix+17)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+	jr	ia_knights
+
+ia_blackPawns:
+	ld	a,c
+	add	a,-17
+	and	$88
+	jr	nz,ia_bp1
+	ld	a,(ix-17)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_bp1:
+	ld	a,c
+	add	a,-15
+	and	$88
+	jr	nz,ia_knights
+	ld	a,(ix-15)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+
+ia_knights:
+	ld	a,KNIGHT
+	or	b
+	ld	d,a
+
+	ld	a,c
+	add	a,-33
+	and	$88
+	jr	nz,ia_n1
+	ld	a,(ix-33)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n1:
+	ld	a,c
+	add	a,-31
+	and	$88
+	jr	nz,ia_n2
+	ld	a,(ix-31)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n2:
+	ld	a,c
+	add	a,-18
+	and	$88
+	jr	nz,ia_n3
+	ld	a,(ix-18)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n3:
+	ld	a,c
+	add	a,-14
+	and	$88
+	jr	nz,ia_n4
+	ld	a,(ix-14)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n4:
+	ld	a,c
+	add	a,14
+	and	$88
+	jr	nz,ia_n5
+	ld	a,(ix+14)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n5:
+	ld	a,c
+	add	a,18
+	and	$88
+	jr	nz,ia_n6
+	ld	a,(ix+18)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n6:
+	ld	a,c
+	add	a,31
+	and	$88
+	jr	nz,ia_n7
+	ld	a,(ix+31)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_n7:
+	ld	a,c
+	add	a,33
+	and	$88
+	jr	nz,ia_kings
+	ld	a,(ix+33)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+
+ia_kings:
+	ld	a,KING
+	or	b
+	ld	d,a
+
+	ld	a,c
+	add	a,-17
+	and	$88
+	jr	nz,ia_k1
+	ld	a,(ix-17)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_k1:
+	ld	a,c
+	add	a,-16
+	and	$88
+	jr	nz,ia_k2
+	ld	a,(ix-16)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_k2:
+	ld	a,c
+	add	a,-15
+	and	$88
+	jr	nz,ia_k3
+	ld	a,(ix-15)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_k3:
+	ld	a,c
+	add	a,-1
+	and	$88
+	jr	nz,ia_k4
+	ld	a,(ix-1)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_k4:
+	ld	a,c
+	add	a,1
+	and	$88
+	jr	nz,ia_k5
+	ld	a,(ix+1)
+	and	$87
+	cp	d
+	jp	z,ia_yes
+ia_k5:
+	ld	a,c
+	add	a,15
+	and	$88
+	jr	nz,ia_k6
+	ld	a,(ix+15)
+	and	$87
+	cp	d
+	jr	z,ia_yes
+ia_k6:
+	ld	a,c
+	add	a,16
+	and	$88
+	jr	nz,ia_k7
+	ld	a,(ix+16)
+	and	$87
+	cp	d
+	jr	z,ia_yes
+ia_k7:
+	ld	a,c
+	add	a,17
+	and	$88
+	jr	nz,ia_rays
+	ld	a,(ix+17)
+	and	$87
+	cp	d
+	jr	z,ia_yes
+
+	; rook, bishop and queen along the rays.  IX walks the table now: the
+	; step, then the slider other than the queen that moves that way.  E is
+	; the square being looked at
+ia_rays:
+	ld	ix,ia_rayTable
+ia_ray:
+	ld	a,(ix+0)
+	or	a
+	jr	z,ia_no
+	ld	d,(ix+1)
+	ld	e,c
+ia_walk:
+	ld	a,e
+	add	a,(ix+0)
+	ld	e,a
+	and	$88
+	jr	nz,ia_nextRay
+	ld	a,e
+	call	boardAt
+	ld	a,(hl)
+	and	7
+	jr	z,ia_walk
+	cp	QUEEN
+	jr	z,ia_colour
+	cp	d
+	jr	nz,ia_nextRay
+ia_colour:
+	ld	a,(hl)
+	and	$80
+	cp	b
+	jr	z,ia_yes
+ia_nextRay:
+	inc	ix
+	inc	ix
+	jr	ia_ray
+
+ia_no:
+	ld	hl,0
+	pop	ix
+	ret
+
+ia_yes:
+	ld	hl,1
+	pop	ix
+	ret
+
+; ----------------------------------------------------------------------
+; char eng_GenSlider(char from, char side, const signed char *steps, char numSteps,
+;                    t_engMove *moves, char count)
+;
+; IX on the arguments: +0 count, +2 moves, +4 numSteps, +6 steps, +8 side,
+; +10 from.  They are this call's own copies, so numSteps counts down in
+; place, steps walks in place and the step being followed sits in the spare
+; high byte at +5.  B the square, C count, DE the next free move
+_eng_GenSlider:
+	push	ix
+	ld	ix,4
+	add	ix,sp
+	ld	c,(ix+0)
+	ld	l,c
+	ld	h,0
+	add	hl,hl
+	add	hl,hl
+	ld	e,(ix+2)
+	ld	d,(ix+3)
+	add	hl,de
+	ex	de,hl
+
+gs_ray:
+	ld	a,(ix+4)
+	or	a
+	jr	z,gs_done
+	dec	(ix+4)
+	ld	l,(ix+6)
+	ld	h,(ix+7)
+	ld	a,(hl)
+	inc	hl
+	ld	(ix+6),l
+	ld	(ix+7),h
+	ld	(ix+5),a
+	ld	b,(ix+10)
+gs_step:
+	ld	a,b
+	add	a,(ix+5)
+	ld	b,a
+	and	$88
+	jr	nz,gs_ray
+	ld	a,b
+	call	boardAt
+	ld	a,(hl)
+	and	7
+	jr	nz,gs_blocker
+
+	; captures-only still walks the ray to find the blocker, it just does
+	; not write the empty squares down on the way
+	ld	a,(_sc_capturesOnly)
+	or	a
+	call	z,gs_add
+	jr	gs_step
+
+gs_blocker:
+	ld	a,(hl)
+	rlca
+	and	1
+	cp	(ix+8)
+	call	nz,gs_add
+	jr	gs_ray
+
+gs_done:
+	ld	l,c
+	ld	h,0
+	pop	ix
+	ret
+
+; B is the square moved to.  addMove in engine.c, bound by sc_maxMoves the
+; same way
+gs_add:
+	ld	a,(_sc_maxMoves)
+	ld	l,a
+	ld	a,c
+	cp	l
+	ret	nc
+	ld	a,(ix+10)
+	ld	(de),a
+	inc	de
+	ld	a,b
+	ld	(de),a
+	inc	de
+	xor	a
+	ld	(de),a
+	inc	de
+	ld	(de),a
+	inc	de
+	inc	c
+	ret
+
+; ----------------------------------------------------------------------
+; Shared by make and unmake, with IX on the move (+0 from, +1 to, +2 flags)
+; and C the piece whose colour decides which way is forward.
+
+; A = the square behind "to": the en passant victim, or the en passant
+; target after a double push
+behindTo:
+	ld	a,(ix+1)
+	bit	7,c
+	jr	z,bt_black
+	add	a,16
+	ret
+bt_black:
+	sub	16
+	ret
+
+; A = a square; a rook leaving it or taken on it loses that right.  Keeps
+; C, DE and IX
+revokeRights:
+	ld	b,$FE			; ~ENG_CASTLE_WK
+	cp	$77
+	jr	z,rr_hit
+	ld	b,$FD			; ~ENG_CASTLE_WQ
+	cp	$70
+	jr	z,rr_hit
+	ld	b,$FB			; ~ENG_CASTLE_BK
+	cp	$07
+	jr	z,rr_hit
+	ld	b,$F7			; ~ENG_CASTLE_BQ
+	or	a
+	ret	nz
+rr_hit:
+	ld	hl,_geCastle
+	ld	a,(hl)
+	and	b
+	ld	(hl),a
+	ret
+
+; DE = undo, IX = move, from the two arguments
+moveArgs:
+	ld	hl,6			; past this call's return, IX and the caller's return
+	add	hl,sp
+	ld	e,(hl)
+	inc	hl
+	ld	d,(hl)
+	inc	hl
+	ld	a,(hl)
+	inc	hl
+	ld	h,(hl)
+	ld	l,a
+	push	hl
+	pop	ix
+	ret
+
+; ----------------------------------------------------------------------
+; char eng_MakeBoard(const t_engMove *move, t_engUndo *undo)
+;
+; C the piece that moved, DE the undo record.  Returns the piece
+_eng_MakeBoard:
+	push	ix
+	call	moveArgs
+	ld	a,(ix+0)
+	call	boardAt
+	ld	c,(hl)
+
+	xor	a			; m_captured = NONE
+	ld	(de),a
+	inc	de
+	ld	a,(_geEP)
+	ld	(de),a
+	inc	de
+	ld	a,(_geCastle)
+	ld	(de),a
+	inc	de
+	ld	a,(_geHalfmove)
+	ld	(de),a
+	dec	de
+	dec	de
+	dec	de
+
+	ld	a,ENG_NO_SQUARE
+	ld	(_geEP),a
+	ld	hl,_geHalfmove
+	inc	(hl)
+
+	bit	3,(ix+2)		; ENG_MF_ENPASSANT
+	jr	z,mb_notEP
+	; the pawn taken sits beside the moving pawn, not on the target square
+	call	behindTo
+	call	boardAt
+	ld	a,(hl)
+	ld	(de),a
+	ld	(hl),NONE
+	xor	a
+	ld	(_geHalfmove),a
+	jr	mb_place
+
+mb_notEP:
+	ld	a,(ix+1)
+	call	boardAt
+	ld	a,(hl)
+	and	7
+	jr	z,mb_place
+	ld	a,(hl)
+	ld	(de),a
+	ld	a,(ix+1)
+	call	revokeRights
+	xor	a
+	ld	(_geHalfmove),a
+
+mb_place:
+	ld	a,(ix+2)
+	and	7			; ENG_MF_PROMO
+	jr	z,mb_plain
+	ld	b,a
+	ld	a,c
+	and	$80
+	or	b
+	jr	mb_store
+mb_plain:
+	ld	a,c
+mb_store:
+	ld	b,a
+	ld	a,(ix+1)
+	call	boardAt
+	ld	(hl),b
+	ld	a,(ix+0)
+	call	boardAt
+	ld	(hl),NONE
+
+	ld	a,c
+	and	7
+	cp	PAWN
+	jr	nz,mb_notPawn
+	xor	a
+	ld	(_geHalfmove),a
+	bit	6,(ix+2)		; ENG_MF_DOUBLEPUSH
+	jr	z,mb_done
+	call	behindTo
+	ld	(_geEP),a
+	jr	mb_done
+
+mb_notPawn:
+	cp	KING
+	jr	nz,mb_notKing
+	ld	hl,_geKing
+	bit	7,c
+	jr	z,mb_kingSide
+	inc	hl
+mb_kingSide:
+	ld	a,(ix+1)
+	ld	(hl),a
+	ld	a,$F3			; ~(ENG_CASTLE_BK|ENG_CASTLE_BQ)
+	bit	7,c
+	jr	z,mb_rights
+	ld	a,$FC			; ~(ENG_CASTLE_WK|ENG_CASTLE_WQ)
+mb_rights:
+	ld	hl,_geCastle
+	and	(hl)
+	ld	(hl),a
+
+	ld	a,(ix+1)
+	call	boardAt
+	bit	4,(ix+2)		; ENG_MF_CASTLE_K
+	jr	z,mb_queenSide
+	inc	hl
+	ld	a,(hl)			; to+1
+	ld	(hl),NONE
+	dec	hl
+	dec	hl
+	ld	(hl),a			; to-1
+	jr	mb_done
+mb_queenSide:
+	bit	5,(ix+2)		; ENG_MF_CASTLE_Q
+	jr	z,mb_done
+	dec	hl
+	dec	hl
+	ld	a,(hl)			; to-2
+	ld	(hl),NONE
+	inc	hl
+	inc	hl
+	inc	hl
+	ld	(hl),a			; to+1
+	jr	mb_done
+
+mb_notKing:
+	cp	ROOK
+	jr	nz,mb_done
+	ld	a,(ix+0)
+	call	revokeRights
+
+mb_done:
+	ld	l,c
+	ld	h,0
+	pop	ix
+	ret
+
+; ----------------------------------------------------------------------
+; char eng_UnmakeBoard(const t_engMove *move, const t_engUndo *undo)
+;
+; C the piece on "to", B the piece that moved - a promoted one turned back
+; into its pawn - DE the undo record.  Returns B
+_eng_UnmakeBoard:
+	push	ix
+	call	moveArgs
+	ld	a,(ix+1)
+	call	boardAt
+	ld	c,(hl)
+	ld	a,(ix+2)
+	and	7			; ENG_MF_PROMO
+	ld	a,c
+	jr	z,ub_moved
+	and	$80
+	or	PAWN
+ub_moved:
+	ld	b,a
+
+	inc	de
+	ld	a,(de)
+	ld	(_geEP),a
+	inc	de
+	ld	a,(de)
+	ld	(_geCastle),a
+	inc	de
+	ld	a,(de)
+	ld	(_geHalfmove),a
+	dec	de
+	dec	de
+	dec	de
+
+	ld	a,(ix+0)
+	call	boardAt
+	ld	(hl),b
+	ld	a,(ix+1)
+	call	boardAt
+	ld	(hl),NONE
+
+	bit	3,(ix+2)		; ENG_MF_ENPASSANT
+	jr	z,ub_notEP
+	call	behindTo
+	call	boardAt
+	ld	a,(de)
+	ld	(hl),a
+	jr	ub_king
+ub_notEP:
+	ld	a,(de)
+	and	7
+	jr	z,ub_king
+	ld	a,(de)
+	ld	(hl),a			; HL is still "to"
+
+ub_king:
+	ld	a,b
+	and	7
+	cp	KING
+	jr	nz,ub_done
+	ld	hl,_geKing
+	bit	7,c
+	jr	z,ub_kingSide
+	inc	hl
+ub_kingSide:
+	ld	a,(ix+0)
+	ld	(hl),a
+
+	ld	a,(ix+1)
+	call	boardAt
+	bit	4,(ix+2)		; ENG_MF_CASTLE_K
+	jr	z,ub_queenSide
+	dec	hl
+	ld	a,(hl)			; to-1
+	ld	(hl),NONE
+	inc	hl
+	inc	hl
+	ld	(hl),a			; to+1
+	jr	ub_done
+ub_queenSide:
+	bit	5,(ix+2)		; ENG_MF_CASTLE_Q
+	jr	z,ub_done
+	inc	hl
+	ld	a,(hl)			; to+1
+	ld	(hl),NONE
+	dec	hl
+	dec	hl
+	dec	hl
+	ld	(hl),a			; to-2
+
+ub_done:
+	ld	l,b
+	ld	h,0
+	pop	ix
+	ret
+
+; ----------------------------------------------------------------------
+	SECTION	rodata_user
+
+ia_rayTable:
+	defb	-16, ROOK, 16, ROOK, -1, ROOK, 1, ROOK
+	defb	-17, BISHOP, -15, BISHOP, 15, BISHOP, 17, BISHOP
+	defb	0
@@ -769,6 +769,8 @@ int plat_ReadKeys(char blocking)
 			keyMask |= INPUT_UNDO;
 		if(!(now[2] & 0x08) && (sc_prev[2] & 0x08))
 			keyMask |= INPUT_REDO;
+		if(!(now[6] & 0x10) && (sc_prev[6] & 0x10))
+			keyMask |= INPUT_HINT;
 
 		memcpy(sc_prev, now, 8);
 		if(keyMask || !blocking)
@@ -374,6 +374,10 @@ int plat_ReadKeys(char blocking)
 		case 'u':
 			keyMask |= INPUT_UNDO;
 			break;
+
+		case 'h':
+			keyMask |= INPUT_HINT;
+			break;
 			
 		// default:		// Debug - show key code
 		// {
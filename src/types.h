@@ -47,6 +47,7 @@
 #define INPUT_MENU			SET_BIT(9)
 #define INPUT_UNDO			SET_BIT(10)
 #define INPUT_REDO			SET_BIT(11)
+#define INPUT_HINT			SET_BIT(12)
 #define INPUT_UNDOREDO		(INPUT_UNDO | INPUT_REDO)
 #define INPUT_MOTION		(INPUT_UP | INPUT_RIGHT | INPUT_DOWN | INPUT_LEFT)
 #define INPUT_TOGGLE		(INPUT_TOGGLE_A | INPUT_TOGGLE_B | INPUT_TOGGLE_D)
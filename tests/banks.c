@@ -0,0 +1,89 @@
+/*
+ *	banks.c
+ *	cc65 Chess - test support
+ *
+ *	plat_Bank* as tests/platStub.c simulates it.  A table that sits behind
+ *	these has to get back what it put in, from every bank, and the switch
+ *	count it is priced by has to count switches and nothing else - a select
+ *	of the bank already showing is free on every machine this is for.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "plat.h"
+#include "testutil.h"
+
+#if PLAT_BANKS
+#define BANK_RECORD		6		// a move cache entry on cc65
+
+/*-----------------------------------------------------------------------*/
+static void fill(unsigned char *rec, int bank, unsigned int slot)
+{
+	char i;
+
+	for(i = 0; i < BANK_RECORD; ++i)
+		rec[(int)i] = (unsigned char)(bank * 31 + slot * 7 + i);
+}
+
+/*-----------------------------------------------------------------------*/
+int test_RunBanks(int verbose)
+{
+	unsigned char rec[BANK_RECORD], want[BANK_RECORD];
+	unsigned long selects0, switches0, bytes0, selects, switches, bytes;
+	unsigned int slot, perBank = PLAT_BANK_WINDOW / BANK_RECORD;
+	int bank, bad = 0, failures = 0;
+
+	printf("banked memory (%d banks of %u)\n", PLAT_BANKS, PLAT_BANK_WINDOW);
+	test_BankStats(&selects0, &switches0, &bytes0);
+
+	// every record in every bank, written a bank at a time...
+	for(bank = 0; bank < PLAT_BANKS; ++bank)
+	{
+		plat_BankSelect((char)bank);
+		for(slot = 0; slot < perBank; ++slot)
+		{
+			fill(rec, bank, slot);
+			plat_BankWrite(slot * BANK_RECORD, rec, BANK_RECORD);
+		}
+	}
+
+	// ...and read back interleaved, so every read is a switch
+	for(slot = 0; slot < perBank; ++slot)
+		for(bank = 0; bank < PLAT_BANKS; ++bank)
+		{
+			plat_BankSelect((char)bank);
+			plat_BankRead(slot * BANK_RECORD, rec, BANK_RECORD);
+			fill(want, bank, slot);
+			if(memcmp(rec, want, BANK_RECORD))
+				++bad;
+		}
+	if(bad)
+	{
+		printf("  %d records did not read back\n", bad);
+		++failures;
+	}
+
+	// a select of the bank on show is a select, not a switch.  The writes
+	// switch once a bank, once more if the last test left another showing,
+	// and the interleaved reads every time
+	plat_BankSelect((char)(PLAT_BANKS - 1));
+	test_BankStats(&selects, &switches, &bytes);
+	selects -= selects0;
+	switches -= switches0;
+	bytes -= bytes0;
+	if(verbose)
+		printf("  %lu selects, %lu switches, %lu bytes\n", selects, switches, bytes);
+	if(selects != PLAT_BANKS + (unsigned long)perBank * PLAT_BANKS + 1 ||
+	   bytes != 2UL * perBank * PLAT_BANKS * BANK_RECORD ||
+	   switches + 1 < (unsigned long)perBank * PLAT_BANKS + PLAT_BANKS ||
+	   switches > (unsigned long)perBank * PLAT_BANKS + PLAT_BANKS)
+	{
+		printf("  counted %lu selects, %lu switches, %lu bytes\n", selects, switches, bytes);
+		++failures;
+	}
+
+	printf("  -> %d failing\n", failures);
+	return failures;
+}
+#endif
@@ -0,0 +1,105 @@
+/*
+ *	bench.c
+ *	cc65 Chess - test support
+ *
+ *	See bench.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "search.h"
+#include "testutil.h"
+#include "bench.h"
+
+// More than a fixed-depth search here ever visits, and no more than a 16 bit
+// unsigned int, so a position that blows up is cut off the way a C64 would
+// cut it off rather than timing out the host
+#define BENCH_NODES		65535U
+
+// Openings, middlegames with tactics in them, and the endings the mate drive,
+// KBN and pawn races are about - each family of change moves some of these
+static const struct { const char *m_fen; char m_depth; } stc_bench[] =
+{
+	{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5 },
+	{ "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3", 4 },
+	{ "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/2N5/PPP2PPP/R1BQKB1R b KQkq - 2 5", 4 },
+	{ "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8", 3 },
+	{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3 },
+	{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4 },
+	{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3 },
+	{ "2r3k1/pp3ppp/2n1b3/3qp3/8/2P1PN2/PP1Q1PPP/R3KB1R w KQ - 0 12", 5 },
+	{ "6k1/2p3nr/6Q1/2bpP3/1p3R1P/3Bn2K/8/3qB3 w - - 5 1", 5 },
+	{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5 },
+	{ "8/5pk1/6p1/3P4/1p6/1P4P1/5PK1/8 w - - 0 40", 7 },
+	{ "8/5pk1/6p1/3R4/8/6P1/5PK1/8 w - - 0 40", 5 },
+	{ "8/2P5/8/8/3k4/8/5p2/4K3 w - - 0 1", 7 },
+	{ "8/8/8/4k3/8/8/8/R3K3 w - - 0 1", 5 },
+	{ "8/8/8/4k3/8/8/8/4KBN1 w - - 0 1", 6 },
+	{ "8/8/8/3k4/8/8/4q3/6K1 b - - 0 1", 5 },
+};
+
+#define NUM_BENCH	((int)(sizeof(stc_bench) / sizeof(stc_bench[0])))
+
+/*-----------------------------------------------------------------------*/
+void bench_Run(FILE *out, int verbose, int json, t_benchTotals *totals)
+{
+	unsigned int seed = search_SeedState();
+	int p;
+
+	memset(totals, 0, sizeof(*totals));
+
+	// the game's opening randomisation is the one thing that would make a
+	// search depend on what ran before it; every other piece of search state
+	// is cleared inside search_Best.  A uci session gets its seed back after
+	search_SetSeed(0);
+
+	if(json)
+		fprintf(out, "{\"positions\": [");
+	else if(verbose)
+		fprintf(out, "  %-3s %5s %6s %7s %6s  %s\n", "", "depth", "nodes", "score", "move", "fen");
+
+	for(p = 0; p < NUM_BENCH; ++p)
+	{
+		t_searchResult result;
+		char side = test_EngineSetFEN(stc_bench[p].m_fen), move[6];
+		clock_t taken;
+
+		geHalfmove = test_FENHalfmove(stc_bench[p].m_fen);
+		taken = clock();
+		search_Best(side, stc_bench[p].m_depth, BENCH_NODES, &result);
+		taken = clock() - taken;
+
+		totals->m_nodes += result.m_nodes;
+		totals->m_seconds += (double)taken / CLOCKS_PER_SEC;
+		++totals->m_positions;
+
+		memset(move, 0, sizeof(move));
+		if(result.m_haveMove)
+		{
+			test_TileName(ENG_TO_TILE(result.m_move.m_from), move);
+			test_TileName(ENG_TO_TILE(result.m_move.m_to), move + 2);
+		}
+
+		if(json)
+			fprintf(out, "%s\n  {\"fen\": \"%s\", \"depth\": %d, \"nodes\": %u, \"score\": %d, \"move\": \"%s\"}",
+			        p ? "," : "", stc_bench[p].m_fen, result.m_depth, result.m_nodes,
+			        result.m_score, move);
+		else if(verbose)
+			fprintf(out, "  %-3d %5d %6u %7d %6s  %s\n", p + 1, result.m_depth,
+			        result.m_nodes, result.m_score, move, stc_bench[p].m_fen);
+	}
+
+	if(json)
+		fprintf(out, "],\n \"nodes\": %lu, \"ms\": %.0f, \"nps\": %.0f}\n",
+		        totals->m_nodes, totals->m_seconds * 1000,
+		        totals->m_seconds > 0 ? totals->m_nodes / totals->m_seconds : 0);
+	else
+		fprintf(out, "bench: %lu nodes  %d positions  %.0f ms  %.0f nodes/sec\n",
+		        totals->m_nodes, totals->m_positions, totals->m_seconds * 1000,
+		        totals->m_seconds > 0 ? totals->m_nodes / totals->m_seconds : 0);
+	search_RestoreSeed(seed);
+}
@@ -0,0 +1,37 @@
+/*
+ *	bench.h
+ *	cc65 Chess - test support
+ *
+ *	One fixed list of positions, each searched to a fixed depth, and two
+ *	numbers out: the nodes all of it took, and how fast.  The node total is
+ *	the build's signature - the search is deterministic, so a change that
+ *	is not meant to alter play must leave it exactly where it was, and a
+ *	change that is meant to says so by moving it.  Nodes per second is the
+ *	other question, and is only comparable on the same host.
+ *
+ *	The signature belongs to a configuration, not to the source: any compile
+ *	switch that changes the tree moves it.  chesstest and uci agree today
+ *	because every switch chesstest forces on is either exact or off until a
+ *	test turns it on, but uci's is the one that ships.
+ *
+ *	  ./chesstest bench [-v] [--json]
+ *	  ./uci bench [json]        or "bench" at the prompt
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+
+typedef struct tag_benchTotals
+{
+	unsigned long	m_nodes;		// the signature
+	double			m_seconds;
+	int				m_positions;
+} t_benchTotals;
+
+// Search the list.  verbose prints a line a position, json prints one JSON
+// object instead of the text, both on "out"
+void bench_Run(FILE *out, int verbose, int json, t_benchTotals *totals);
+
+#endif //_BENCH_H_
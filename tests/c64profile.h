@@ -26,6 +26,24 @@
 
 extern char geSearchProfile;
 
+// The host cycle model (tests/cyclemodel) asks how often each row's work ran
+// rather than what doubling it cost, counted where the row doubles it: calls,
+// and the unit the row is priced in - moves for scoring, moves looked at for
+// selection, calls for the rest.  The 6502 profile builds leave it off, so
+// their timings carry no counting
+#ifndef PROFILE_COUNTS
+#define PROFILE_COUNTS		0
+#endif
+
+#if PROFILE_COUNTS
+extern unsigned long glProfileCalls[PROFILE_COMPONENTS + 1];
+extern unsigned long glProfileUnits[PROFILE_COMPONENTS + 1];
+#define PROFILE_COUNT(component, units) \
+	(++glProfileCalls[component], glProfileUnits[component] += (units))
+#else
+#define PROFILE_COUNT(component, units)	((void)0)
+#endif
+
 // A board-only make/unmake pair.  Evaluation, hash and history are suppressed
 // so their separately doubled rows do not overlap this one.
 void eng_ProfileBoardPair(const t_engMove *move);
@@ -0,0 +1,180 @@
+/*
+ *	capi.c
+ *	cc65 Chess - test support
+ *
+ *	cc65chess.h, called the way a driver calls it: text in, text out.  The
+ *	library is the engine, so every answer is checked against the engine
+ *	asked directly - a FEN back after every move and take-back, the key and
+ *	evaluation restored, perft against the published counts and a search
+ *	against search_Best.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "eval.h"
+#include "search.h"
+#include "testutil.h"
+#include "cc65chess.h"
+
+static int si_failures;
+
+/*-----------------------------------------------------------------------*/
+static void check(const char *what, long got, long want)
+{
+	if(got != want)
+	{
+		printf("    %-48s got %ld, wanted %ld\n", what, got, want);
+		++si_failures;
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+static void checkFEN(const char *what, const char *want)
+{
+	char fen[96];
+
+	cc65chess_GetFEN(fen);
+	if(strcmp(fen, want))
+	{
+		printf("    %-48s got %s\n    %-48s wanted %s\n", what, fen, "", want);
+		++si_failures;
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+// Castling both ways, en passant and a promotion, in SAN and long algebraic,
+// then every move taken back with the position checked at each step
+static void playAndTakeBack(void)
+{
+	static const char *sc_moves[] =
+	{
+		"e4", "d5", "e5", "f5", "exf6", "Nc6", "fxg7", "Be6", "gxh8=Q",
+		"Qd6", "Nf3", "O-O-O", "Bc4", "a6", "e1g1"
+	};
+	static const char *sc_fen =
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	enum { MOVES = sizeof(sc_moves) / sizeof(sc_moves[0]) };
+	char fens[MOVES + 1][96];
+	unsigned int keys[MOVES + 1];
+	int evals[MOVES + 1], i;
+
+	check("new game is white to move", cc65chess_NewGame(), CC65CHESS_WHITE);
+	checkFEN("start position", sc_fen);
+	for(i = 0; i < MOVES; ++i)
+	{
+		cc65chess_GetFEN(fens[i]);
+		keys[i] = cc65chess_HashKey();
+		evals[i] = cc65chess_Evaluate();
+		if(!cc65chess_MakeMove(sc_moves[i]))
+		{
+			printf("    %s refused after %s\n", sc_moves[i], fens[i]);
+			++si_failures;
+			return;
+		}
+	}
+	cc65chess_GetFEN(fens[MOVES]);
+	checkFEN("after the game", "2kr1bnQ/1pp1p2p/p1nqb3/3p4/2B5/5N2/PPPP1PPP/RNBQ1RK1 b - - 1 1");
+	check("side to move", cc65chess_SideToMove(), CC65CHESS_BLACK);
+	check("illegal move refused", cc65chess_MakeMove("e1g1"), 0);
+
+	for(i = MOVES - 1; i >= 0; --i)
+	{
+		check("take back", cc65chess_UnmakeMove(), 1);
+		checkFEN(sc_moves[i], fens[i]);
+		check("key restored", cc65chess_HashKey(), keys[i]);
+		check("eval restored", cc65chess_Evaluate(), evals[i]);
+	}
+	check("nothing left to take back", cc65chess_UnmakeMove(), 0);
+}
+
+/*-----------------------------------------------------------------------*/
+static void positions(void)
+{
+	static const char *sc_kiwipete =
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+	char list[1024];
+
+	check("kiwipete", cc65chess_SetFEN(sc_kiwipete), CC65CHESS_WHITE);
+	checkFEN("kiwipete back", sc_kiwipete);
+	check("kiwipete legal moves", cc65chess_LegalMoves(list, sizeof(list)), 48);
+	check("move list too small", cc65chess_LegalMoves(list, 16), -1);
+	check("kiwipete perft 3", cc65chess_Perft(3), 97862);
+	checkFEN("perft leaves the board", sc_kiwipete);
+	check("halfmove clock kept", cc65chess_SetFEN("8/8/8/4k3/8/8/4K3/7R b - - 37 60"),
+	      CC65CHESS_BLACK);
+	checkFEN("halfmove clock back", "8/8/8/4k3/8/8/4K3/7R b - - 37 1");
+	check("no black king refused", cc65chess_SetFEN("8/8/8/8/8/8/4K3/8 w - - 0 1"), -1);
+	checkFEN("refused FEN leaves the start position",
+	         "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+}
+
+/*-----------------------------------------------------------------------*/
+static void outcomes(void)
+{
+	static const char *sc_fool[] = { "f3", "e5", "g4", "Qh4#" };
+	static const char *sc_shuffle[] = { "Nf3", "Nf6", "Ng1", "Ng8" };
+	int i, round;
+
+	cc65chess_NewGame();
+	for(i = 0; i < 4; ++i)
+		cc65chess_MakeMove(sc_fool[i]);
+	check("fool's mate", cc65chess_Outcome(), CC65CHESS_CHECKMATE);
+
+	cc65chess_NewGame();
+	for(round = 0; round < 2; ++round)
+	{
+		check("not yet a threefold", cc65chess_Outcome(), CC65CHESS_PLAYING);
+		for(i = 0; i < 4; ++i)
+			cc65chess_MakeMove(sc_shuffle[i]);
+	}
+	check("threefold", cc65chess_Outcome(), CC65CHESS_REPETITION);
+
+	cc65chess_SetFEN("8/8/8/4k3/8/8/4K3/7R w - - 100 80");
+	check("fifty moves", cc65chess_Outcome(), CC65CHESS_FIFTY);
+	cc65chess_SetFEN("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+	check("stalemate", cc65chess_Outcome(), CC65CHESS_STALEMATE);
+}
+
+/*-----------------------------------------------------------------------*/
+static void searchAgrees(void)
+{
+	static const char *sc_fen = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3";
+	t_cc65chessResult result;
+	t_searchResult direct;
+	t_engMove move;
+
+	cc65chess_SetFEN(sc_fen);
+	check("search has a move", cc65chess_Search(4, 4000, &result), 1);
+	test_EngineSetFEN(sc_fen);
+	geHalfmove = 2;
+	search_Best(SIDE_WHITE, 4, 4000, &direct);
+	check("search score as search_Best", result.m_score, direct.m_score);
+	check("search nodes as search_Best", (long)result.m_nodes, (long)direct.m_nodes);
+	check("search move as search_Best",
+	      test_ParseMove(SIDE_WHITE, result.m_move, &move) &&
+	      move.m_from == direct.m_move.m_from && move.m_to == direct.m_move.m_to, 1);
+
+	cc65chess_SetFEN("7k/6Q1/6K1/8/8/8/8/8 b - - 0 1");
+	check("mated side has no move", cc65chess_Search(0, 0, &result), 0);
+	check("and no move text", result.m_move[0], 0);
+}
+
+/*-----------------------------------------------------------------------*/
+int test_RunCApi(int verbose)
+{
+	(void)verbose;
+	si_failures = 0;
+
+	check("API version", cc65chess_Version(), CC65CHESS_API_VERSION);
+	check("max ply", cc65chess_MaxPly(), SEARCH_MAX_PLY);
+	playAndTakeBack();
+	positions();
+	outcomes();
+	searchAgrees();
+
+	printf("library API: %d failing\n", si_failures);
+	return si_failures;
+}
@@ -0,0 +1,210 @@
+/*
+ *	cc65chess.c
+ *	cc65 Chess - test support
+ *
+ *	See cc65chess.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "eval.h"
+#include "search.h"
+#include "testutil.h"
+#include "cc65chess.h"
+
+#define MAX_GAME_PLIES	1024
+#define MAX_NODES		65535		// what a 16 bit unsigned int can hold on the target
+
+// The piece enum indexed directly: ROOK 1, KNIGHT 2, BISHOP 3, QUEEN 4
+static const char sc_promoChar[] = ".rnbqkp";
+
+static char s_side = SIDE_WHITE;
+
+// What cc65chess_UnmakeMove takes back
+static t_engMove s_moves[MAX_GAME_PLIES];
+static t_engUndo s_undo[MAX_GAME_PLIES];
+static int s_ply;
+
+/*-----------------------------------------------------------------------*/
+static void moveName(const t_engMove *move, char *out6)
+{
+	char promo = move->m_flags & ENG_MF_PROMO;
+
+	memset(out6, 0, 6);
+	test_TileName(ENG_TO_TILE(move->m_from), out6);
+	test_TileName(ENG_TO_TILE(move->m_to), out6 + 2);
+	if(promo)
+		out6[4] = sc_promoChar[promo];
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_Version(void)
+{
+	return CC65CHESS_API_VERSION;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_NewGame(void)
+{
+	eng_SetStartPosition();
+	s_side = SIDE_WHITE;
+	s_ply = 0;
+	return s_side;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_SetFEN(const char *fen)
+{
+	char side = test_EngineSetFEN(fen);
+
+	s_ply = 0;
+	if(ENG_OFFBOARD(geKing[SIDE_WHITE]) || ENG_OFFBOARD(geKing[SIDE_BLACK]) ||
+	   KING != (geBoard[geKing[SIDE_WHITE]] & PIECE_DATA) ||
+	   KING != (geBoard[geKing[SIDE_BLACK]] & PIECE_DATA))
+	{
+		cc65chess_NewGame();
+		return -1;
+	}
+	geHalfmove = test_FENHalfmove(fen);
+	s_side = side;
+	return s_side;
+}
+
+/*-----------------------------------------------------------------------*/
+void cc65chess_GetFEN(char *out)
+{
+	test_EngineGetFEN(s_side, out);
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_SideToMove(void)
+{
+	return s_side;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_LegalMoves(char *out, int bytes)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	char count = eng_GenLegalMoves(s_side, moves), i;
+	int used = 0;
+
+	if(bytes < 1)
+		return -1;
+	out[0] = '\0';
+	for(i = 0; i < count; ++i)
+	{
+		char name[6];
+		int length;
+
+		moveName(&moves[i], name);
+		length = (int)strlen(name) + (i ? 1 : 0);
+		if(used + length + 1 > bytes)
+			return -1;
+		sprintf(out + used, i ? " %s" : "%s", name);
+		used += length;
+	}
+	return count;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_MakeMove(const char *move)
+{
+	t_engMove parsed;
+
+	if(s_ply >= MAX_GAME_PLIES || !test_ParseMove(s_side, move, &parsed))
+		return 0;
+
+	s_moves[s_ply] = parsed;
+	eng_Make(&s_moves[s_ply], &s_undo[s_ply]);
+	++s_ply;
+	s_side = 1 - s_side;
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_UnmakeMove(void)
+{
+	if(!s_ply)
+		return 0;
+
+	--s_ply;
+	eng_Unmake(&s_moves[s_ply], &s_undo[s_ply]);
+	s_side = 1 - s_side;
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_Outcome(void)
+{
+	char outcome = search_Outcome(s_side);
+
+	if(OUTCOME_CHECKMATE == outcome)
+		return CC65CHESS_CHECKMATE;
+	if(OUTCOME_STALEMATE == outcome)
+		return CC65CHESS_STALEMATE;
+	if(geHalfmove >= 100)
+		return CC65CHESS_FIFTY;
+	if(eng_IsRepetition(2))
+		return CC65CHESS_REPETITION;
+	return CC65CHESS_PLAYING;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_Evaluate(void)
+{
+	return eval_Position(s_side);
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_Search(int depth, unsigned int nodes, t_cc65chessResult *result)
+{
+	t_searchResult found;
+
+	if(depth < 1)
+		depth = gcSearchSkill[SEARCH_NUM_SKILLS - 1].m_depth;
+	if(depth > SEARCH_MAX_PLY)
+		depth = SEARCH_MAX_PLY;
+	if(!nodes)
+		nodes = gcSearchSkill[SEARCH_NUM_SKILLS - 1].m_nodes;
+	if(nodes > MAX_NODES)
+		nodes = MAX_NODES;
+
+	search_Best(s_side, (char)depth, nodes, &found);
+
+	memset(result, 0, sizeof(*result));
+	result->m_score = found.m_score;
+	result->m_depth = found.m_depth;
+	result->m_nodes = found.m_nodes;
+	if(!found.m_haveMove)
+		return 0;
+	moveName(&found.m_move, result->m_move);
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+int cc65chess_MaxPly(void)
+{
+	return SEARCH_MAX_PLY;
+}
+
+/*-----------------------------------------------------------------------*/
+unsigned int cc65chess_HashKey(void)
+{
+	return eng_PositionKey();
+}
+
+/*-----------------------------------------------------------------------*/
+unsigned long long cc65chess_Perft(int depth)
+{
+	unsigned long long nodes;
+
+	// nothing in a perft reads the repetition history, so it is not kept
+	eng_HistoryEnable(0);
+	nodes = test_EnginePerft(s_side, depth);
+	eng_HistoryEnable(1);
+	return nodes;
+}
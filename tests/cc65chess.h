@@ -0,0 +1,108 @@
+/*
+ *	cc65chess.h
+ *	cc65 Chess - test support
+ *
+ *	The engine as a library, for drivers that would otherwise start tests/uci
+ *	and talk to it over a pipe.  make libcc65chess.so builds engine.c,
+ *	eval.c and search.c with this API and nothing else exported;
+ *	tests/cc65chess.py is the ctypes binding.
+ *
+ *	Built like tests/uci, without EVAL_TUNING, so what is evaluated and
+ *	searched is what ships.  Node budgets are clamped to 65535 for the same
+ *	reason uci clamps them.
+ *
+ *	There is one engine per process: the board is the engine's globals, so
+ *	every call works on the same position and none of it is thread-safe.
+ *	Parallel drivers use processes, the way tests/datagen does.
+ *
+ *	Moves are text.  Anything test_ParseMove takes goes in - e2e4, e7e8q,
+ *	SAN such as Nf3 or O-O - and long algebraic comes out.  Scores are
+ *	centipawns from the side to move's view; mate is CC65CHESS_MATE less the
+ *	plies to it.  Functions that can fail return 0 or a negative number.
+ *
+ *	CC65CHESS_API_VERSION changes when anything here does.  A binding checks
+ *	cc65chess_Version() against the number it was written for.
+ */
+
+#ifndef _CC65CHESS_H_
+#define _CC65CHESS_H_
+
+#define CC65CHESS_API_VERSION	3
+
+#define CC65CHESS_WHITE			1
+#define CC65CHESS_BLACK			0
+
+#define CC65CHESS_MATE			29000		// EVAL_MATE
+
+// cc65chess_Outcome
+#define CC65CHESS_PLAYING		0
+#define CC65CHESS_CHECKMATE		1
+#define CC65CHESS_STALEMATE		2
+#define CC65CHESS_FIFTY			3
+#define CC65CHESS_REPETITION	4
+
+#if defined(__GNUC__)
+#define CC65CHESS_API	__attribute__((visibility("default")))
+#else
+#define CC65CHESS_API
+#endif
+
+typedef struct tag_cc65chessResult
+{
+	char			m_move[6];		// long algebraic, "" when there is no move
+	int				m_score;		// side to move's view
+	int				m_depth;		// deepest iteration completed
+	unsigned int	m_nodes;
+} t_cc65chessResult;
+
+/*-----------------------------------------------------------------------*/
+CC65CHESS_API int cc65chess_Version(void);
+
+// The start position, or a FEN with its halfmove clock.  Either clears the
+// move stack and the repetition history.  Returns the side to move, or -1
+// if the FEN has no king of either colour
+CC65CHESS_API int cc65chess_NewGame(void);
+CC65CHESS_API int cc65chess_SetFEN(const char *fen);
+
+// "out" needs 96 bytes.  The move number is always 1
+CC65CHESS_API void cc65chess_GetFEN(char *out);
+CC65CHESS_API int cc65chess_SideToMove(void);
+
+/*-----------------------------------------------------------------------*/
+// The legal moves, long algebraic, space separated, into "out" of "bytes".
+// Returns the count, or -1 if they did not fit
+CC65CHESS_API int cc65chess_LegalMoves(char *out, int bytes);
+
+// Play a move, or take the last one back.  1 on success, 0 if the move is
+// not legal here or there is nothing to take back
+CC65CHESS_API int cc65chess_MakeMove(const char *move);
+CC65CHESS_API int cc65chess_UnmakeMove(void);
+
+// One of CC65CHESS_PLAYING etc. for the side to move.  Threefold and fifty
+// moves are what a game is drawn by, not the search's single repeat
+CC65CHESS_API int cc65chess_Outcome(void);
+
+/*-----------------------------------------------------------------------*/
+// eval_Position for the side to move
+CC65CHESS_API int cc65chess_Evaluate(void);
+
+// search_Best for the side to move.  depth 0 and nodes 0 take the strongest
+// menu level's.  Returns 1 if there was a move, 0 if the game is over
+CC65CHESS_API int cc65chess_Search(int depth, unsigned int nodes, t_cc65chessResult *result);
+
+// SEARCH_MAX_PLY as this library was built: the deepest a search goes, and
+// so how far below CC65CHESS_MATE a score can still be a mate
+CC65CHESS_API int cc65chess_MaxPly(void);
+
+/*-----------------------------------------------------------------------*/
+// eng_PositionKey: the piece placement, castling rights and en passant file,
+// the key the repetition history and the opening book use.  16 bits on the
+// 8-bit targets and here; not the side to move
+CC65CHESS_API unsigned int cc65chess_HashKey(void);
+
+// Leaf count to "depth": test_EnginePerft, the count tests/engineperft.c
+// checks against the published tables.  64 bits, since depth 6 from most
+// positions is past 32; the first call allocates its 64 MB hash
+CC65CHESS_API unsigned long long cc65chess_Perft(int depth);
+
+#endif //_CC65CHESS_H_
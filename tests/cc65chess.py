@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+ctypes binding for libcc65chess.so (tests/cc65chess.h), so a batch script
+calls the engine instead of starting tests/uci and parsing what it prints.
+
+  make libcc65chess.so
+  from cc65chess import Engine
+  e = Engine()
+  e.set_fen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3")
+  e.legal_moves(), e.evaluate(), e.search(nodes=8000)
+  e.push("Bb5"); e.pop()
+
+One engine per process - the library is the engine's globals - so parallel
+work is multiprocessing, one Engine in each worker.
+
+  ./cc65chess.py [FEN]     legal moves, eval, perft 1..3 and a search
+"""
+
+from __future__ import annotations
+
+import ctypes
+import os
+import sys
+
+API_VERSION = 3
+MATE = 29000
+
+OUTCOMES = ("playing", "checkmate", "stalemate", "fifty", "repetition")
+
+
+class Result(ctypes.Structure):
+    _fields_ = [
+        ("move", ctypes.c_char * 6),
+        ("score", ctypes.c_int),
+        ("depth", ctypes.c_int),
+        ("nodes", ctypes.c_uint),
+    ]
+
+
+def _load(path: str | None) -> ctypes.CDLL:
+    path = path or os.path.join(os.path.dirname(os.path.abspath(__file__)), "libcc65chess.so")
+    lib = ctypes.CDLL(path)
+    signatures = {
+        "cc65chess_Version": ([], ctypes.c_int),
+        "cc65chess_NewGame": ([], ctypes.c_int),
+        "cc65chess_SetFEN": ([ctypes.c_char_p], ctypes.c_int),
+        "cc65chess_GetFEN": ([ctypes.c_char_p], None),
+        "cc65chess_SideToMove": ([], ctypes.c_int),
+        "cc65chess_LegalMoves": ([ctypes.c_char_p, ctypes.c_int], ctypes.c_int),
+        "cc65chess_MakeMove": ([ctypes.c_char_p], ctypes.c_int),
+        "cc65chess_UnmakeMove": ([], ctypes.c_int),
+        "cc65chess_Outcome": ([], ctypes.c_int),
+        "cc65chess_Evaluate": ([], ctypes.c_int),
+        "cc65chess_Search": ([ctypes.c_int, ctypes.c_uint, ctypes.POINTER(Result)], ctypes.c_int),
+        "cc65chess_MaxPly": ([], ctypes.c_int),
+        "cc65chess_HashKey": ([], ctypes.c_uint),
+        "cc65chess_Perft": ([ctypes.c_int], ctypes.c_ulonglong),
+    }
+    for name, (args, result) in signatures.items():
+        function = getattr(lib, name)
+        function.argtypes = args
+        function.restype = result
+    version = lib.cc65chess_Version()
+    if version != API_VERSION:
+        raise RuntimeError(f"{path}: API version {version}, this binding is {API_VERSION}")
+    return lib
+
+
+class Engine:
+    """The position lives in the library; this is a handle on it."""
+
+    def __init__(self, path: str | None = None):
+        self._lib = _load(path)
+        self._lib.cc65chess_NewGame()
+
+    def new_game(self) -> None:
+        self._lib.cc65chess_NewGame()
+
+    def set_fen(self, fen: str) -> None:
+        if self._lib.cc65chess_SetFEN(fen.encode()) < 0:
+            raise ValueError(f"not a position: {fen}")
+
+    def fen(self) -> str:
+        out = ctypes.create_string_buffer(96)
+        self._lib.cc65chess_GetFEN(out)
+        return out.value.decode()
+
+    def white_to_move(self) -> bool:
+        return self._lib.cc65chess_SideToMove() == 1
+
+    def legal_moves(self) -> list[str]:
+        out = ctypes.create_string_buffer(1024)
+        if self._lib.cc65chess_LegalMoves(out, len(out)) < 0:
+            raise RuntimeError("move list did not fit")
+        return out.value.decode().split()
+
+    def push(self, move: str) -> None:
+        """Long algebraic or SAN."""
+        if not self._lib.cc65chess_MakeMove(move.encode()):
+            raise ValueError(f"illegal move {move} in {self.fen()}")
+
+    def pop(self) -> None:
+        if not self._lib.cc65chess_UnmakeMove():
+            raise IndexError("no move to take back")
+
+    def outcome(self) -> str:
+        return OUTCOMES[self._lib.cc65chess_Outcome()]
+
+    def evaluate(self) -> int:
+        """Static eval, side to move's view."""
+        return self._lib.cc65chess_Evaluate()
+
+    def search(self, depth: int = 0, nodes: int = 0) -> Result:
+        """Side to move's view.  result.move is b"" when the game is over."""
+        result = Result()
+        self._lib.cc65chess_Search(depth, nodes, ctypes.byref(result))
+        return result
+
+    def max_ply(self) -> int:
+        """SEARCH_MAX_PLY of this build: a score past MATE - max_ply() is a mate."""
+        return self._lib.cc65chess_MaxPly()
+
+    def hash_key(self) -> int:
+        return self._lib.cc65chess_HashKey()
+
+    def perft(self, depth: int) -> int:
+        return self._lib.cc65chess_Perft(depth)
+
+
+def main() -> int:
+    engine = Engine()
+    if len(sys.argv) > 1:
+        engine.set_fen(" ".join(sys.argv[1:]))
+    print(engine.fen())
+    moves = engine.legal_moves()
+    print(f"{len(moves)} moves: {' '.join(moves)}")
+    print(f"eval {engine.evaluate()}  key {engine.hash_key():04x}  {engine.outcome()}")
+    for depth in (1, 2, 3):
+        print(f"perft {depth} {engine.perft(depth)}")
+    result = engine.search()
+    score = result.score
+    mate = (MATE - abs(score) + 1) // 2
+    text = f"mate {mate if score > 0 else -mate}" if abs(score) > MATE - engine.max_ply() else f"cp {score}"
+    print(f"bestmove {result.move.decode() or '0000'}  {text}  depth {result.depth}  nodes {result.nodes}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,7 +11,11 @@
  *
  *	Built like tests/uci, without EVAL_TUNING, so the eval is what ships.
  *
+ *	TSV is for reading; --bin writes the same rows as posfile.h records,
+ *	streamed a game at a time, for tests/tune to map instead of parse.
+ *
  *	  ./collectpos --split train --nodes 1200 --depth 4 --out train.tsv
+ *	  ./collectpos --split train --bin --out train.bin
  *	  ./collectpos --eval book.epd
  */
 
@@ -25,6 +29,7 @@
 #include "search.h"
 #include "board.h"
 #include "undo.h"
+#include "posfile.h"
 #include "testutil.h"
 
 #define MAX_BOOK		256
@@ -34,6 +39,7 @@
 typedef struct tag_Snap
 {
 	char	m_fen[FEN_BYTES];
+	unsigned char m_record[POSFILE_RECORD];
 	int		m_eval;
 	int		m_ply;
 	char	m_stm;
@@ -70,7 +76,7 @@ static int loadBook(const char *path)
 }
 
 /*-----------------------------------------------------------------------*/
-static int playGame(const char *fen, int depth, unsigned int nodes,
+static int playGame(const char *fen, int opening, int depth, unsigned int nodes,
                     t_Snap *snaps, int *nSnaps)
 {
 	char side = test_EngineSetFEN(fen);
@@ -98,6 +104,9 @@ static int playGame(const char *fen, int depth, unsigned int nodes,
 		{
 			test_EngineGetFEN(side, snaps[*nSnaps].m_fen);
 			snaps[*nSnaps].m_eval = eval_Position(SIDE_WHITE);
+			// the result is not known yet; main fills it in
+			posfile_Pack(side, 1, snaps[*nSnaps].m_eval, ply, opening, nodes,
+			             snaps[*nSnaps].m_record);
 			snaps[*nSnaps].m_ply = ply;
 			snaps[*nSnaps].m_stm = side;
 			++*nSnaps;
@@ -130,7 +139,7 @@ static void usage(void)
 {
 	fprintf(stderr,
 		"usage: collectpos [--book FILE] [--split train|val|all]\n"
-		"                  [--nodes N] [--depth D] [--out FILE]\n"
+		"                  [--nodes N] [--depth D] [--bin] [--out FILE]\n"
 		"       collectpos --eval FILE\n");
 }
 
@@ -143,6 +152,7 @@ int main(int argc, char **argv)
 	int depth = 4;
 	int nodes = 1200;
 	int evalOnly = 0;
+	int binary = 0;
 	const char *evalFile = 0;
 	int i, nGames, nPos;
 	FILE *out;
@@ -160,6 +170,8 @@ int main(int argc, char **argv)
 			depth = atoi(argv[++i]);
 		else if(0 == strcmp(argv[i], "--out") && i + 1 < argc)
 			outPath = argv[++i];
+		else if(0 == strcmp(argv[i], "--bin"))
+			binary = 1;
 		else if(0 == strcmp(argv[i], "--eval") && i + 1 < argc)
 		{
 			evalOnly = 1;
@@ -216,16 +228,19 @@ int main(int argc, char **argv)
 	if(!loadBook(book))
 		return 1;
 
-	out = outPath ? fopen(outPath, "w") : stdout;
-	if(!out)
+	out = outPath ? fopen(outPath, binary ? "wb" : "w") : stdout;
+	if(!out || (binary && !posfile_WriteHeader(out)))
 	{
-		fprintf(stderr, "collectpos: cannot write %s\n", outPath);
+		fprintf(stderr, "collectpos: cannot write %s\n", outPath ? outPath : "stdout");
 		return 1;
 	}
 
-	fprintf(out, "# split=%s nodes=%d depth=%d book=%s nbook=%d\n",
-	        split, nodes, depth, book, st_nbook);
-	fprintf(out, "opening\tskill_nodes\tply\tstm\tresult\teval\tfen\n");
+	if(!binary)
+	{
+		fprintf(out, "# split=%s nodes=%d depth=%d book=%s nbook=%d\n",
+		        split, nodes, depth, book, st_nbook);
+		fprintf(out, "opening\tskill_nodes\tply\tstm\tresult\teval\tfen\n");
+	}
 
 	nGames = 0;
 	nPos = 0;
@@ -236,10 +251,21 @@ int main(int argc, char **argv)
 		if(!wantOpening(i, split))
 			continue;
 
-		result = playGame(st_book[i], depth, (unsigned int)nodes, snaps, &nSnaps);
+		result = playGame(st_book[i], i, depth, (unsigned int)nodes, snaps, &nSnaps);
 		++nGames;
 		for(s = 0; s < nSnaps; ++s)
 		{
+			if(binary)
+			{
+				posfile_SetResult(snaps[s].m_record, (char)result);
+				if(!posfile_Append(out, snaps[s].m_record))
+				{
+					fprintf(stderr, "collectpos: cannot write %s\n", outPath ? outPath : "stdout");
+					return 1;
+				}
+				++nPos;
+				continue;
+			}
 			fprintf(out, "%d\t%d\t%d\t%c\t%s\t%d\t%s\n",
 			        i, nodes, snaps[s].m_ply,
 			        snaps[s].m_stm == SIDE_WHITE ? 'w' : 'b',
@@ -0,0 +1,468 @@
+/*
+ *	datagen.c
+ *	cc65 Chess - test support
+ *
+ *	collectpos at scale.  The engine is one set of globals, so parallel
+ *	means processes: --jobs workers are forked, worker w plays games w,
+ *	w + jobs, w + 2 * jobs ... and writes each finished game down its own
+ *	pipe.  The parent takes game 0 from pipe 0, game 1 from pipe 1 and so on,
+ *	drops positions it has already written (posfile_Key) and streams the
+ *	rest into one posfile.h file.  The workers share nothing and the parent
+ *	only copies bytes, so games per second goes with the core count, and the
+ *	output is the same file whatever --jobs was.
+ *
+ *	Game g starts from the (g mod n)th opening of the split, n the openings
+ *	in it, so --split does what it does in collectpos: even book.epd lines
+ *	train, odd lines val, and a position from one cannot be in the other
+ *	unless play transposes into it.  Then --random plies of uniformly random
+ *	legal moves, from srand(seed + g), so the same opening played again is a
+ *	different game.  Those plies are not written.  After them every root
+ *	position is, with the shipping search's score for it, the static eval
+ *	texel_Load checks against, and the game's result.
+ *
+ *	Built like collectpos, without EVAL_TUNING.
+ *
+ *	  ./datagen --split train --games 20000 --out train.bin
+ *	  ./datagen --split val --games 2000 --jobs 4 --seed 7 --out val.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "eval.h"
+#include "search.h"
+#include "board.h"
+#include "undo.h"
+#include "posfile.h"
+#include "testutil.h"
+
+#define MAX_BOOK		256
+#define MAX_JOBS		64
+#define MAX_PLIES		240
+#define MAX_RANDOM		32
+#define FEN_BYTES		96
+
+typedef struct tag_genOptions
+{
+	int		m_games;
+	int		m_jobs;
+	int		m_random;
+	int		m_depth;
+	int		m_seed;
+	int		m_nodes;
+} t_genOptions;
+
+// What a worker sends for one game: this, then m_count records
+typedef struct tag_gameHeader
+{
+	int		m_game;
+	int		m_count;
+	int		m_result;
+} t_gameHeader;
+
+static char st_book[MAX_BOOK][FEN_BYTES];
+static int st_opening[MAX_BOOK];		// book index of each opening in the split
+static int st_nbook, st_nsplit;
+
+// Positions already written, open addressing on posfile_Key
+static unsigned long long *st_seen;
+static long st_seenSize, st_seenCount;
+
+/*-----------------------------------------------------------------------*/
+static int loadBook(const char *path, const char *split)
+{
+	FILE *fp = fopen(path, "r");
+	char line[256];
+	size_t len;
+
+	if(!fp)
+	{
+		fprintf(stderr, "datagen: cannot open %s\n", path);
+		return 0;
+	}
+	st_nbook = st_nsplit = 0;
+	while(st_nbook < MAX_BOOK && fgets(line, sizeof(line), fp))
+	{
+		char *nl = strpbrk(line, "\r\n");
+		if(nl)
+			*nl = '\0';
+		if(!line[0] || line[0] == '#')
+			continue;
+		len = strlen(line);
+		if(len > FEN_BYTES - 1)
+			len = FEN_BYTES - 1;
+		memcpy(st_book[st_nbook], line, len);
+		st_book[st_nbook][len] = '\0';
+		// the same split as collectpos: even lines train, odd lines val
+		if(0 == strcmp(split, "all") || (0 == strcmp(split, "train")) == !(st_nbook % 2))
+			st_opening[st_nsplit++] = st_nbook;
+		++st_nbook;
+	}
+	fclose(fp);
+	if(!st_nsplit)
+		fprintf(stderr, "datagen: no %s openings in %s\n", split, path);
+	return st_nsplit > 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static int writeAll(int fd, const void *data, size_t bytes)
+{
+	const char *p = (const char *)data;
+
+	while(bytes)
+	{
+		ssize_t n = write(fd, p, bytes);
+
+		if(n < 0 && EINTR == errno)
+			continue;
+		if(n <= 0)
+			return 0;
+		p += n;
+		bytes -= (size_t)n;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+static int readAll(int fd, void *data, size_t bytes)
+{
+	char *p = (char *)data;
+
+	while(bytes)
+	{
+		ssize_t n = read(fd, p, bytes);
+
+		if(n < 0 && EINTR == errno)
+			continue;
+		if(n <= 0)
+			return 0;
+		p += n;
+		bytes -= (size_t)n;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+// The random opening plies.  Returns 0 if they walked into a finished game
+static int randomPlies(int plies, char *side)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	int ply;
+
+	for(ply = 0; ply < plies; ++ply)
+	{
+		char count = eng_GenLegalMoves(*side, moves);
+
+		if(!count)
+			return 0;
+		board_ApplyMove(&moves[rand() % count], *side);
+		*side = 1 - *side;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+// One game into records, labelled by the result.  Returns the record count
+static int playGame(int game, const t_genOptions *options, unsigned char *records,
+                    int *outcome)
+{
+	int opening = st_opening[game % st_nsplit], tries, ply, count = 0;
+	char side = SIDE_WHITE;
+
+	srand((unsigned int)(options->m_seed + game));
+	*outcome = 1;
+
+	// a walk that mates or stalemates inside the random plies is walked again
+	for(tries = 0; tries < 8; ++tries)
+	{
+		side = test_EngineSetFEN(st_book[opening]);
+		undo_Init();
+		board_SyncDisplay();
+		if(randomPlies(options->m_random, &side))
+			break;
+	}
+	if(8 == tries)
+		return 0;
+
+	for(ply = options->m_random; ply < options->m_random + MAX_PLIES; ++ply)
+	{
+		t_searchResult result;
+		unsigned char *record = records + count * POSFILE_RECORD;
+		char state = search_Outcome(side);
+
+		if(OUTCOME_CHECKMATE == state)
+		{
+			*outcome = (SIDE_WHITE == side) ? 0 : 2;
+			break;
+		}
+		if(OUTCOME_STALEMATE == state || geHalfmove >= 100 || eng_IsRepetition(2))
+			break;
+
+		posfile_Pack(side, 1, eval_Position(SIDE_WHITE), ply, opening,
+		             (unsigned int)options->m_nodes, record);
+		search_Best(side, (char)options->m_depth, (unsigned int)options->m_nodes, &result);
+		if(!result.m_haveMove)
+			break;
+		posfile_SetScore(record, SIDE_WHITE == side ? result.m_score : -result.m_score);
+		++count;
+
+		board_ApplyMove(&result.m_move, side);
+		side = 1 - side;
+	}
+
+	for(ply = 0; ply < count; ++ply)
+		posfile_SetResult(records + ply * POSFILE_RECORD, (char)*outcome);
+	return count;
+}
+
+/*-----------------------------------------------------------------------*/
+static void runWorker(int worker, const t_genOptions *options, int fd)
+{
+	static unsigned char records[MAX_PLIES * POSFILE_RECORD];
+	int game;
+
+	for(game = worker; game < options->m_games; game += options->m_jobs)
+	{
+		t_gameHeader header;
+
+		header.m_game = game;
+		header.m_count = playGame(game, options, records, &header.m_result);
+		if(!writeAll(fd, &header, sizeof(header)) ||
+		   !writeAll(fd, records, (size_t)header.m_count * POSFILE_RECORD))
+			_exit(1);
+	}
+	close(fd);
+	_exit(0);
+}
+
+/*-----------------------------------------------------------------------*/
+// 1 if the key was new, and it is remembered from now on
+static int firstSeen(unsigned long long key)
+{
+	long i;
+
+	if(2 * (st_seenCount + 1) > st_seenSize)
+	{
+		unsigned long long *old = st_seen;
+		long oldSize = st_seenSize;
+
+		st_seenSize = oldSize ? 2 * oldSize : 1L << 16;
+		st_seen = (unsigned long long *)calloc((size_t)st_seenSize, sizeof(*st_seen));
+		if(!st_seen)
+		{
+			fprintf(stderr, "datagen: out of memory at %ld positions\n", st_seenCount);
+			exit(1);
+		}
+		for(i = 0; i < oldSize; ++i)
+		{
+			long j = (long)(old[i] & (unsigned long long)(st_seenSize - 1));
+
+			if(!old[i])
+				continue;
+			while(st_seen[j])
+				j = (j + 1) & (st_seenSize - 1);
+			st_seen[j] = old[i];
+		}
+		free(old);
+	}
+
+	i = (long)(key & (unsigned long long)(st_seenSize - 1));
+	while(st_seen[i])
+	{
+		if(st_seen[i] == key)
+			return 0;
+		i = (i + 1) & (st_seenSize - 1);
+	}
+	st_seen[i] = key;
+	++st_seenCount;
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+static double nowSeconds(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*-----------------------------------------------------------------------*/
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: datagen --out FILE [--book FILE] [--split train|val|all]\n"
+		"               [--games N] [--jobs J] [--random R] [--seed S]\n"
+		"               [--nodes N] [--depth D]\n");
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	static unsigned char records[MAX_PLIES * POSFILE_RECORD];
+	const char *book = "book.epd", *split = "train", *outPath = 0;
+	t_genOptions options;
+	int fds[MAX_JOBS], worker, game, failed = 0, i;
+	long written = 0, repeats = 0, wins = 0, losses = 0;
+	double start;
+	FILE *out;
+
+	options.m_games = 1000;
+	options.m_jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	options.m_random = 8;
+	options.m_depth = 4;
+	options.m_seed = 1;
+	options.m_nodes = 1200;
+
+	for(i = 1; i < argc; ++i)
+	{
+		if(0 == strcmp(argv[i], "--book") && i + 1 < argc)
+			book = argv[++i];
+		else if(0 == strcmp(argv[i], "--split") && i + 1 < argc)
+			split = argv[++i];
+		else if(0 == strcmp(argv[i], "--out") && i + 1 < argc)
+			outPath = argv[++i];
+		else if(0 == strcmp(argv[i], "--games") && i + 1 < argc)
+			options.m_games = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--jobs") && i + 1 < argc)
+			options.m_jobs = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--random") && i + 1 < argc)
+			options.m_random = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--seed") && i + 1 < argc)
+			options.m_seed = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--nodes") && i + 1 < argc)
+			options.m_nodes = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--depth") && i + 1 < argc)
+			options.m_depth = atoi(argv[++i]);
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+
+	if(!outPath || options.m_games < 1 ||
+	   (strcmp(split, "train") && strcmp(split, "val") && strcmp(split, "all")))
+	{
+		usage();
+		return 2;
+	}
+	if(options.m_jobs < 1)
+		options.m_jobs = 1;
+	if(options.m_jobs > MAX_JOBS)
+		options.m_jobs = MAX_JOBS;
+	if(options.m_jobs > options.m_games)
+		options.m_jobs = options.m_games;
+	if(options.m_random < 0)
+		options.m_random = 0;
+	if(options.m_random > MAX_RANDOM)
+		options.m_random = MAX_RANDOM;
+	if(options.m_nodes > 65535)
+		options.m_nodes = 65535;
+
+	if(!loadBook(book, split))
+		return 1;
+
+	out = fopen(outPath, "wb");
+	if(!out || !posfile_WriteHeader(out))
+	{
+		fprintf(stderr, "datagen: cannot write %s\n", outPath);
+		return 1;
+	}
+
+	// nothing buffered may be copied into the children, to be flushed twice
+	fflush(out);
+	fflush(stderr);
+	start = nowSeconds();
+	for(worker = 0; worker < options.m_jobs; ++worker)
+	{
+		int pipeFds[2];
+		pid_t pid;
+
+		if(pipe(pipeFds) < 0 || (pid = fork()) < 0)
+		{
+			fprintf(stderr, "datagen: cannot start worker %d\n", worker);
+			return 1;
+		}
+		if(!pid)
+		{
+			// the child keeps its own write end and nothing else
+			fclose(out);
+			close(pipeFds[0]);
+			for(i = 0; i < worker; ++i)
+				close(fds[i]);
+			runWorker(worker, &options, pipeFds[1]);
+		}
+		close(pipeFds[1]);
+		fds[worker] = pipeFds[0];
+	}
+
+	// game g is always the next thing on pipe g mod jobs, so reading in game
+	// order needs no reorder buffer; a worker that gets ahead waits on its
+	// pipe, not on the others
+	for(game = 0; game < options.m_games && !failed; ++game)
+	{
+		t_gameHeader header;
+		int fd = fds[game % options.m_jobs];
+
+		if(!readAll(fd, &header, sizeof(header)) || header.m_game != game ||
+		   header.m_count < 0 || header.m_count > MAX_PLIES ||
+		   !readAll(fd, records, (size_t)header.m_count * POSFILE_RECORD))
+		{
+			fprintf(stderr, "datagen: worker %d stopped before game %d\n",
+			        game % options.m_jobs, game);
+			failed = 1;
+			break;
+		}
+
+		wins += 2 == header.m_result;
+		losses += 0 == header.m_result;
+		for(i = 0; i < header.m_count; ++i)
+		{
+			const unsigned char *record = records + i * POSFILE_RECORD;
+
+			if(!firstSeen(posfile_Key(record)))
+			{
+				++repeats;
+				continue;
+			}
+			if(!posfile_Append(out, record))
+			{
+				fprintf(stderr, "datagen: cannot write %s\n", outPath);
+				failed = 1;
+				break;
+			}
+			++written;
+		}
+
+		if(0 == (game + 1) % 1000)
+			fprintf(stderr, "  %d games, %ld positions, %.0f games/s\n",
+			        game + 1, written, (game + 1) / (nowSeconds() - start));
+	}
+
+	for(worker = 0; worker < options.m_jobs; ++worker)
+		close(fds[worker]);
+	for(worker = 0; worker < options.m_jobs; ++worker)
+	{
+		int status;
+
+		if(wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+			failed = 1;
+	}
+	if(fclose(out))
+		failed = 1;
+
+	fprintf(stderr, "datagen: %d games (W/L/D %ld/%ld/%ld), %ld positions, %ld repeats dropped,"
+	        " %d jobs, %.1f s (%s)\n",
+	        game, wins, losses, game - wins - losses, written, repeats, options.m_jobs,
+	        nowSeconds() - start, split);
+	free(st_seen);
+	return failed;
+}
@@ -9,39 +9,66 @@
  *	These numbers are expected to match the published references exactly, at
  *	every depth, with no divergence - including the under-promotions the old
  *	generator never produced.
+ *
+ *	Depth 6 and 7 are what the references are mostly about, and a plain
+ *	perft gets there in minutes.  So the count is hashed on the 64 bit
+ *	polybook_Key and the root moves are split over --jobs forked workers.
+ *	None of it changes what is counted: the same generator, make and
+ *	legality test decide every node, and divide prints what it always
+ *	printed.  Counts are 64 bit, since depth 7 passes 2^32.
+ *
+ *	  ./chesstest eperft 7 --jobs 8
+ *	  ./chesstest divide "<fen>" 6 --hash 256
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <time.h>
+#include <sys/time.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "types.h"
 #include "engine.h"
 #include "eval.h"
+#include "polybook.h"
 #include "testutil.h"
 
-#define MAX_PERFT_DEPTH		6
+#define MAX_PERFT_DEPTH		7
 #define MAX_PERFT_PLIES		8
 
+// Per process, so --jobs 8 is eight of these
+#define PERFT_HASH_MB		64
+#define PERFT_MAX_JOBS		64
+// A root move whose worker died; no reference is this large
+#define PERFT_LOST			((uint64_t)-1)
+
+typedef struct tag_perftEntry
+{
+	uint64_t	m_lock;		// key with the depth folded in
+	uint64_t	m_nodes;
+} t_perftEntry;
+
 typedef struct tag_EnginePerftPos
 {
 	const char	*m_name;
 	const char	*m_fen;
-	long		 m_expected[MAX_PERFT_DEPTH];	// 0 = not published here
+	uint64_t	 m_expected[MAX_PERFT_DEPTH];	// 0 = not published here
 } t_EnginePerftPos;
 
 // Verified against chessprogramming.org/Perft_Results
 static const t_EnginePerftPos stc_positions[] =
 {
 	{ "initial",    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
-	  { 20, 400, 8902, 197281, 4865609, 119060324 } },
+	  { 20, 400, 8902, 197281, 4865609, 119060324, 3195901860ull } },
 	{ "kiwipete",   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
-	  { 48, 2039, 97862, 4085603, 193690690, 0 } },
+	  { 48, 2039, 97862, 4085603, 193690690, 8031647685ull, 0 } },
 	{ "endgame",    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
-	  { 14, 191, 2812, 43238, 674624, 11030083 } },
+	  { 14, 191, 2812, 43238, 674624, 11030083, 178633661 } },
 	{ "promotion",  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
-	  { 6, 264, 9467, 422333, 15833292, 0 } },
+	  { 6, 264, 9467, 422333, 15833292, 706045033, 0 } },
 	{ "middlegame", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
-	  { 44, 1486, 62379, 2103487, 89941194, 0 } },
+	  { 44, 1486, 62379, 2103487, 89941194, 0, 0 } },
 };
 
 #define NUM_ENGINE_POSITIONS ((int)(sizeof(stc_positions)/sizeof(stc_positions[0])))
@@ -132,16 +159,97 @@ char test_EngineSetFEN(const char *fen)
 }
 
 /*-----------------------------------------------------------------------*/
-static long enginePerft(char side, int depth, int ply)
+// test_EngineSetFEN stops at the en passant field, but the halfmove clock
+// after it is what the fifty move rule runs on
+char test_FENHalfmove(const char *fen)
+{
+	const char *p = fen;
+	int field = 0;
+
+	while(*p && field < 4)
+	{
+		while(*p == ' ') ++p;
+		while(*p && *p != ' ') ++p;
+		++field;
+	}
+	while(*p == ' ') ++p;
+
+	return (*p >= '0' && *p <= '9') ? (char)atoi(p) : 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// Perft hash: the node count below a position at a depth.  The key is
+// polybook_Key, which is 64 bits and folds in castling, en passant and the
+// side, and the depth goes into the lock so one position at two depths is two
+// entries.  Always-replace: a perft revisits what it just counted far more
+// than what it counted long ago.  A lock collision would be a wrong count, and
+// at 64 bits the suite would run for a very long time before meeting one
+static t_perftEntry *st_hash;
+static uint64_t st_hashMask;
+static int si_hashMB = PERFT_HASH_MB;
+
+static uint64_t hashLock(uint64_t key, int depth)
+{
+	return key ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ull);
+}
+
+/*-----------------------------------------------------------------------*/
+static void hashAlloc(void)
+{
+	uint64_t entries = 1;
+
+	free(st_hash);
+	st_hash = NULL;
+	if(si_hashMB <= 0)
+		return;
+
+	while(entries * 2 * sizeof(t_perftEntry) <= (uint64_t)si_hashMB << 20)
+		entries *= 2;
+	st_hash = calloc((size_t)entries, sizeof(t_perftEntry));
+	st_hashMask = st_hash ? entries - 1 : 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// Wall time, not clock(): with the root split the parent only waits
+static double wallClock(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return now.tv_sec + now.tv_usec / 1e6;
+}
+
+/*-----------------------------------------------------------------------*/
+void test_PerftHashSize(int megabytes)
+{
+	si_hashMB = megabytes;
+	hashAlloc();
+}
+
+/*-----------------------------------------------------------------------*/
+// The last ply is counted, not played: a legal move at depth 1 is one node
+// and nothing is generated below it.  Legality still needs the make, because
+// eng_LeavesInCheck looks at the board after it
+static uint64_t enginePerft(char side, int depth, int ply)
 {
 	t_engMove *moves = st_arena[ply];
 	t_engUndo undo;
+	t_perftEntry *entry = NULL;
+	uint64_t lock = 0;
 	char count, i;
-	long nodes = 0;
+	uint64_t nodes = 0;
 
 	if(depth <= 0)
 		return 1;
 
+	if(st_hash && depth >= 2)
+	{
+		lock = hashLock(polybook_Key(side), depth);
+		entry = &st_hash[lock & st_hashMask];
+		if(entry->m_lock == lock)
+			return entry->m_nodes;
+	}
+
 	count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
 
 	{
@@ -158,55 +266,190 @@ static long enginePerft(char side, int depth, int ply)
 		}
 	}
 
+	if(entry)
+	{
+		entry->m_lock = lock;
+		entry->m_nodes = nodes;
+	}
 	return nodes;
 }
 
 /*-----------------------------------------------------------------------*/
-// Per-move breakdown, which is how a perft mismatch actually gets diagnosed:
-// compare against a known-good engine one move at a time and recurse into
-// whichever move disagrees
-void test_EnginePerftDivide(const char *fen, int depth)
+// The count under each legal root move.  The engine is one set of globals,
+// so splitting the root means processes: worker w takes moves w, w + jobs
+// ... with its own copy of the board and its own hash, and sends back
+// (index, count) pairs.  moves[] and nodes[] come back in generation order
+// whatever jobs was, so a divide reads the same run on one core or eight
+static int perftRoot(char side, int depth, int jobs, t_engMove *moves, uint64_t *nodes)
 {
-	t_engMove moves[ENG_MAX_MOVES];
+	t_engMove all[ENG_MAX_MOVES];
 	t_engUndo undo;
-	char side = test_EngineSetFEN(fen);
-	char count = eng_GenMoves(side, moves, ENG_MAX_MOVES), i;
-	long total = 0;
+	char count = eng_GenMoves(side, all, ENG_MAX_MOVES), wasInCheck = eng_InCheck(side), i;
+	int legal = 0, worker, j, fds[PERFT_MAX_JOBS];
 
-	printf("divide, depth %d\n", depth);
+	for(i = 0; i < count; ++i)
 	{
-		char wasInCheck = eng_InCheck(side);
+		eng_Make(&all[i], &undo);
+		if(!eng_LeavesInCheck(side, &all[i], wasInCheck))
+			moves[legal++] = all[i];
+		eng_Unmake(&all[i], &undo);
+	}
 
-		for(i = 0; i < count; ++i)
+	if(!st_hash && si_hashMB > 0)
+		hashAlloc();
+
+	if(jobs > legal)
+		jobs = legal;
+	if(jobs > PERFT_MAX_JOBS)
+		jobs = PERFT_MAX_JOBS;
+	if(jobs <= 1 || depth <= 3)
+	{
+		for(i = 0; i < legal; ++i)
 		{
 			eng_Make(&moves[i], &undo);
-			if(!eng_LeavesInCheck(side, &moves[i], wasInCheck))
+			nodes[i] = enginePerft(1 - side, depth - 1, 0);
+			eng_Unmake(&moves[i], &undo);
+		}
+		return legal;
+	}
+
+	fflush(stdout);
+	for(worker = 0; worker < jobs; ++worker)
+	{
+		int pipeFds[2];
+		pid_t pid = -1;
+
+		// a pipe with no worker on the other end is closed again
+		if(!pipe(pipeFds) && (pid = fork()) < 0)
+		{
+			close(pipeFds[0]);
+			close(pipeFds[1]);
+		}
+		if(pid < 0)
+		{
+			// no worker, no split: count this one's share here instead
+			for(i = worker; i < legal; i += jobs)
 			{
-				long n = (depth <= 1) ? 1 : enginePerft(1 - side, depth - 1, 0);
-				char from[3], to[3];
-				char promo = moves[i].m_flags & ENG_MF_PROMO;
-
-				test_TileName(ENG_TO_TILE(moves[i].m_from), from);
-				test_TileName(ENG_TO_TILE(moves[i].m_to), to);
-				printf("  %s%s%c %ld\n", from, to,
-				       promo ? ".rnbqkp"[promo] : ' ', n);
-				total += n;
+				eng_Make(&moves[i], &undo);
+				nodes[i] = enginePerft(1 - side, depth - 1, 0);
+				eng_Unmake(&moves[i], &undo);
 			}
-			eng_Unmake(&moves[i], &undo);
+			fds[worker] = -1;
+			continue;
+		}
+		if(!pid)
+		{
+			close(pipeFds[0]);
+			for(j = 0; j < worker; ++j)
+				if(fds[j] >= 0)
+					close(fds[j]);
+			for(i = worker; i < legal; i += jobs)
+			{
+				uint64_t pair[2];
+
+				eng_Make(&moves[i], &undo);
+				pair[0] = i;
+				pair[1] = enginePerft(1 - side, depth - 1, 0);
+				eng_Unmake(&moves[i], &undo);
+				if(write(pipeFds[1], pair, sizeof(pair)) != (ssize_t)sizeof(pair))
+					_exit(1);
+			}
+			_exit(0);
 		}
+		close(pipeFds[1]);
+		fds[worker] = pipeFds[0];
+	}
+
+	for(worker = 0; worker < jobs; ++worker)
+	{
+		uint64_t pair[2];
+
+		if(fds[worker] < 0)
+			continue;
+		// a worker that died leaves its moves lost, which no reference matches
+		for(i = worker; i < legal; i += jobs)
+			nodes[i] = PERFT_LOST;
+		while(read(fds[worker], pair, sizeof(pair)) == (ssize_t)sizeof(pair))
+			if(pair[0] < (uint64_t)legal)
+				nodes[pair[0]] = pair[1];
+		close(fds[worker]);
 	}
-	printf("  total %ld\n", total);
+	while(wait(NULL) > 0)
+		;
+
+	return legal;
 }
 
 /*-----------------------------------------------------------------------*/
-int test_RunEnginePerft(int maxDepth, int verbose)
+static uint64_t perftTotal(char side, int depth, int jobs)
 {
-	int p, d, failures = 0;
+	t_engMove moves[ENG_MAX_MOVES];
+	uint64_t nodes[ENG_MAX_MOVES], total = 0;
+	int legal, i;
+
+	if(depth <= 0)
+		return 1;
+	legal = perftRoot(side, depth, jobs, moves, nodes);
+	if(depth == 1)
+		return legal;
+	for(i = 0; i < legal; ++i)
+	{
+		if(nodes[i] == PERFT_LOST)
+			return PERFT_LOST;
+		total += nodes[i];
+	}
+	return total;
+}
+
+/*-----------------------------------------------------------------------*/
+// The count from the position on the board, on this process alone: a
+// library has no business forking its caller
+unsigned long long test_EnginePerft(char side, int depth)
+{
+	return perftTotal(side, depth, 1);
+}
+
+/*-----------------------------------------------------------------------*/
+// Per-move breakdown, which is how a perft mismatch actually gets diagnosed:
+// compare against a known-good engine one move at a time and recurse into
+// whichever move disagrees
+void test_EnginePerftDivide(const char *fen, int depth, int jobs)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	uint64_t nodes[ENG_MAX_MOVES];
+	char side = test_EngineSetFEN(fen);
+	uint64_t total = 0;
+	int legal, i;
+
+	printf("divide, depth %d\n", depth);
+	eng_HistoryEnable(0);
+	legal = perftRoot(side, depth, jobs, moves, nodes);
+	eng_HistoryEnable(1);
+	for(i = 0; i < legal; ++i)
+	{
+		uint64_t n = (depth <= 1) ? 1 : nodes[i];
+		char from[3], to[3];
+		char promo = moves[i].m_flags & ENG_MF_PROMO;
+
+		test_TileName(ENG_TO_TILE(moves[i].m_from), from);
+		test_TileName(ENG_TO_TILE(moves[i].m_to), to);
+		printf("  %s%s%c %llu\n", from, to,
+		       promo ? ".rnbqkp"[promo] : ' ', (unsigned long long)n);
+		total += n;
+	}
+	printf("  total %llu\n", (unsigned long long)total);
+}
+
+/*-----------------------------------------------------------------------*/
+int test_RunEnginePerft(int maxDepth, int jobs, long budget, int verbose)
+{
+	int p, d, failures = 0, skipped = 0;
 
 	if(maxDepth > MAX_PERFT_DEPTH)
 		maxDepth = MAX_PERFT_DEPTH;
 
-	printf("engine perft (0x88 core, depth 1..%d)\n", maxDepth);
+	printf("engine perft (0x88 core, depth 1..%d, %d job%s, %d MB hash)\n",
+	       maxDepth, jobs, jobs == 1 ? "" : "s", si_hashMB > 0 ? si_hashMB : 0);
 	printf("  %-11s %5s %12s %12s %8s  %s\n",
 	       "position", "depth", "expected", "actual", "time", "status");
 
@@ -216,29 +459,40 @@ int test_RunEnginePerft(int maxDepth, int verbose)
 
 		for(d = 1; d <= maxDepth; ++d)
 		{
-			long expected = pos->m_expected[d-1];
-			long actual;
+			uint64_t expected = pos->m_expected[d-1];
+			uint64_t actual;
 			char side;
-			clock_t elapsed;
+			double elapsed;
 
 			if(!expected)
 				continue;
+			if(budget && expected > (uint64_t)budget * jobs)
+			{
+				++skipped;
+				continue;
+			}
 
 			side = test_EngineSetFEN(pos->m_fen);
 
-			elapsed = clock();
-			actual = enginePerft(side, d, 0);
-			elapsed = clock() - elapsed;
+			// a hit from the last position would be right, but would time
+			// nothing; each line is counted from an empty table
+			if(st_hash)
+				memset(st_hash, 0, (size_t)(st_hashMask + 1) * sizeof(t_perftEntry));
+			eng_HistoryEnable(0);
+			elapsed = wallClock();
+			actual = perftTotal(side, d, jobs);
+			elapsed = wallClock() - elapsed;
+			eng_HistoryEnable(1);
 
 			if(actual != expected)
 				++failures;
 
-			printf("  %-11s %5d %12ld %12ld %7.2fs  %s",
-			       pos->m_name, d, expected, actual,
-			       (double)elapsed / CLOCKS_PER_SEC,
+			printf("  %-11s %5d %12llu %12llu %7.2fs  %s",
+			       pos->m_name, d, (unsigned long long)expected, (unsigned long long)actual,
+			       elapsed,
 			       actual == expected ? "ok" : "FAIL");
 			if(actual != expected)
-				printf("  (%+ld)", actual - expected);
+				printf("  (%+lld)", (long long)(actual - expected));
 			printf("\n");
 
 			if(verbose && actual != expected)
@@ -246,6 +500,9 @@ int test_RunEnginePerft(int maxDepth, int verbose)
 		}
 	}
 
-	printf("  -> %d failing\n", failures);
+	if(skipped)
+		printf("  -> %d failing, %d over %ld nodes a job not run\n", failures, skipped, budget);
+	else
+		printf("  -> %d failing\n", failures);
 	return failures;
 }
@@ -0,0 +1,364 @@
+/*
+ *	evalfit.c
+ *	cc65 Chess - test support
+ *
+ *	tests/tune fits eval.c through coefficients rather than through a copy of
+ *	its tables, and that is only worth anything while the coefficients put
+ *	back together are the score.  So: every position here, and every position
+ *	one legal move from it, rebuilt at the shipping numbers and compared with
+ *	eval_Position - under the shipping terms and with the candidates on.
+ *	Then one small fit, to show the gradient points the right way and that
+ *	the answer does not depend on how many threads computed it.
+ *
+ *	eval_Trace is checked over the same positions the same way: its parts add
+ *	up to eval_Position for either side, and the terms land where they should.
+ *	So is the binary position file: each record puts back the FEN it was
+ *	packed from, and a written file loads into the tuner with nothing stale.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "types.h"
+#include "engine.h"
+#include "eval.h"
+#include "texel.h"
+#include "posfile.h"
+#include "testutil.h"
+
+#define FIT_SAMPLES		2048
+
+static const char *sc_fens[] =
+{
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r1bqkb1r/pp3ppp/2np1n2/4p3/2B1P3/2N2N2/PPP2PPP/R1BQK2R w KQkq - 0 7",
+	"rnb1kbnr/pppp1ppp/8/4p1q1/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 2 3",
+	"r3k2r/pp1q1ppp/2n1bn2/3p4/3P4/2NB1N2/PP1Q1PPP/R3K2R b KQkq - 0 11",
+	"8/5pk1/6p1/3R4/8/6P1/5PK1/8 w - - 0 40",		// rook ending, blend
+	"8/8/8/4k3/8/8/8/R3K3 w - - 0 1",				// KRK, white drives
+	"8/8/8/3k4/8/8/4q3/6K1 b - - 0 1",				// KQK, black drives
+	"8/8/4k3/8/8/8/8/2B1KN2 w - - 0 1",				// KBNK
+	"8/2P5/8/8/3k4/8/5p2/4K3 w - - 0 1",			// pawns racing
+	"4k3/pppppppp/8/8/8/8/PPPPPPPP/4K3 w - - 0 1",	// kings and pawns
+};
+
+static int si_failures;
+
+/*-----------------------------------------------------------------------*/
+// Compare the model with the engine on the board as it stands.  Returns 1 on
+// a miss
+static int compareHere(const double *shipping, const char *fen, int verbose)
+{
+	t_texelSample sample;
+	int got;
+
+	texel_Sample(0.5f, &sample);
+	got = texel_Eval(shipping, &sample);
+	if(got != sample.m_eval)
+	{
+		if(verbose || si_failures < 5)
+			printf("    model %d, eval_Position %d: %s\n", got, sample.m_eval, fen);
+		++si_failures;
+		return 1;
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// Every listed position and every position one legal move on
+static long compareAll(int verbose)
+{
+	double shipping[TEXEL_PARAMS];
+	int i;
+	long positions = 0;
+
+	texel_Shipping(shipping);
+	for(i = 0; i < (int)(sizeof(sc_fens) / sizeof(sc_fens[0])); ++i)
+	{
+		t_engMove moves[ENG_MAX_MOVES];
+		t_engUndo undo;
+		char side = test_EngineSetFEN(sc_fens[i]), count, m;
+
+		compareHere(shipping, sc_fens[i], verbose);
+		++positions;
+
+		count = eng_GenLegalMoves(side, moves);
+		eng_HistoryEnable(0);
+		for(m = 0; m < count; ++m)
+		{
+			eng_Make(&moves[m], &undo);
+			compareHere(shipping, sc_fens[i], verbose);
+			eng_Unmake(&moves[m], &undo);
+			++positions;
+		}
+		eng_HistoryEnable(1);
+	}
+	return positions;
+}
+
+/*-----------------------------------------------------------------------*/
+static void checkModel(int verbose)
+{
+	static const struct { const char *m_name; int m_terms; } terms[] =
+	{
+		{ "shipping terms", EVAL_ALL },
+		{ "dev and pawn structure on", EVAL_ALL | EVAL_DEV | EVAL_PAWNSTRUCT },
+		{ "queen-home table", EVAL_ALL | EVAL_QUEENHOME },
+	};
+	char saved = geEvalTerms;
+	int t;
+
+	for(t = 0; t < (int)(sizeof(terms) / sizeof(terms[0])); ++t)
+	{
+		int before = si_failures;
+		long positions;
+
+		geEvalTerms = (char)terms[t].m_terms;
+		positions = compareAll(verbose);
+		printf("  model = eval, %-27s %s (%ld positions)\n", terms[t].m_name,
+		       si_failures == before ? "ok" : "FAILED", positions);
+	}
+	geEvalTerms = saved;
+}
+
+/*-----------------------------------------------------------------------*/
+// The trace of the board as it stands, for both sides.  Returns 1 on a miss
+static int traceHere(const char *fen, int verbose)
+{
+	t_evalTrace trace;
+	char side;
+
+	for(side = SIDE_BLACK; side <= SIDE_WHITE; ++side)
+	{
+		int want = eval_Position(side);
+
+		eval_Trace(side, &trace);
+		if(trace.m_total != want || trace.m_phase != gePhase ||
+		   trace.m_material + trace.m_pst + trace.m_endgame + trace.m_mateDrive +
+		   trace.m_kbn + trace.m_dev + trace.m_pawnStruct != want)
+		{
+			if(verbose || si_failures < 5)
+				printf("    trace %d, eval_Position %d for %s: %s\n", trace.m_total, want,
+				       SIDE_WHITE == side ? "white" : "black", fen);
+			++si_failures;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static void checkTrace(int verbose)
+{
+	char saved = geEvalTerms;
+	int i, before = si_failures;
+	long positions = 0;
+	t_evalTrace trace;
+
+	geEvalTerms = (char)(EVAL_ALL | EVAL_DEV | EVAL_PAWNSTRUCT);
+	for(i = 0; i < (int)(sizeof(sc_fens) / sizeof(sc_fens[0])); ++i)
+	{
+		t_engMove moves[ENG_MAX_MOVES];
+		t_engUndo undo;
+		char side = test_EngineSetFEN(sc_fens[i]), count, m;
+
+		traceHere(sc_fens[i], verbose);
+		++positions;
+
+		count = eng_GenLegalMoves(side, moves);
+		eng_HistoryEnable(0);
+		for(m = 0; m < count; ++m)
+		{
+			eng_Make(&moves[m], &undo);
+			traceHere(sc_fens[i], verbose);
+			eng_Unmake(&moves[m], &undo);
+			++positions;
+		}
+		eng_HistoryEnable(1);
+	}
+	geEvalTerms = saved;
+
+	// and the terms are where they belong: a rook up is material, the drive
+	// is on the side that is winning, and the start position is all zero
+	test_EngineSetFEN(sc_fens[5]);
+	eval_Trace(SIDE_BLACK, &trace);
+	if(trace.m_material != -gcPieceValue[ROOK] || trace.m_mateDrive >= 0 || !trace.m_endgame)
+	{
+		printf("    KRK for black: material %d, drive %d, endgame %d\n",
+		       trace.m_material, trace.m_mateDrive, trace.m_endgame);
+		++si_failures;
+	}
+	test_EngineSetFEN(sc_fens[0]);
+	eval_Trace(SIDE_WHITE, &trace);
+	if(trace.m_total || trace.m_material || trace.m_endgame || trace.m_phase != 6400)
+	{
+		printf("    start position: total %d, phase %d\n", trace.m_total, trace.m_phase);
+		++si_failures;
+	}
+
+	printf("  trace = eval, %-27s %s (%ld positions)\n", "both sides",
+	       si_failures == before ? "ok" : "FAILED", positions);
+}
+
+/*-----------------------------------------------------------------------*/
+// Pack and unpack one position, by FEN.  Returns 1 on a miss
+static int packHere(char side, FILE *file, long *written)
+{
+	unsigned char record[POSFILE_RECORD], again[POSFILE_RECORD];
+	char before[96], after[96];
+
+	test_EngineGetFEN(side, before);
+	posfile_Pack(side, (char)(*written % 3), eval_Position(SIDE_WHITE), 12, 34, 1200, record);
+	posfile_Append(file, record);
+	++*written;
+
+	side = posfile_Unpack(record);
+	test_EngineGetFEN(side, after);
+	// the key is the position's alone: other labels, other score, same key
+	posfile_Pack(side, 2, 0, 0, 0, 0, again);
+	posfile_SetScore(again, -40000);
+	if(strcmp(before, after) || posfile_Eval(record) != eval_Position(SIDE_WHITE) ||
+	   posfile_Key(record) != posfile_Key(again) || posfile_Score(again) != -32767)
+	{
+		if(si_failures < 5)
+			printf("    packed %s, unpacked %s\n", before, after);
+		++si_failures;
+		return 1;
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static void checkPosFile(void)
+{
+	static const char *name = "evalfit-test.bin";
+	FILE *file = fopen(name, "wb");
+	const unsigned char *records;
+	t_texelSet set;
+	size_t mapped;
+	long written = 0, count, stale;
+	int i, before = si_failures;
+
+	if(!file || !posfile_WriteHeader(file))
+	{
+		printf("    cannot write %s\n", name);
+		++si_failures;
+		if(file)
+			fclose(file);
+		return;
+	}
+
+	// the list has castling rights and en passant in it, and the moves from
+	// it make and lose both
+	for(i = 0; i < (int)(sizeof(sc_fens) / sizeof(sc_fens[0])); ++i)
+	{
+		t_engMove moves[ENG_MAX_MOVES];
+		t_engUndo undo;
+		char side = test_EngineSetFEN(sc_fens[i]), count, m;
+
+		packHere(side, file, &written);
+		count = eng_GenLegalMoves(side, moves);
+		for(m = 0; m < count; ++m)
+		{
+			test_EngineSetFEN(sc_fens[i]);
+			eng_HistoryEnable(0);
+			eng_Make(&moves[m], &undo);
+			packHere(1 - side, file, &written);
+			eng_HistoryEnable(1);
+		}
+	}
+	fclose(file);
+
+	records = posfile_Map(name, &count, &mapped);
+	if(!records || count != written || posfile_Result(records) != 0.0f ||
+	   posfile_Result(records + POSFILE_RECORD) != 0.5f ||
+	   posfile_Result(records + 2 * POSFILE_RECORD) != 1.0f)
+	{
+		printf("    mapped %ld of %ld records\n", count, written);
+		++si_failures;
+	}
+	posfile_Unmap(records, mapped);
+
+	if(texel_Load(name, &set, &stale) != written || stale || texel_Verify(&set))
+	{
+		printf("    tuner loaded %ld of %ld, %ld stale\n", set.m_count, written, stale);
+		++si_failures;
+	}
+	texel_Free(&set);
+	remove(name);
+
+	printf("  position file, %-26s %s (%ld records)\n", "pack, map, load",
+	       si_failures == before ? "ok" : "FAILED", written);
+}
+
+/*-----------------------------------------------------------------------*/
+// Positions labelled by the sigmoid of a knight worth 360 rather than 320.
+// A fit from the shipping point has to walk the knight up and lower the loss
+// on the way, and do exactly the same sums on one thread as on three
+static void checkFit(void)
+{
+	static t_texelSample samples[FIT_SAMPLES];
+	double truth[TEXEL_PARAMS], fitted[TEXEL_PARAMS], shipping[TEXEL_PARAMS];
+	double before, after, oneThread, threeThreads;
+	t_texelSet set = { samples, 0, 0, 0 };
+	int i, failures = si_failures;
+
+	texel_Shipping(truth);
+	truth[TEXEL_N] = 360;
+
+	for(i = 0; set.m_count < FIT_SAMPLES && i < (int)(sizeof(sc_fens) / sizeof(sc_fens[0])); ++i)
+	{
+		t_engMove moves[ENG_MAX_MOVES];
+		t_engUndo undo;
+		char side = test_EngineSetFEN(sc_fens[i]), count, m;
+
+		count = eng_GenLegalMoves(side, moves);
+		eng_HistoryEnable(0);
+		for(m = 0; m < count && set.m_count < FIT_SAMPLES; ++m)
+		{
+			t_texelSample *sample = &samples[set.m_count++];
+
+			eng_Make(&moves[m], &undo);
+			texel_Sample(0.5f, sample);
+			sample->m_result = (float)(1.0 / (1.0 + pow(10.0, -texel_Eval(truth, sample) / 400.0)));
+			eng_Unmake(&moves[m], &undo);
+		}
+		eng_HistoryEnable(1);
+	}
+
+	texel_Shipping(shipping);
+	oneThread = texel_Loss(&set, shipping, 1.0, 1);
+	threeThreads = texel_Loss(&set, shipping, 1.0, 3);
+	if(fabs(oneThread - threeThreads) > 1e-12)
+	{
+		printf("    loss %.12f on one thread, %.12f on three\n", oneThread, threeThreads);
+		++si_failures;
+	}
+
+	before = oneThread;
+	texel_Fit(&set, 1.0, 0.0, 40, 2, 0, fitted);
+	after = texel_Loss(&set, fitted, 1.0, 2);
+	if(!(after < before) || fitted[TEXEL_N] <= shipping[TEXEL_N])
+	{
+		printf("    fit went the wrong way: N %.1f, loss %.6f -> %.6f\n",
+		       fitted[TEXEL_N], before, after);
+		++si_failures;
+	}
+
+	printf("  fit toward N=360 over %ld positions %s (N %.1f)\n", set.m_count,
+	       si_failures == failures ? "ok" : "FAILED", fitted[TEXEL_N]);
+}
+
+/*-----------------------------------------------------------------------*/
+int test_RunEvalFit(int verbose)
+{
+	si_failures = 0;
+	printf("evaluation coefficients\n");
+
+	checkModel(verbose);
+	checkTrace(verbose);
+	checkPosFile();
+	checkFit();
+
+	return si_failures;
+}
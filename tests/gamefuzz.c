@@ -12,16 +12,35 @@
  *	  - every redo reproduces the position after it
  *	  - the incremental evaluation still agrees with a full recount
  *	  - so do the incremental position hash and the game phase
+ *	  - and the pawn-only key, when the pawn hash is compiled in
+ *	  - the B display's attack counts, which board_SyncDisplay brings forward
+ *	    from the squares that changed, agree with counting every tile again
+ *	  - board_DrawChanged draws exactly the tiles that look different: the
+ *	    pieces that moved, and the counts that changed while B is on
+ *	  - the per-turn legal move map answers the cursor, board_IsPromotion and
+ *	    board_FindMove exactly as generating the moves again does
  *
  *	Castling, en passant and promotion are preferred whenever available, since
  *	random play almost never reaches them on its own.  That matters most for the
  *	last check: those three are exactly the moves whose eval delta is not just
  *	"a piece left one square and arrived on another".
+ *
+ *	A game is named by the seed it was played from, and that seed is all it
+ *	depends on, so any game from any run replays alone.  The suite plays its
+ *	300 in one process; a campaign shares a seed range over forked workers
+ *	and lists the seeds that failed:
+ *
+ *	  ./chesstest fuzz --seeds 1..2000000 --jobs 16
+ *	  ./chesstest fuzz 1234567 1
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "types.h"
 #include "globals.h"
 #include "engine.h"
@@ -80,6 +99,161 @@ static int checkDisplayMirror(int game, int ply)
 	return 0;
 }
 
+/*-----------------------------------------------------------------------*/
+// gpAttackBoard against eng_AttackersOf on every tile, while the display that
+// keeps it is on.  Only after a board_SyncDisplay - in between it describes
+// the last board synced, by design
+static int checkAttackCounts(int game, int ply, const char *tag)
+{
+	char tile, side, list[16], want;
+
+	if(!gShowAttackBoard)
+		return 0;
+
+	for(tile = 0; tile < 64; ++tile)
+		for(side = SIDE_BLACK; side <= SIDE_WHITE; ++side)
+		{
+			want = eng_AttackersOf(ENG_FROM_TILE(tile), side, list);
+			if(gpAttackBoard[giAttackBoardOffset[tile][side]] != want)
+			{
+				char name[3];
+				test_TileName(tile, name);
+				printf("    game %d %s ply %d: %s side %d attack count %d, recount %d\n",
+				       game, tag, ply, name, side,
+				       gpAttackBoard[giAttackBoardOffset[tile][side]], want);
+				return 1;
+			}
+		}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// What the screen would show, as of the last board_DrawChanged: the pieces,
+// the counts and whether the counts were up at all
+static char sc_shownBoard[64], sc_shownCounts[64*2], sc_shownB;
+
+static void takeShown(void)
+{
+	char drawn[8];
+
+	memcpy(sc_shownBoard, gChessBoard, 64);
+	memcpy(sc_shownCounts, gpAttackBoard, sizeof(sc_shownCounts));
+	sc_shownB = gShowAttackBoard;
+	test_TakeDrawn(drawn);
+}
+
+/*-----------------------------------------------------------------------*/
+// board_DrawChanged against the screen it is bringing up to date: every tile
+// that looks different has to be drawn, and nothing else may be - a tile
+// drawn that did not need it is the full redraw creeping back.  Only after a
+// board_SyncDisplay, which is where the changes are found
+static int checkDrawn(int game, int ply, const char *tag)
+{
+	char drawn[8], tile, want, got;
+
+	board_DrawChanged();
+	test_TakeDrawn(drawn);
+
+	for(tile = 0; tile < 64; ++tile)
+	{
+		want = sc_shownBoard[tile] != gChessBoard[tile >> 3][tile & 7] ||
+		       sc_shownB != gShowAttackBoard ||
+		       (gShowAttackBoard &&
+		        (sc_shownCounts[giAttackBoardOffset[tile][SIDE_BLACK]] !=
+		         gpAttackBoard[giAttackBoardOffset[tile][SIDE_BLACK]] ||
+		         sc_shownCounts[giAttackBoardOffset[tile][SIDE_WHITE]] !=
+		         gpAttackBoard[giAttackBoardOffset[tile][SIDE_WHITE]]));
+		got = (drawn[tile >> 3] >> (tile & 7)) & 1;
+
+		if(want != got)
+		{
+			char name[3];
+			test_TileName(tile, name);
+			printf("    game %d %s ply %d: %s %s\n", game, tag, ply, name,
+			       want ? "changed but not drawn" : "drawn but unchanged");
+			return 1;
+		}
+	}
+
+	takeShown();
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// board_LegalMap against working every move out again: each tile's
+// destinations, whether a move promotes, and the move board_FindMove hands
+// back, down to the flags it rebuilds.  Run straight after board_ApplyMove,
+// which leaves no map, so the first pass is the way it used to be done
+static int checkLegalMap(int game, int ply, char side)
+{
+	static char want[64][MAX_PIECE_MOVES], wantCount[64];
+	static t_engMove wantMove[ENG_MAX_MOVES][4];
+	static char wantFound[ENG_MAX_MOVES][4], wantPromo[ENG_MAX_MOVES];
+	t_engMove moves[ENG_MAX_MOVES], got;
+	t_engUndo undo;
+	char tile, count, i, p, legal[ENG_MAX_MOVES];
+	const char *what = 0;
+
+	for(tile = 0; tile < 64; ++tile)
+	{
+		board_LegalMovesFrom(tile);
+		wantCount[tile] = gNumMoveTiles;
+		memcpy(want[tile], gMoveTiles, gNumMoveTiles);
+	}
+
+	count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+	for(i = 0; i < count; ++i)
+	{
+		eng_Make(&moves[i], &undo);
+		legal[i] = !eng_IsAttacked(geKing[side], 1 - side);
+		eng_Unmake(&moves[i], &undo);
+
+		wantPromo[i] = board_IsPromotion(ENG_TO_TILE(moves[i].m_from), ENG_TO_TILE(moves[i].m_to));
+		for(p = 0; p < 4; ++p)
+			wantFound[i][p] = board_FindMove(ENG_TO_TILE(moves[i].m_from), ENG_TO_TILE(moves[i].m_to),
+			                                 ROOK + p, &wantMove[i][p]);
+	}
+
+	board_LegalMap(side);
+
+	for(tile = 0; tile < 64 && !what; ++tile)
+	{
+		board_LegalMovesFrom(tile);
+		if(gNumMoveTiles != wantCount[tile] || memcmp(gMoveTiles, want[tile], gNumMoveTiles))
+			what = "destinations";
+	}
+
+	// only legal moves: the map never had the others, and the way round
+	// found them without asking
+	for(i = 0; i < count && !what; ++i)
+	{
+		if(!legal[i])
+			continue;
+
+		if(board_IsPromotion(ENG_TO_TILE(moves[i].m_from), ENG_TO_TILE(moves[i].m_to)) != wantPromo[i])
+			what = "promotion";
+
+		for(p = 0; p < 4 && !what; ++p)
+		{
+			memset(&got, 0xFF, sizeof(got));
+			if(board_FindMove(ENG_TO_TILE(moves[i].m_from), ENG_TO_TILE(moves[i].m_to),
+			                  ROOK + p, &got) != wantFound[i][p] ||
+			   (wantFound[i][p] && memcmp(&got, &wantMove[i][p], sizeof(got))))
+				what = "found move";
+		}
+	}
+
+	if(what)
+	{
+		char name[3];
+		test_TileName(ENG_TO_TILE(moves[i - 1].m_from), name);
+		printf("    game %d ply %d: legal move map %s differ (near %s)\n",
+		       game, ply, what, name);
+		return 1;
+	}
+	return 0;
+}
+
 /*-----------------------------------------------------------------------*/
 static int checkMaterial(int game, int ply, int *prevBlack, int *prevWhite)
 {
@@ -177,6 +351,28 @@ static int checkHashKey(int game, int ply, const char *tag)
 	return 0;
 }
 
+/*-----------------------------------------------------------------------*/
+// The pawn key rides with the eval totals, so it is checked before
+// checkEvalScore's eval_Refresh rebuilds it and would hide any drift
+static int checkPawnKey(int game, int ply, const char *tag)
+{
+#if EVAL_PAWN_HASH
+	unsigned long full[2];
+
+	eng_PawnKeyOfBoard(full);
+	if(gePawnKey[SIDE_WHITE] != full[SIDE_WHITE] || gePawnKey[SIDE_BLACK] != full[SIDE_BLACK])
+	{
+		printf("    game %d %s ply %d: pawn key drifted, running %06lX/%06lX full %06lX/%06lX\n",
+		       game, tag, ply, gePawnKey[SIDE_WHITE], gePawnKey[SIDE_BLACK],
+		       full[SIDE_WHITE], full[SIDE_BLACK]);
+		return 1;
+	}
+#else
+	(void)game; (void)ply; (void)tag;
+#endif
+	return 0;
+}
+
 /*-----------------------------------------------------------------------*/
 static int checkHistoryKey(int game, int ply, const char *tag)
 {
@@ -202,6 +398,9 @@ static int probeLegal(const t_engMove *move, char side, int game, int ply)
 	char ep = geEP, castle = geCastle, halfmove = geHalfmove;
 	char kingBlack = geKing[SIDE_BLACK], kingWhite = geKing[SIDE_WHITE];
 	char legal;
+#if EVAL_PAWN_HASH
+	unsigned long pawnWhite = gePawnKey[SIDE_WHITE], pawnBlack = gePawnKey[SIDE_BLACK];
+#endif
 
 	memcpy(sc_probeBoard, geBoard, 128);
 	eng_HistoryEnable(0);
@@ -218,7 +417,11 @@ static int probeLegal(const t_engMove *move, char side, int game, int ply)
 	   hash != geHashKey || history != eng_HistoryStateDigest() ||
 	   score != geEvalScore || end != geEvalEnd || phase != gePhase ||
 	   ep != geEP || castle != geCastle || halfmove != geHalfmove ||
-	   kingBlack != geKing[SIDE_BLACK] || kingWhite != geKing[SIDE_WHITE])
+	   kingBlack != geKing[SIDE_BLACK] || kingWhite != geKing[SIDE_WHITE]
+#if EVAL_PAWN_HASH
+	   || pawnWhite != gePawnKey[SIDE_WHITE] || pawnBlack != gePawnKey[SIDE_BLACK]
+#endif
+	   )
 	{
 		printf("    game %d probe ply %d: no-history make/unmake changed state\n",
 		       game, ply);
@@ -240,6 +443,9 @@ static int checkFastUnmake(const t_engMove *move, int game, int ply)
 	int score = geEvalScore, end = geEvalEnd, phase = gePhase;
 	char ep = geEP, castle = geCastle, halfmove = geHalfmove;
 	char kingBlack = geKing[SIDE_BLACK], kingWhite = geKing[SIDE_WHITE];
+#if EVAL_PAWN_HASH
+	unsigned long pawnWhite = gePawnKey[SIDE_WHITE], pawnBlack = gePawnKey[SIDE_BLACK];
+#endif
 
 	memcpy(sc_probeBoard, geBoard, 128);
 	eng_Make(move, &slow);
@@ -253,6 +459,10 @@ static int checkFastUnmake(const t_engMove *move, int game, int ply)
 	geEvalScore = score;
 	geEvalEnd = end;
 	gePhase = phase;
+#if EVAL_PAWN_HASH
+	gePawnKey[SIDE_WHITE] = pawnWhite;
+	gePawnKey[SIDE_BLACK] = pawnBlack;
+#endif
 	eng_RestoreEnable(0);
 
 	if(memcmp(&slow, &fast, sizeof(slow)) ||
@@ -268,127 +478,290 @@ static int checkFastUnmake(const t_engMove *move, int game, int ply)
 	return 0;
 }
 
+/*-----------------------------------------------------------------------*/
+// One game, named by its seed: srand(game) is all that decides it.  Returns
+// 1 if anything failed, having said what
+static int fuzzGame(int game, int *specials)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	char side = SIDE_WHITE;
+	int ply, plies = 0, k, prevBlack = 16, prevWhite = 16;
+
+	// odd games start with the B display on and even ones turn it on part
+	// way, so both the full count and the incremental one are exercised
+	gShowAttackBoard = game & 1;
+	srand(game);
+	board_Init();
+	undo_Init();
+	takeShown();
+
+	for(ply = 0; ply < MAX_PLIES; ++ply)
+	{
+		char count, i, chosen = 0xFF;
+
+		if(OUTCOME_OK != search_Outcome(side))
+			break;
+
+		count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+
+		// prefer the special moves heavily when they are available
+		for(i = 0; i < count && 0xFF == chosen; ++i)
+		{
+			if((moves[i].m_flags & (ENG_MF_CASTLE | ENG_MF_ENPASSANT | ENG_MF_PROMO)) &&
+			   (rand() % 10) < 8)
+			{
+				int legal = probeLegal(&moves[i], side, game, ply);
+
+				if(legal < 0)
+					return 1;
+				if(legal)
+					chosen = i;
+				if(0xFF != chosen)
+					++*specials;
+			}
+		}
+
+		for(i = 0; i < count * 2 && 0xFF == chosen; ++i)
+		{
+			char pick = rand() % count;
+			int legal = probeLegal(&moves[pick], side, game, ply);
+
+			if(legal < 0)
+				return 1;
+			if(legal)
+				chosen = pick;
+		}
+
+		if(0xFF == chosen)
+			break;
+		if(checkFastUnmake(&moves[chosen], game, ply))
+			return 1;
+
+		memcpy(sc_snapshots[plies], geBoard, 128);
+		st_played[plies] = moves[chosen];
+
+		if(ply == 40)
+			gShowAttackBoard = 1 - gShowAttackBoard;
+		board_ApplyMove(&moves[chosen], side);
+		++plies;
+
+		if(checkMaterial(game, ply, &prevBlack, &prevWhite) ||
+		   checkAttackCounts(game, ply, "move") ||
+		   checkDrawn(game, ply, "move") ||
+		   checkDisplayMirror(game, ply) ||
+		   checkPawnKey(game, ply, "move") ||
+		   checkEvalScore(game, ply, "move") ||
+		   checkHashKey(game, ply, "move") ||
+		   checkHistoryKey(game, ply, "move") ||
+		   checkPhase(game, ply, "move") ||
+		   checkLegalMap(game, ply, 1 - side))
+			return 1;
+
+		side = 1 - side;
+	}
+
+	// unwind, then replay
+	k = plies;
+	while(k)
+	{
+		--k;
+		undo_Undo();
+		// the UI syncs once after a multi-step undo, so skip some here
+		if(k % 3)
+			board_SyncDisplay();
+		if(compareBoard(sc_snapshots[k], k, "undo", game) ||
+		   ((k % 3) && checkAttackCounts(game, k, "undo")) ||
+		   ((k % 3) && checkDrawn(game, k, "undo")) ||
+		   checkPawnKey(game, k, "undo") ||
+		   checkEvalScore(game, k, "undo") ||
+		   checkHashKey(game, k, "undo") ||
+		   checkHistoryKey(game, k, "undo") ||
+		   checkPhase(game, k, "undo"))
+			return 1;
+	}
+
+	for(k = 0; k < plies; ++k)
+	{
+		undo_Redo();
+		if(k % 3)
+			board_SyncDisplay();
+		if(((k % 3) && checkAttackCounts(game, k, "redo")) ||
+		   ((k % 3) && checkDrawn(game, k, "redo")) ||
+		   checkPawnKey(game, k, "redo") ||
+		   checkEvalScore(game, k, "redo") ||
+		   checkHashKey(game, k, "redo") ||
+		   checkHistoryKey(game, k, "redo") ||
+		   checkPhase(game, k, "redo") ||
+		   (k + 1 < plies && compareBoard(sc_snapshots[k+1], k, "redo", game)))
+			return 1;
+	}
+	return 0;
+}
+
 /*-----------------------------------------------------------------------*/
 int test_RunGameFuzz(int seed, int games, int verbose)
 {
 	int game, failures = 0, specials = 0;
 
 	for(game = 0; game < games; ++game)
-	{
-		t_engMove moves[ENG_MAX_MOVES];
-		char side = SIDE_WHITE;
-		int ply, plies = 0, k, prevBlack = 16, prevWhite = 16;
+		failures += fuzzGame(seed + game, &specials);
+	gShowAttackBoard = 0;
 
-		srand(seed + game);
-		board_Init();
-		undo_Init();
+	printf("game fuzz: %d games from seed %d, %d special moves, %d failing\n",
+	       games, seed, specials, failures);
+	(void)verbose;
+	return failures;
+}
 
-		for(ply = 0; ply < MAX_PLIES; ++ply)
-		{
-			char count, i, chosen = 0xFF;
+/*-----------------------------------------------------------------------*/
+// What a campaign worker sends back after each game
+typedef struct tag_fuzzReport
+{
+	int		m_seed;
+	int		m_failed;
+	int		m_specials;
+} t_fuzzReport;
 
-			if(OUTCOME_OK != search_Outcome(side))
-				break;
+#define FUZZ_MAX_JOBS		64
+#define FUZZ_MAX_LISTED		64
+#define FUZZ_PROGRESS_SECS	60
 
-			count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+/*-----------------------------------------------------------------------*/
+static void fuzzWorker(int first, int last, int worker, int jobs, int fd)
+{
+	int seed;
 
-			// prefer the special moves heavily when they are available
-			for(i = 0; i < count && 0xFF == chosen; ++i)
-			{
-				if((moves[i].m_flags & (ENG_MF_CASTLE | ENG_MF_ENPASSANT | ENG_MF_PROMO)) &&
-				   (rand() % 10) < 8)
-				{
-					int legal = probeLegal(&moves[i], side, game, ply);
-
-					if(legal < 0)
-					{
-						++failures;
-						goto nextGame;
-					}
-					if(legal)
-						chosen = i;
-					if(0xFF != chosen)
-						++specials;
-				}
-			}
+	for(seed = first + worker; seed <= last && seed >= first; seed += jobs)
+	{
+		t_fuzzReport report;
+
+		report.m_specials = 0;
+		report.m_seed = seed;
+		report.m_failed = fuzzGame(seed, &report.m_specials);
+		// a failing game has said why on stdout, and that goes out before the
+		// parent's line naming the seed
+		fflush(stdout);
+		if(write(fd, &report, sizeof(report)) != (ssize_t)sizeof(report))
+			_exit(1);
+	}
+	_exit(0);
+}
 
-			for(i = 0; i < count * 2 && 0xFF == chosen; ++i)
-			{
-				char pick = rand() % count;
-				int legal = probeLegal(&moves[pick], side, game, ply);
+/*-----------------------------------------------------------------------*/
+// Seeds first..last over "jobs" forked workers, worker w taking first + w,
+// first + w + jobs ...  A game is decided by its seed alone, so which worker
+// played it does not matter, and every failing seed comes out as the command
+// that replays it on its own.  A worker that dies takes its next seed down
+// with it, and that seed is reported the same way
+int test_RunGameFuzzSeeds(int first, int last, int jobs, int verbose)
+{
+	struct pollfd fds[FUZZ_MAX_JOBS];
+	int nextSeed[FUZZ_MAX_JOBS], listed[FUZZ_MAX_LISTED];
+	long games = (long)last - first + 1, done = 0;
+	int worker, open = 0, failures = 0, specials = 0, numListed = 0;
+	time_t lastProgress = time(NULL);
+
+	if(games < 1)
+		return 0;
+	if(jobs > FUZZ_MAX_JOBS)
+		jobs = FUZZ_MAX_JOBS;
+	if(jobs > games)
+		jobs = (int)games;
+	if(jobs < 1)
+		jobs = 1;
+
+	printf("game fuzz: seeds %d..%d on %d job%s\n", first, last, jobs, jobs == 1 ? "" : "s");
+	fflush(stdout);
+	for(worker = 0; worker < jobs; ++worker)
+	{
+		int pipeFds[2];
+		pid_t pid;
 
-				if(legal < 0)
-				{
-					++failures;
-					goto nextGame;
-				}
-				if(legal)
-					chosen = pick;
-			}
+		if(pipe(pipeFds) < 0 || (pid = fork()) < 0)
+		{
+			printf("    cannot start worker %d\n", worker);
+			fds[worker].fd = -1;
+			++failures;
+			continue;
+		}
+		if(!pid)
+		{
+			int j;
 
-			if(0xFF == chosen)
-				break;
-			if(checkFastUnmake(&moves[chosen], game, ply))
-			{
-				++failures;
-				goto nextGame;
-			}
+			close(pipeFds[0]);
+			for(j = 0; j < worker; ++j)
+				if(fds[j].fd >= 0)
+					close(fds[j].fd);
+			fuzzWorker(first, last, worker, jobs, pipeFds[1]);
+		}
+		close(pipeFds[1]);
+		fds[worker].fd = pipeFds[0];
+		fds[worker].events = POLLIN;
+		nextSeed[worker] = first + worker;
+		++open;
+	}
 
-			memcpy(sc_snapshots[plies], geBoard, 128);
-			st_played[plies] = moves[chosen];
+	while(open)
+	{
+		if(poll(fds, jobs, 1000) < 0)
+			break;
 
-			board_ApplyMove(&moves[chosen], side);
-			++plies;
+		for(worker = 0; worker < jobs; ++worker)
+		{
+			t_fuzzReport report;
+
+			if(fds[worker].fd < 0 || !fds[worker].revents)
+				continue;
 
-			if(checkMaterial(game, ply, &prevBlack, &prevWhite) ||
-			   checkDisplayMirror(game, ply) ||
-			   checkEvalScore(game, ply, "move") ||
-			   checkHashKey(game, ply, "move") ||
-			   checkHistoryKey(game, ply, "move") ||
-			   checkPhase(game, ply, "move"))
+			if(read(fds[worker].fd, &report, sizeof(report)) == (ssize_t)sizeof(report))
 			{
+				++done;
+				specials += report.m_specials;
+				nextSeed[worker] = report.m_seed + jobs;
+				if(!report.m_failed)
+					continue;
 				++failures;
-				goto nextGame;
+				printf("    seed %d failed: ./chesstest fuzz %d 1\n", report.m_seed, report.m_seed);
+				if(numListed < FUZZ_MAX_LISTED)
+					listed[numListed++] = report.m_seed;
+				continue;
 			}
 
-			side = 1 - side;
-		}
-
-		// unwind, then replay
-		k = plies;
-		while(k)
-		{
-			--k;
-			undo_Undo();
-			if(compareBoard(sc_snapshots[k], k, "undo", game) ||
-			   checkEvalScore(game, k, "undo") ||
-			   checkHashKey(game, k, "undo") ||
-			   checkHistoryKey(game, k, "undo") ||
-			   checkPhase(game, k, "undo"))
+			// end of the pipe: finished, or died on the seed after its last
+			if(nextSeed[worker] <= last && nextSeed[worker] >= first)
 			{
 				++failures;
-				goto nextGame;
+				printf("    seed %d crashed worker %d: ./chesstest fuzz %d 1\n",
+				       nextSeed[worker], worker, nextSeed[worker]);
+				if(numListed < FUZZ_MAX_LISTED)
+					listed[numListed++] = nextSeed[worker];
 			}
+			close(fds[worker].fd);
+			fds[worker].fd = -1;
+			--open;
 		}
 
-		for(k = 0; k < plies; ++k)
+		if(time(NULL) - lastProgress >= FUZZ_PROGRESS_SECS)
 		{
-			undo_Redo();
-			if(checkEvalScore(game, k, "redo") ||
-			   checkHashKey(game, k, "redo") ||
-			   checkHistoryKey(game, k, "redo") ||
-			   checkPhase(game, k, "redo") ||
-			   (k + 1 < plies && compareBoard(sc_snapshots[k+1], k, "redo", game)))
-			{
-				++failures;
-				goto nextGame;
-			}
+			lastProgress = time(NULL);
+			printf("  %ld / %ld games, %d failing\n", done, games, failures);
+			fflush(stdout);
 		}
-nextGame: ;
 	}
+	while(wait(NULL) > 0)
+		;
 
-	printf("game fuzz: %d games from seed %d, %d special moves, %d failing\n",
-	       games, seed, specials, failures);
+	printf("game fuzz: %ld games from seeds %d..%d, %d special moves, %d failing\n",
+	       done, first, last, specials, failures);
+	if(numListed)
+	{
+		int i;
+
+		printf("  failing seeds:");
+		for(i = 0; i < numListed; ++i)
+			printf(" %d", listed[i]);
+		printf("%s\n", failures > numListed ? " ..." : "");
+	}
 	(void)verbose;
 	return failures;
 }
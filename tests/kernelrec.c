@@ -0,0 +1,202 @@
+/*
+ *	kernelrec.c
+ *	cc65 Chess - test support
+ *
+ *	The C side of the host check on the assembly kernels.  Walks the perft
+ *	positions one ply deep and writes down every call the kernels stand in
+ *	for, with the board before and after and what the C returned:
+ *	eng_IsAttacked on every square for both sides, the slider walk from
+ *	every occupied square with both ray sets, both generator modes and room
+ *	for everything, four moves or six with three already written, and the
+ *	board half of eng_Make and eng_Unmake for every pseudo-legal move.
+ *	kernelreplay.py then runs each call through src/engine65.s and
+ *	src/spectrum/engineZ80.asm and wants the same answers byte for byte.
+ *
+ *	This is the reference the asm is held to before it meets a target, not
+ *	instead of it: c64perft / c64search and zxsearch still have to give the
+ *	same counts with and without ENGINE_ASM (doc/measuring.md).
+ *
+ *	  ./kernelrec kernels.bin
+ *
+ *	Every record is one letter, the state - geBoard's 128 bytes, then
+ *	geCastle, geEP, geHalfmove and geKing[2] - and then:
+ *	  A  square, side, result
+ *	  S  from, side, diagonal, capturesOnly, maxMoves, count, result, and the
+ *	     first 24 moves of the list, 0xAA where nothing was written
+ *	  M  move, the state after, the undo record, the piece that moved
+ *	  U  move, undo record, the state after, the piece that moved
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "testutil.h"
+
+// The slider list written down; more than the walks here ever fill
+#define SLIDER_MOVES	24
+
+static const char *stc_fens[] =
+{
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	// castling through attacked squares, both ways
+	"r3k2r/1b4bq/8/8/8/8/7B/R3K2R b KQkq - 0 1",
+	// en passant that would expose the king
+	"8/8/8/2k5/2pP4/8/B7/4K3 b - d3 0 3",
+};
+
+static t_engMove st_arena[2][ENG_MAX_MOVES];
+static FILE *sf_out;
+static unsigned long sl_records[4];
+
+/*-----------------------------------------------------------------------*/
+static void putState(void)
+{
+	fwrite(geBoard, 1, 128, sf_out);
+	fputc(geCastle, sf_out);
+	fputc(geEP, sf_out);
+	fputc(geHalfmove, sf_out);
+	fputc(geKing[0], sf_out);
+	fputc(geKing[1], sf_out);
+}
+
+/*-----------------------------------------------------------------------*/
+static void recordAttacks(void)
+{
+	char sq, side;
+
+	for(sq = 0; sq < 128; ++sq)
+	{
+		if(ENG_OFFBOARD(sq))
+			continue;
+		for(side = 0; side < 2; ++side)
+		{
+			fputc('A', sf_out);
+			putState();
+			fputc(sq, sf_out);
+			fputc(side, sf_out);
+			fputc(eng_IsAttacked(sq, side), sf_out);
+			++sl_records[0];
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+static void recordSliders(void)
+{
+	// room for all, room for four, and room for six with three written
+	static const char sc_max[3] = { ENG_MAX_MOVES, 4, 6 };
+	static const char sc_count[3] = { 0, 0, 3 };
+	t_engMove moves[SLIDER_MOVES];
+	char sq, diagonal, capturesOnly, room, result;
+
+	for(sq = 0; sq < 128; ++sq)
+	{
+		if(ENG_OFFBOARD(sq) || NONE == (geBoard[sq] & PIECE_DATA))
+			continue;
+		for(diagonal = 0; diagonal < 2; ++diagonal)
+		{
+			for(capturesOnly = 0; capturesOnly < 2; ++capturesOnly)
+			{
+				for(room = 0; room < 3; ++room)
+				{
+					memset(moves, 0xAA, sizeof(moves));
+					fputc('S', sf_out);
+					putState();
+					result = eng_TestSlider(sq, diagonal, capturesOnly, sc_max[room],
+					                        moves, sc_count[room]);
+					fputc(sq, sf_out);
+					fputc((geBoard[sq] & PIECE_WHITE) ? SIDE_WHITE : SIDE_BLACK, sf_out);
+					fputc(diagonal, sf_out);
+					fputc(capturesOnly, sf_out);
+					fputc(sc_max[room], sf_out);
+					fputc(sc_count[room], sf_out);
+					fputc(result, sf_out);
+					fwrite(moves, 1, sizeof(moves), sf_out);
+					++sl_records[1];
+				}
+			}
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+// The state written around each call is all eng_Make and eng_Unmake change
+// on the board, so recording the whole of them records their board half.
+// The piece the kernels return is read off the board either side
+static void walk(char side, char depth)
+{
+	t_engMove *moves = st_arena[depth];
+	t_engUndo undo;
+	char count, i, piece;
+
+	recordAttacks();
+	recordSliders();
+	if(!depth)
+		return;
+
+	count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+	for(i = 0; i < count; ++i)
+	{
+		fputc('M', sf_out);
+		putState();
+		fwrite(&moves[i], 1, sizeof(t_engMove), sf_out);
+		piece = geBoard[moves[i].m_from];
+		eng_Make(&moves[i], &undo);
+		putState();
+		fwrite(&undo, 1, sizeof(t_engUndo), sf_out);
+		fputc(piece, sf_out);
+		++sl_records[2];
+
+		if(!eng_IsAttacked(geKing[side], 1 - side))
+			walk(1 - side, depth - 1);
+
+		fputc('U', sf_out);
+		putState();
+		fwrite(&moves[i], 1, sizeof(t_engMove), sf_out);
+		fwrite(&undo, 1, sizeof(t_engUndo), sf_out);
+		eng_Unmake(&moves[i], &undo);
+		putState();
+		fputc(geBoard[moves[i].m_from], sf_out);
+		++sl_records[3];
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	int i;
+
+	if(argc != 2)
+	{
+		printf("usage: %s <out.bin>\n", argv[0]);
+		return 1;
+	}
+
+	sf_out = fopen(argv[1], "wb");
+	if(!sf_out)
+	{
+		printf("cannot write %s\n", argv[1]);
+		return 1;
+	}
+
+	// the walk only moves pieces; the key and the ring are not the kernels'
+	eng_HistoryEnable(0);
+	for(i = 0; i < (int)(sizeof(stc_fens) / sizeof(stc_fens[0])); ++i)
+	{
+		char side = test_EngineSetFEN(stc_fens[i]);
+
+		geHalfmove = test_FENHalfmove(stc_fens[i]);
+		walk(side, 1);
+	}
+
+	fclose(sf_out);
+	printf("%lu attack, %lu slider, %lu make, %lu unmake calls\n",
+	       sl_records[0], sl_records[1], sl_records[2], sl_records[3]);
+	return 0;
+}
@@ -0,0 +1,553 @@
+#!/usr/bin/env python3
+"""Replay the C engine's calls through the assembly kernels, on the host.
+
+kernelrec writes down every call a one-ply walk of the perft positions makes
+to eng_IsAttacked, the slider walk and the board half of eng_Make and
+eng_Unmake, with the board either side and what the C returned.  This reads
+src/engine65.s or src/spectrum/engineZ80.asm, runs each call through a model
+of the instructions those files use, and wants the same result, the same
+board, the same move list and undo record, and the stack left where it was.
+
+The models are only what the kernels need: the instructions they contain,
+flat 64K memory, the engine's variables at fixed addresses, and cc65's or
+sccz80's way of passing arguments.  Anything else in the source - a new
+instruction or addressing mode - stops the replay rather than being guessed
+at.  They do not count cycles, and they are not the target: c64perft,
+c64search and zxsearch still have to match with and without ENGINE_ASM before
+a port turns the kernels on (doc/measuring.md).
+
+  make kernels
+  python3 kernelreplay.py 6502 kernels.bin
+  python3 kernelreplay.py z80 kernels.bin
+"""
+
+import re
+import sys
+from pathlib import Path
+
+
+SRC = Path(__file__).resolve().parent.parent / "src"
+
+# the engine's variables, where both models put them
+BOARD = 0x1000
+SYMBOLS = dict(_geBoard=BOARD, _geCastle=0x1080, _geEP=0x1081, _geHalfmove=0x1082,
+	_geKing=0x1083, _sc_maxMoves=0x1085, _sc_capturesOnly=0x1086)
+STATE = 133
+ORTHOGONAL, DIAGONAL = 0x3000, 0x3004
+LIST, MOVE, UNDO = 0x4000, 0x5000, 0x5010
+SLIDER_MOVES = 24
+
+
+def number(expr, env):
+	expr = expr.replace("$", "0x")
+	expr = re.sub(r"<~\s*\(", "0xFF&~(", expr)
+	expr = re.sub(r"<~\s*(\w+)", r"(0xFF&~\1)", expr)
+	return eval(expr, {}, env)
+
+
+class Cpu6502:
+	"""engine65.s, called the way cc65 calls a fastcall function."""
+
+	ZP = dict(ptr1=0x02, ptr2=0x04, ptr3=0x06, ptr4=0x08, tmp1=0x0A, tmp2=0x0B,
+		tmp3=0x0C, tmp4=0x0D, sreg=0x0E, sp=0x10)
+	STACK = 0x9000
+	BRANCH = {"bne": lambda c: not c.z, "beq": lambda c: c.z, "bcs": lambda c: c.c,
+		"bcc": lambda c: not c.c, "bmi": lambda c: c.n, "bpl": lambda c: not c.n}
+
+	def __init__(self, path):
+		self.consts = {"ENGINE_ASM": 1}
+		self.code = []
+		self.labels = {}
+		self.resolved = {}
+		self.mem = bytearray(0x10000)
+		self.parse(path.read_text())
+		self.a = self.x = self.y = 0
+		self.c = self.z = self.n = 0
+
+	def parse(self, text):
+		active = [True]
+		scope = None
+		data = 0x2000
+		for raw in text.split("\n"):
+			line = raw.split(";")[0].strip()
+			if not line:
+				continue
+			word = line.split()[0]
+			if word == ".ifndef":
+				active.append(line.split()[1] not in self.consts)
+				continue
+			if word == ".if":
+				active.append(bool(self.consts[line.split()[1]]))
+				continue
+			if word == ".else":
+				active[-1] = not active[-1]
+				continue
+			if word == ".endif":
+				active.pop()
+				continue
+			if not all(active):
+				continue
+			m = re.match(r"^(\w+)\s*=\s*(.+)$", line)
+			if m:
+				self.consts[m.group(1)] = number(m.group(2), {})
+				continue
+			if word == ".proc":
+				scope = line.split()[1]
+				self.labels[scope] = len(self.code)
+				continue
+			if word == ".endproc":
+				scope = None
+				continue
+			label, anon = None, False
+			m = re.match(r"^(\w+):\s*(.*)$", line)
+			if m:
+				label, line = m.group(1), m.group(2)
+			elif line.startswith(":"):
+				anon, line = True, line[1:].strip()
+			if line.startswith(".byte"):
+				if label:
+					self.labels[label] = data
+				for v in line[5:].split(","):
+					self.mem[data] = number(v.strip(), self.consts) & 0xFF
+					data += 1
+				continue
+			if line.startswith("."):
+				continue
+			if label:
+				self.labels[(scope + "::" + label) if scope else label] = len(self.code)
+			self.code.append((scope, anon, line))
+		self.anon = [i for i, c in enumerate(self.code) if c[1]]
+
+	def resolve(self, scope, at, operand):
+		# every operand means the same thing each time its line runs
+		key = (at, operand)
+		if key not in self.resolved:
+			self.resolved[key] = self.evaluate(scope, at, operand)
+		return self.resolved[key]
+
+	def evaluate(self, scope, at, operand):
+		if operand.startswith(":"):
+			ahead, back = operand.count("+"), operand.count("-")
+			if ahead:
+				return [i for i in self.anon if i > at][ahead - 1]
+			return [i for i in self.anon if i <= at][-back]
+		env = dict(self.consts)
+		env.update(SYMBOLS)
+		env.update(self.ZP)
+		env.update({k: v for k, v in self.labels.items() if "::" not in k})
+		if scope:
+			env.update({k.split("::")[1]: v for k, v in self.labels.items()
+				if k.startswith(scope + "::")})
+		return number(operand, env)
+
+	def flags(self, v):
+		v &= 0xFF
+		self.z, self.n = int(v == 0), v >> 7
+		return v
+
+	def sp(self):
+		return self.mem[0x10] | self.mem[0x11] << 8
+
+	def setSp(self, sp):
+		self.mem[0x10], self.mem[0x11] = sp & 0xFF, sp >> 8
+
+	def pop(self, count):
+		sp = self.sp()
+		self.a = self.mem[sp]
+		if count == 2:
+			self.x = self.mem[sp + 1]
+		self.setSp(sp + count)
+		self.y = 0
+
+	def call(self, name, args, last):
+		"""args in push order, a tuple for a word; last goes in A/X"""
+		sp = self.STACK
+		for arg in args:
+			if isinstance(arg, tuple):
+				sp -= 2
+				self.mem[sp], self.mem[sp + 1] = arg[0] & 0xFF, arg[0] >> 8
+			else:
+				sp -= 1
+				self.mem[sp] = arg
+		self.setSp(sp)
+		self.a, self.x = last & 0xFF, last >> 8
+		self.run(self.labels[name])
+		return self.a | self.x << 8, self.sp() == self.STACK
+
+	def run(self, pc, limit=100000):
+		stack = []
+		for _ in range(limit):
+			scope, _anon, line = self.code[pc]
+			at, pc = pc, pc + 1
+			if not line:
+				continue
+			parts = line.split(None, 1)
+			op, arg = parts[0], parts[1].strip() if len(parts) > 1 else ""
+			mode, addr, val = "mem", None, None
+			if arg in ("", "a"):
+				mode = "acc" if arg else "imp"
+			elif op == "jsr" and arg in ("popa", "popax"):
+				self.pop(1 if arg == "popa" else 2)
+				continue
+			elif arg.startswith("#"):
+				mode, val = "imm", self.resolve(scope, at, arg[1:]) & 0xFF
+			elif arg.startswith("("):
+				zp = self.resolve(scope, at, re.match(r"\((\w+)\),y", arg).group(1))
+				addr = ((self.mem[zp] | self.mem[zp + 1] << 8) + self.y) & 0xFFFF
+			elif arg.endswith(",x"):
+				addr = (self.resolve(scope, at, arg[:-2]) + self.x) & 0xFFFF
+			elif arg.endswith(",y"):
+				addr = (self.resolve(scope, at, arg[:-2]) + self.y) & 0xFFFF
+			else:
+				addr = self.resolve(scope, at, arg)
+			read = (lambda: val) if mode == "imm" else (lambda: self.mem[addr])
+
+			if op in self.BRANCH:
+				if self.BRANCH[op](self):
+					pc = addr
+			elif op == "jmp":
+				pc = addr
+			elif op == "jsr":
+				stack.append(pc)
+				pc = addr
+			elif op == "rts":
+				if not stack:
+					return
+				pc = stack.pop()
+			elif op == "lda": self.a = self.flags(read())
+			elif op == "ldx": self.x = self.flags(read())
+			elif op == "ldy": self.y = self.flags(read())
+			elif op == "sta": self.mem[addr] = self.a
+			elif op == "stx": self.mem[addr] = self.x
+			elif op == "sty": self.mem[addr] = self.y
+			elif op == "tax": self.x = self.flags(self.a)
+			elif op == "txa": self.a = self.flags(self.x)
+			elif op == "tay": self.y = self.flags(self.a)
+			elif op == "tya": self.a = self.flags(self.y)
+			elif op == "and": self.a = self.flags(self.a & read())
+			elif op == "ora": self.a = self.flags(self.a | read())
+			elif op == "eor": self.a = self.flags(self.a ^ read())
+			elif op in ("cmp", "cpx", "cpy"):
+				r, v = {"cmp": self.a, "cpx": self.x, "cpy": self.y}[op], read()
+				self.c = int(r >= v)
+				self.flags(r - v)
+			elif op == "adc":
+				r = self.a + read() + self.c
+				self.c = int(r > 0xFF)
+				self.a = self.flags(r)
+			elif op == "sbc":
+				r = self.a - read() - (1 - self.c)
+				self.c = int(r >= 0)
+				self.a = self.flags(r)
+			elif op == "clc": self.c = 0
+			elif op == "sec": self.c = 1
+			elif op in ("asl", "rol"):
+				v = self.a if mode == "acc" else self.mem[addr]
+				r = self.flags((v << 1) | (self.c if op == "rol" else 0))
+				self.c = v >> 7
+				if mode == "acc":
+					self.a = r
+				else:
+					self.mem[addr] = r
+			elif op == "inc": self.mem[addr] = self.flags(self.mem[addr] + 1)
+			elif op == "inx": self.x = self.flags(self.x + 1)
+			elif op == "iny": self.y = self.flags(self.y + 1)
+			elif op == "dex": self.x = self.flags(self.x - 1)
+			elif op == "dey": self.y = self.flags(self.y - 1)
+			else:
+				raise SystemExit("engine65.s: no model for '%s'" % line)
+		raise SystemExit("engine65.s: %s ran away" % name)
+
+	# cc65: every argument but the last on the C stack, the last in A/X
+	def isAttacked(self, square, side):
+		return self.call("_eng_IsAttacked", [square], side)
+
+	def slider(self, square, side, steps, count):
+		return self.call("_eng_GenSlider", [square, side, (steps,), 4, (LIST,)], count)
+
+	def make(self):
+		return self.call("_eng_MakeBoard", [(MOVE,)], UNDO)
+
+	def unmake(self):
+		return self.call("_eng_UnmakeBoard", [(MOVE,)], UNDO)
+
+
+class CpuZ80:
+	"""engineZ80.asm, called the way sccz80 calls a function: arguments
+	pushed left to right as words, the result in HL, the caller pops."""
+
+	R8 = ("a", "b", "c", "d", "e", "h", "l")
+	STACK = 0xF000
+	RETURN = 0xDEAD
+	IX = 0x7777
+
+	def __init__(self, path):
+		self.consts = {}
+		self.code = []
+		self.labels = {}
+		self.values = {}
+		self.mem = bytearray(0x10000)
+		self.parse(path.read_text())
+		self.r = dict.fromkeys(self.R8, 0)
+		self.ix = self.sp = 0
+		self.zf = self.cf = 0
+
+	def parse(self, text):
+		section, data = "code", 0x2000
+		for raw in text.split("\n"):
+			line = raw.split(";")[0].rstrip()
+			if not line.strip():
+				continue
+			s, label = line.strip(), None
+			m = re.match(r"^(\w+):\s*(.*)$", s)
+			if m and not line[0].isspace():
+				label, s = m.group(1), m.group(2).strip()
+			if s.startswith("SECTION"):
+				section = "data" if "rodata" in s else "code"
+				continue
+			if s.startswith(("PUBLIC", "EXTERN")):
+				continue
+			m = re.match(r"defc\s+(\w+)\s*=\s*(.+)", s)
+			if m:
+				self.consts[m.group(1)] = number(m.group(2), self.consts)
+				continue
+			if section == "data":
+				if label:
+					self.labels[label] = data
+				if s.startswith("defb"):
+					for v in s[4:].split(","):
+						self.mem[data] = number(v.strip(), self.consts) & 0xFF
+						data += 1
+				continue
+			if label:
+				self.labels[label] = len(self.code)
+			if s:
+				parts = s.split(None, 1)
+				self.code.append((parts[0], [x.strip() for x in parts[1].split(",")] if len(parts) > 1 else []))
+
+	def value(self, expr):
+		if expr not in self.values:
+			env = dict(self.consts)
+			env.update(SYMBOLS)
+			env.update(self.labels)
+			self.values[expr] = number(expr, env)
+		return self.values[expr]
+
+	def hl(self): return self.r["h"] << 8 | self.r["l"]
+	def de(self): return self.r["d"] << 8 | self.r["e"]
+	def setHl(self, v): self.r["h"], self.r["l"] = (v >> 8) & 0xFF, v & 0xFF
+	def setDe(self, v): self.r["d"], self.r["e"] = (v >> 8) & 0xFF, v & 0xFF
+
+	def push(self, v):
+		self.sp -= 2
+		self.mem[self.sp], self.mem[self.sp + 1] = v & 0xFF, (v >> 8) & 0xFF
+
+	def pop(self):
+		v = self.mem[self.sp] | self.mem[self.sp + 1] << 8
+		self.sp += 2
+		return v
+
+	def address(self, operand):
+		if operand == "(hl)":
+			return self.hl()
+		if operand == "(de)":
+			return self.de()
+		m = re.match(r"\(ix([+-]\d+)\)", operand)
+		if m:
+			return (self.ix + int(m.group(1))) & 0xFFFF
+		return self.value(operand[1:-1])
+
+	def read(self, operand):
+		if operand in self.R8:
+			return self.r[operand]
+		if operand.startswith("("):
+			return self.mem[self.address(operand)]
+		return self.value(operand) & 0xFF
+
+	def write(self, operand, v):
+		if operand in self.R8:
+			self.r[operand] = v & 0xFF
+		else:
+			self.mem[self.address(operand)] = v & 0xFF
+
+	def cond(self, c):
+		return {"z": self.zf, "nz": not self.zf, "c": self.cf, "nc": not self.cf}[c]
+
+	def call(self, name, args):
+		self.sp, self.ix = self.STACK, self.IX
+		for arg in args:
+			self.push(arg)
+		for reg in self.R8:
+			self.r[reg] = 0x5A
+		self.push(self.RETURN)
+		self.run(self.labels[name])
+		return self.hl(), self.sp == self.STACK - 2 * len(args) and self.ix == self.IX
+
+	def run(self, pc, limit=200000):
+		for _ in range(limit):
+			op, ops = self.code[pc]
+			pc += 1
+			if op == "ld":
+				dst, src = ops
+				if dst in ("hl", "de", "ix") and not src.startswith("("):
+					v = self.value(src) & 0xFFFF
+					if dst == "hl": self.setHl(v)
+					elif dst == "de": self.setDe(v)
+					else: self.ix = v
+				else:
+					self.write(dst, self.read(src))
+			elif op == "add" and ops[0] in ("hl", "ix"):
+				a = self.hl() if ops[0] == "hl" else self.ix
+				r = a + {"sp": self.sp, "hl": self.hl(), "de": self.de()}[ops[1]]
+				self.cf = int(r > 0xFFFF)
+				if ops[0] == "hl":
+					self.setHl(r & 0xFFFF)
+				else:
+					self.ix = r & 0xFFFF
+			elif op in ("add", "adc", "sub", "cp", "and", "or", "xor"):
+				a, v = self.r["a"], self.read(ops[-1])
+				if op == "add": r = a + v; self.cf = int(r > 0xFF)
+				elif op == "adc": r = a + v + self.cf; self.cf = int(r > 0xFF)
+				elif op in ("sub", "cp"): r = a - v; self.cf = int(r < 0)
+				else:
+					r = {"and": a & v, "or": a | v, "xor": a ^ v}[op]
+					self.cf = 0
+				r &= 0xFF
+				self.zf = int(r == 0)
+				if op != "cp":
+					self.r["a"] = r
+			elif op in ("inc", "dec"):
+				step, o = (1 if op == "inc" else -1), ops[0]
+				if o == "hl": self.setHl((self.hl() + step) & 0xFFFF)
+				elif o == "de": self.setDe((self.de() + step) & 0xFFFF)
+				elif o == "ix": self.ix = (self.ix + step) & 0xFFFF
+				else:
+					r = (self.read(o) + step) & 0xFF
+					self.write(o, r)
+					self.zf = int(r == 0)
+			elif op == "bit":
+				self.zf = int(not (self.read(ops[1]) >> int(ops[0])) & 1)
+			elif op == "rlca":
+				a = self.r["a"]
+				self.cf = a >> 7
+				self.r["a"] = ((a << 1) | self.cf) & 0xFF
+			elif op == "ex":
+				h = self.hl()
+				self.setHl(self.de())
+				self.setDe(h)
+			elif op == "push":
+				self.push(self.hl() if ops[0] == "hl" else self.ix)
+			elif op == "pop":
+				if ops[0] == "hl":
+					self.setHl(self.pop())
+				else:
+					self.ix = self.pop()
+			elif op in ("jr", "jp"):
+				if len(ops) == 1 or self.cond(ops[0]):
+					pc = self.labels[ops[-1]]
+			elif op == "call":
+				if len(ops) == 1 or self.cond(ops[0]):
+					self.push(pc)
+					pc = self.labels[ops[-1]]
+			elif op == "ret":
+				if not ops or self.cond(ops[0]):
+					pc = self.pop()
+					if pc == self.RETURN:
+						return
+			else:
+				raise SystemExit("engineZ80.asm: no model for '%s %s'" % (op, ",".join(ops)))
+		raise SystemExit("engineZ80.asm: ran away")
+
+	def isAttacked(self, square, side):
+		# the high bytes are junk on purpose: a char argument is only its low byte
+		return self.call("_eng_IsAttacked", [square | 0x3300, side | 0x4400])
+
+	def slider(self, square, side, steps, count):
+		return self.call("_eng_GenSlider", [square, side, steps, 4, LIST, count])
+
+	def make(self):
+		return self.call("_eng_MakeBoard", [MOVE, UNDO])
+
+	def unmake(self):
+		return self.call("_eng_UnmakeBoard", [MOVE, UNDO])
+
+
+def replay(cpu, records):
+	mem = cpu.mem
+	mem[ORTHOGONAL:ORTHOGONAL + 4] = bytes([0xF0, 0x10, 0xFF, 0x01])
+	mem[DIAGONAL:DIAGONAL + 4] = bytes([0xEF, 0xF1, 0x0F, 0x11])
+
+	def setState(state):
+		mem[BOARD:BOARD + STATE] = state
+
+	def state():
+		return bytes(mem[BOARD:BOARD + STATE])
+
+	counts = dict.fromkeys("ASMU", 0)
+	bad = 0
+	p = 0
+	while p < len(records):
+		kind = chr(records[p])
+		before = records[p + 1:p + 1 + STATE]
+		p += 1 + STATE
+		setState(before)
+		if kind == "A":
+			square, side, want = records[p:p + 3]
+			p += 3
+			got, stack = cpu.isAttacked(square, side)
+			ok = got == want and stack
+		elif kind == "S":
+			square, side, diagonal, captures, room, count, want = records[p:p + 7]
+			p += 7
+			moves = records[p:p + 4 * SLIDER_MOVES]
+			p += 4 * SLIDER_MOVES
+			mem[LIST:LIST + 512] = b"\xAA" * 512
+			mem[SYMBOLS["_sc_maxMoves"]] = room
+			mem[SYMBOLS["_sc_capturesOnly"]] = captures
+			got, stack = cpu.slider(square, side, DIAGONAL if diagonal else ORTHOGONAL, count)
+			ok = (got == want and stack and state() == before
+				and bytes(mem[LIST:LIST + 4 * SLIDER_MOVES]) == moves
+				and mem[LIST + 4 * SLIDER_MOVES:LIST + 512] == b"\xAA" * (512 - 4 * SLIDER_MOVES))
+		elif kind == "M":
+			move = records[p:p + 4]
+			after = records[p + 4:p + 4 + STATE]
+			p += 4 + STATE
+			undo, want = records[p:p + 4], records[p + 4]
+			p += 5
+			mem[MOVE:MOVE + 4] = move
+			mem[UNDO:UNDO + 4] = b"\x55" * 4
+			got, stack = cpu.make()
+			ok = got == want and stack and state() == after and bytes(mem[UNDO:UNDO + 4]) == undo
+		elif kind == "U":
+			move, undo = records[p:p + 4], records[p + 4:p + 8]
+			after = records[p + 8:p + 8 + STATE]
+			p += 8 + STATE
+			want = records[p]
+			p += 1
+			mem[MOVE:MOVE + 4] = move
+			mem[UNDO:UNDO + 4] = undo
+			got, stack = cpu.unmake()
+			ok = got == want and stack and state() == after
+		else:
+			raise SystemExit("bad record '%s' at %d" % (kind, p))
+		counts[kind] += 1
+		if not ok:
+			bad += 1
+			if bad <= 5:
+				print("  MISMATCH %s call %d" % (kind, counts[kind]))
+	return counts, bad
+
+
+def main():
+	cpus = {"6502": (Cpu6502, SRC / "engine65.s"), "z80": (CpuZ80, SRC / "spectrum" / "engineZ80.asm")}
+	if len(sys.argv) != 3 or sys.argv[1] not in cpus:
+		raise SystemExit("usage: kernelreplay.py 6502|z80 <kernels.bin>")
+	model, source = cpus[sys.argv[1]]
+	counts, bad = replay(model(source), Path(sys.argv[2]).read_bytes())
+	print("%s: %d attack, %d slider, %d make, %d unmake calls, %d mismatched"
+		% (source.name, counts["A"], counts["S"], counts["M"], counts["U"], bad))
+	sys.exit(1 if bad else 0)
+
+
+if __name__ == "__main__":
+	main()
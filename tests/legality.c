@@ -13,6 +13,7 @@
 #include "types.h"
 #include "engine.h"
 #include "eval.h"
+#include "board.h"
 #include "testutil.h"
 
 static int si_failures;
@@ -107,6 +108,52 @@ static void agreeAll(const char *fen, const char *label)
 	}
 }
 
+/*-----------------------------------------------------------------------*/
+// The cursor's legal move map against the long way in a position with more
+// destinations than one move list holds: every one of them has to be offered
+// and has to be found again when the player confirms it
+static void mapAll(const char *fen, char side, int want, const char *label)
+{
+	static char before[64][MAX_PIECE_MOVES], beforeCount[64];
+	t_engMove move;
+	char tile, i, found = 1;
+	int total = 0;
+	char what[72];
+
+	test_EngineSetFEN(fen);
+	for(tile = 0; tile < 64; ++tile)
+	{
+		// the map is only ever taken for the side to move
+		board_LegalMovesFrom(tile);
+		if(side != ((geBoard[ENG_FROM_TILE(tile)] & PIECE_WHITE) >> 7))
+			gNumMoveTiles = 0;
+		beforeCount[tile] = gNumMoveTiles;
+		memcpy(before[tile], gMoveTiles, gNumMoveTiles);
+		total += gNumMoveTiles;
+	}
+	sprintf(what, "%s: destinations the long way", label);
+	check(what, total, want);
+
+	board_LegalMap(side);
+	total = 0;
+	for(tile = 0; tile < 64; ++tile)
+	{
+		board_LegalMovesFrom(tile);
+		if(side != ((geBoard[ENG_FROM_TILE(tile)] & PIECE_WHITE) >> 7))
+			gNumMoveTiles = 0;
+		total += gNumMoveTiles;
+		if(gNumMoveTiles != beforeCount[tile] || memcmp(gMoveTiles, before[tile], gNumMoveTiles))
+			found = 0;
+		for(i = 0; i < gNumMoveTiles; ++i)
+			if(!board_FindMove(tile, gMoveTiles[i], QUEEN, &move))
+				found = 0;
+	}
+	sprintf(what, "%s: destinations after board_LegalMap", label);
+	check(what, total, want);
+	sprintf(what, "%s: every one offered and found", label);
+	check(what, found, 1);
+}
+
 /*-----------------------------------------------------------------------*/
 int test_RunLegality(int verbose)
 {
@@ -192,6 +239,11 @@ int test_RunLegality(int verbose)
 	agreeAll("8/8/8/K1pP3r/8/8/8/4k3 w - c6 0 1", "ep discovery pos");
 	agreeAll("4r3/8/8/8/8/2b5/8/4K3 w - - 0 1", "double check");
 
+	// more destinations than ENG_MAX_MOVES: 218 is the most known, and a
+	// side this wide has to be entered the long way
+	mapAll("R6R/3Q4/1Q4Q1/4Q3/2Q4Q/Q4Q2/pp1Q4/kBNN1KB1 w - - 0 1", SIDE_WHITE, 218, "218 moves");
+	mapAll("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", SIDE_WHITE, 20, "start");
+
 	printf("  -> %d failing\n", si_failures);
 	return si_failures;
 }
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "types.h"
 #include "globals.h"
 #include "testutil.h"
@@ -18,33 +19,56 @@ static void usage(const char *argv0)
 {
 	printf("usage: %s <command> [options]\n\n", argv0);
 	printf("  all                       run the pass/fail suite (exit != 0 on failure)\n");
-	printf("  eperft [depth]            perft on the new 0x88 core (default 4)\n");
+	printf("  eperft [depth]            perft on the new 0x88 core (default 4, up to 7)\n");
 	printf("  budget                    nodes needed to complete each depth, through a game\n");
 	printf("  qgen                      capture generator against the filtered full one\n");
 	printf("  divide <fen> <depth>      per-move node counts for the new core\n");
 	printf("  tactics                   search finds the obvious moves\n");
 	printf("  convert                   won endings finished before the fifty-move rule\n");
-	printf("  bench                     search speed on the host\n");
+	printf("  bench [--json]            node signature and nodes/sec over a fixed list\n");
 	printf("  match [sanity|terms|depth|repeat|drive|endgame|queen|pawn|dev]  configuration A vs B\n");
 	printf("  pawnstruct                doubled/isolated file counts and scores\n");
 	printf("  dev                       queen-before-minors scores and live switch\n");
 	printf("  fuzz [seed] [games]       random games through the game path, undo/redo checked\n");
+	printf("  fuzz --seeds A..B         the games from seeds A to B, over --jobs workers\n");
 	printf("  castle                    castling and en passant rules\n");
+	printf("  redraw                    the tiles a move, undo or B toggle draws\n");
 	printf("  repeat                    repetition detection and its history\n");
 	printf("  opening                   opening randomisation, and that it stops\n");
+	printf("  book                      opening book lookup and the host book file\n");
+	printf("  evalfit                   tuner's coefficients rebuild eval_Position\n");
+	printf("  capi                      the libcc65chess.so API against the engine\n");
 	printf("  selfplay [games] [plies]  AI against itself, with timings\n");
 	printf("\noptions: -v for more detail\n");
+	printf("         --jobs N  workers for eperft, divide and fuzz --seeds (default: all cores)\n");
+	printf("         --hash MB perft hash per worker, 0 for none (default 64)\n");
 }
 
 /*-----------------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
-	int failures = 0, verbose = 0, i;
+	int failures = 0, verbose = 0, json = 0, jobs, i;
+	int firstSeed = 0, lastSeed = -1;
 	const char *command;
 
+	jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
 	for(i = 1; i < argc; ++i)
 		if(!strcmp(argv[i], "-v"))
 			verbose = 1;
+		else if(!strcmp(argv[i], "--json"))
+			json = 1;
+		else if(!strcmp(argv[i], "--jobs") && i + 1 < argc)
+			jobs = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--hash") && i + 1 < argc)
+			test_PerftHashSize(atoi(argv[++i]));
+		else if(!strcmp(argv[i], "--seeds") && i + 1 < argc &&
+		        2 != sscanf(argv[++i], "%d..%d", &firstSeed, &lastSeed))
+		{
+			usage(argv[0]);
+			return 2;
+		}
+	if(jobs < 1)
+		jobs = 1;
 
 	if(argc < 2)
 	{
@@ -58,16 +82,22 @@ int main(int argc, char **argv)
 		printf("== cc65 Chess test suite ==\n\n");
 		failures += test_RunCastle(verbose);
 		printf("\n");
+		failures += test_RunRedraw(verbose);
+		printf("\n");
 		failures += test_RunLegality(verbose);
 		printf("\n");
 		failures += test_RunRepetition(verbose);
 		printf("\n");
 		failures += test_RunOpening(verbose);
 		printf("\n");
+		failures += test_RunBook(verbose);
+		printf("\n");
 		failures += test_RunGameFuzz(1, 150, verbose);
 		failures += test_RunGameFuzz(5000, 150, verbose);
 		printf("\n");
-		failures += test_RunEnginePerft(5, verbose);
+		// depth 6 where a quarter of a billion nodes a core covers it: the
+		// initial position and the ending on one core, the rest as cores allow
+		failures += test_RunEnginePerft(6, jobs, 250000000L, verbose);
 		printf("\n");
 		failures += test_RunQuiescenceGen(verbose);
 		printf("\n");
@@ -83,18 +113,44 @@ int main(int argc, char **argv)
 		printf("\n");
 		failures += test_RunSearchAspiration(verbose);
 		printf("\n");
+#if SEARCH_STATS
+		failures += test_RunSearchStats(verbose);
+		printf("\n");
+#endif
+#if SEARCH_TRACE
+		failures += test_RunSearchTrace(verbose);
+		printf("\n");
+#endif
+#if SEARCH_NPS
+		failures += test_RunSearchTimed(verbose);
+		printf("\n");
+#endif
+#if SEARCH_IDLE
+		failures += test_RunSearchIdle(verbose);
+		printf("\n");
+#endif
 		failures += test_RunSearchMateInOne(verbose);
 		printf("\n");
 		failures += test_RunSearchConversion(verbose);
 		printf("\n");
 		failures += test_RunSearchAlwaysMoves(verbose);
 		printf("\n");
+		failures += test_RunSearchBench(0, 0);
+		printf("\n");
+#if PLAT_BANKS
+		failures += test_RunBanks(verbose);
+		printf("\n");
+#endif
 		failures += test_RunMatchSanity(0);
 		printf("\n");
 		failures += test_RunPawnStruct(verbose);
 		printf("\n");
 		failures += test_RunDev(verbose);
 		printf("\n");
+		failures += test_RunEvalFit(verbose);
+		printf("\n");
+		failures += test_RunCApi(verbose);
+		printf("\n");
 		failures += test_RunSelfPlay(1, 120, 0);
 		printf("\n== %s ==\n", failures ? "FAILED" : "all green");
 		return failures ? 1 : 0;
@@ -135,10 +191,10 @@ int main(int argc, char **argv)
 		return test_RunDev(verbose) ? 1 : 0;
 
 	if(!strcmp(command, "bench"))
-		return test_RunSearchBench(verbose) ? 1 : 0;
+		return test_RunSearchBench(verbose, json) ? 1 : 0;
 
 	if(!strcmp(command, "eperft"))
-		return test_RunEnginePerft(argc > 2 && argv[2][0] != '-' ? atoi(argv[2]) : 4, verbose) ? 1 : 0;
+		return test_RunEnginePerft(argc > 2 && argv[2][0] != '-' ? atoi(argv[2]) : 4, jobs, 0, verbose) ? 1 : 0;
 
 	if(!strcmp(command, "budget"))
 		return test_RunBudgetSurvey(1);
@@ -149,10 +205,13 @@ int main(int argc, char **argv)
 	if(!strcmp(command, "divide"))
 	{
 		if(argc < 4) { usage(argv[0]); return 2; }
-		test_EnginePerftDivide(argv[2], atoi(argv[3]));
+		test_EnginePerftDivide(argv[2], atoi(argv[3]), jobs);
 		return 0;
 	}
 
+	if(!strcmp(command, "fuzz") && lastSeed >= firstSeed)
+		return test_RunGameFuzzSeeds(firstSeed, lastSeed, jobs, verbose) ? 1 : 0;
+
 	if(!strcmp(command, "fuzz"))
 		return test_RunGameFuzz(argc > 2 && argv[2][0] != '-' ? atoi(argv[2]) : 1,
 		                    argc > 3 && argv[3][0] != '-' ? atoi(argv[3]) : 200,
@@ -161,12 +220,24 @@ int main(int argc, char **argv)
 	if(!strcmp(command, "castle"))
 		return test_RunCastle(verbose) ? 1 : 0;
 
+	if(!strcmp(command, "redraw"))
+		return test_RunRedraw(verbose) ? 1 : 0;
+
 	if(!strcmp(command, "repeat"))
 		return test_RunRepetition(verbose) ? 1 : 0;
 
 	if(!strcmp(command, "opening"))
 		return test_RunOpening(verbose) ? 1 : 0;
 
+	if(!strcmp(command, "book"))
+		return test_RunBook(verbose) ? 1 : 0;
+
+	if(!strcmp(command, "evalfit"))
+		return test_RunEvalFit(verbose) ? 1 : 0;
+
+	if(!strcmp(command, "capi"))
+		return test_RunCApi(verbose) ? 1 : 0;
+
 	if(!strcmp(command, "selfplay"))
 		return test_RunSelfPlay(argc > 2 && argv[2][0] != '-' ? atoi(argv[2]) : 1,
 		                        argc > 3 && argv[3][0] != '-' ? atoi(argv[3]) : 200,
@@ -0,0 +1,486 @@
+/*
+ *	micro.c
+ *	cc65 Chess - test support
+ *
+ *	The engine's primitives timed one at a time on the host, over positions
+ *	from book.epd, so a change to one of them can be priced in seconds before
+ *	it is priced in emulator minutes by tests/c64profile.c.
+ *
+ *	Each benchmark is a pass over the corpus: a position is set up outside
+ *	the clock, then the primitive runs --inner times on it inside.  --warmup
+ *	passes are thrown away, --reps are kept, and the minimum and median of
+ *	nanoseconds per call are reported.  The minimum is the one to compare
+ *	between builds; the gap to the median is how noisy the host was.
+ *
+ *	Anything public is called directly.  The running evaluation, the key and
+ *	the history ring are kept inside eng_Make and eng_Unmake, so those rows
+ *	are differences between three versions of the same make/unmake pair: the
+ *	search's, quiescence's without the history, and eng_ProfileBoardPair's
+ *	with only the board - which is why this is built with SEARCH_PROFILE.
+ *	c64profile's trick of doing a component twice does not carry over: gcc
+ *	sees the second hashDelta is the first and drops it, where cc65 does not.
+ *	The two passes of a difference are timed back to back, so the host's
+ *	drift lands on both, and it is minimum less minimum.
+ *
+ *	Built like tests/uci, without EVAL_TUNING, so the code timed is the code
+ *	that ships.
+ *
+ *	  ./micro
+ *	  ./micro --positions 32 --reps 31 --csv
+ *	  ./micro --only make --json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "eval.h"
+#include "search.h"
+#include "c64profile.h"
+#include "testutil.h"
+
+#define MAX_POSITIONS	256
+#define MAX_REPS		201
+#define FEN_BYTES		96
+#define HISTORY_PLIES	8
+
+typedef struct tag_microOptions
+{
+	int		m_warmup;
+	int		m_reps;
+	int		m_inner;
+} t_microOptions;
+
+// One pass over the corpus.  Returns the calls made and adds the time they
+// took to *ns
+typedef long (*t_microPass)(int inner, double *ns);
+
+typedef struct tag_microBench
+{
+	const char	*m_name;
+	const char	*m_what;
+	t_microPass	m_pass;
+	t_microPass	m_base;			// when set, the row is m_pass less this
+} t_microBench;
+
+static char st_fens[MAX_POSITIONS][FEN_BYTES];
+static int st_nfens;
+
+static volatile long sl_sink;
+
+/*-----------------------------------------------------------------------*/
+static int loadCorpus(const char *path, int limit)
+{
+	FILE *fp = fopen(path, "r");
+	char line[256];
+	size_t len;
+
+	if(!fp)
+	{
+		fprintf(stderr, "micro: cannot open %s\n", path);
+		return 0;
+	}
+	st_nfens = 0;
+	while(st_nfens < limit && st_nfens < MAX_POSITIONS && fgets(line, sizeof(line), fp))
+	{
+		char *nl = strpbrk(line, "\r\n");
+		if(nl)
+			*nl = '\0';
+		if(!line[0] || line[0] == '#')
+			continue;
+		len = strlen(line);
+		if(len > FEN_BYTES - 1)
+			len = FEN_BYTES - 1;
+		memcpy(st_fens[st_nfens], line, len);
+		st_fens[st_nfens][len] = '\0';
+		++st_nfens;
+	}
+	fclose(fp);
+	return st_nfens > 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static double nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*-----------------------------------------------------------------------*/
+// Every square, attacked by the side not to move - the question legality and
+// the check test ask
+static long passIsAttacked(int inner, double *ns)
+{
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]), tile, hits = 0;
+		double start = nowNs();
+
+		for(n = 0; n < inner; ++n)
+			for(tile = 0; tile < 64; ++tile)
+				hits += eng_IsAttacked(ENG_FROM_TILE(tile), (char)(1 - side));
+		*ns += nowNs() - start;
+		sl_sink += hits;
+		calls += 64L * inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+static long passGenMoves(int inner, double *ns)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]);
+		double start = nowNs();
+
+		for(n = 0; n < inner; ++n)
+			sl_sink += eng_GenMoves(side, moves, ENG_MAX_MOVES);
+		*ns += nowNs() - start;
+		calls += inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+static long passGenCaptures(int inner, double *ns)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]);
+		double start = nowNs();
+
+		for(n = 0; n < inner; ++n)
+			sl_sink += eng_GenCaptures(side, moves, ENG_MAX_MOVES);
+		*ns += nowNs() - start;
+		calls += inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+static long passGenLegal(int inner, double *ns)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]);
+		double start = nowNs();
+
+		for(n = 0; n < inner; ++n)
+			sl_sink += eng_GenLegalMoves(side, moves);
+		*ns += nowNs() - start;
+		calls += inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+// Every pseudo-legal move made and unmade
+static long makeUnmake(int inner, double *ns, char history)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	t_engUndo undo;
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]), count, i;
+		double start;
+
+		count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+		eng_HistoryEnable(history);
+		start = nowNs();
+		for(n = 0; n < inner; ++n)
+			for(i = 0; i < count; ++i)
+			{
+				eng_Make(&moves[i], &undo);
+				eng_Unmake(&moves[i], &undo);
+			}
+		*ns += nowNs() - start;
+		eng_HistoryEnable(1);
+		calls += (long)count * inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+// As the main search makes moves, and as quiescence does
+static long passMakeUnmake(int inner, double *ns) { return makeUnmake(inner, ns, 1); }
+static long passMakeNoHistory(int inner, double *ns) { return makeUnmake(inner, ns, 0); }
+
+/*-----------------------------------------------------------------------*/
+// The same pairs with nothing but the board: no evaluation, key or history
+static long passBoardPair(int inner, double *ns)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]), count, i;
+		double start;
+
+		count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+		start = nowNs();
+		for(n = 0; n < inner; ++n)
+			for(i = 0; i < count; ++i)
+				eng_ProfileBoardPair(&moves[i]);
+		*ns += nowNs() - start;
+		calls += (long)count * inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+static long passMoveDelta(int inner, double *ns)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]), count, i;
+		int total = 0;
+		double start;
+
+		count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+		start = nowNs();
+		for(n = 0; n < inner; ++n)
+			for(i = 0; i < count; ++i)
+				total += eval_MoveDelta(&moves[i], geBoard[moves[i].m_from], geBoard[moves[i].m_to]);
+		*ns += nowNs() - start;
+		sl_sink += total;
+		calls += (long)count * inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+static long passEvalPosition(int inner, double *ns)
+{
+	long calls = 0;
+	int p, n;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]);
+		int total = 0;
+		double start = nowNs();
+
+		for(n = 0; n < inner; ++n)
+			total += eval_Position(side);
+		*ns += nowNs() - start;
+		sl_sink += total;
+		calls += inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+// The search's one-repeat question, after a few plies have been played so
+// the scan has something to walk
+static long passIsRepetition(int inner, double *ns)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	t_engUndo undo;
+	long calls = 0;
+	int p, n, ply;
+
+	for(p = 0; p < st_nfens; ++p)
+	{
+		char side = test_EngineSetFEN(st_fens[p]), hits = 0;
+		double start;
+
+		for(ply = 0; ply < HISTORY_PLIES && eng_GenLegalMoves(side, moves); ++ply)
+		{
+			eng_Make(&moves[0], &undo);
+			side = 1 - side;
+		}
+		start = nowNs();
+		for(n = 0; n < inner; ++n)
+			hits += eng_IsRepetition(1);
+		*ns += nowNs() - start;
+		sl_sink += hits;
+		calls += inner;
+	}
+	return calls;
+}
+
+/*-----------------------------------------------------------------------*/
+static const t_microBench stc_benches[] =
+{
+	{ "is_attacked",   "eng_IsAttacked, one square",                 passIsAttacked,    0 },
+	{ "gen_moves",     "eng_GenMoves, whole position",               passGenMoves,      0 },
+	{ "gen_captures",  "eng_GenCaptures, whole position",            passGenCaptures,   0 },
+	{ "gen_legal",     "eng_GenLegalMoves, whole position",          passGenLegal,      0 },
+	{ "make_unmake",   "eng_Make + eng_Unmake, as the search",       passMakeUnmake,    0 },
+	{ "make_qsearch",  "the same pair, history off, as quiescence",  passMakeNoHistory, 0 },
+	{ "board_pair",    "the same pair, board only",                  passBoardPair,     0 },
+	{ "eval_deltas",   "make_qsearch less board_pair",               passMakeNoHistory, passBoardPair },
+	{ "key_history",   "make_unmake less make_qsearch",              passMakeUnmake,    passMakeNoHistory },
+	{ "move_delta",    "eval_MoveDelta",                             passMoveDelta,     0 },
+	{ "eval_position", "eval_Position",                              passEvalPosition,  0 },
+	{ "is_repetition", "eng_IsRepetition(1), 8 plies in",            passIsRepetition,  0 },
+};
+
+#define NUM_BENCHES	((int)(sizeof(stc_benches) / sizeof(stc_benches[0])))
+
+/*-----------------------------------------------------------------------*/
+static int compareDouble(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*-----------------------------------------------------------------------*/
+static double timePass(t_microPass pass, int inner, long *calls)
+{
+	double ns = 0;
+
+	*calls = pass(inner, &ns);
+	return *calls ? ns / *calls : 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// A difference row is the minimum less the minimum and the median less the
+// median.  The minimum of the differences would be the one rep where the
+// host happened to slow the base down, which is noise, not a cost
+static void runBench(const t_microBench *bench, const t_microOptions *options,
+                     double *minNs, double *medianNs, long *calls)
+{
+	static double samples[MAX_REPS], base[MAX_REPS];
+	int r;
+
+	for(r = -options->m_warmup; r < options->m_reps; ++r)
+	{
+		double ns = timePass(bench->m_pass, options->m_inner, calls), baseNs = 0;
+
+		if(bench->m_base)
+		{
+			long baseCalls;
+
+			baseNs = timePass(bench->m_base, options->m_inner, &baseCalls);
+		}
+		if(r >= 0)
+		{
+			samples[r] = ns;
+			base[r] = baseNs;
+		}
+	}
+
+	qsort(samples, (size_t)options->m_reps, sizeof(samples[0]), compareDouble);
+	qsort(base, (size_t)options->m_reps, sizeof(base[0]), compareDouble);
+	*minNs = samples[0] - base[0];
+	*medianNs = samples[options->m_reps / 2] - base[options->m_reps / 2];
+}
+
+/*-----------------------------------------------------------------------*/
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: micro [--book FILE] [--positions N] [--warmup W] [--reps R]\n"
+		"             [--inner I] [--only NAME] [--csv | --json]\n");
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	const char *book = "book.epd", *only = 0;
+	t_microOptions options;
+	int positions = 64, csv = 0, json = 0, b, i, printed = 0;
+
+	options.m_warmup = 3;
+	options.m_reps = 15;
+	options.m_inner = 50;
+
+	for(i = 1; i < argc; ++i)
+	{
+		if(0 == strcmp(argv[i], "--book") && i + 1 < argc)
+			book = argv[++i];
+		else if(0 == strcmp(argv[i], "--positions") && i + 1 < argc)
+			positions = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--warmup") && i + 1 < argc)
+			options.m_warmup = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--reps") && i + 1 < argc)
+			options.m_reps = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--inner") && i + 1 < argc)
+			options.m_inner = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--only") && i + 1 < argc)
+			only = argv[++i];
+		else if(0 == strcmp(argv[i], "--csv"))
+			csv = 1;
+		else if(0 == strcmp(argv[i], "--json"))
+			json = 1;
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+	if(options.m_reps < 1 || options.m_reps > MAX_REPS || options.m_warmup < 0 ||
+	   options.m_inner < 1 || positions < 1 || (csv && json))
+	{
+		usage();
+		return 2;
+	}
+
+	if(!loadCorpus(book, positions))
+		return 1;
+
+	if(csv)
+		printf("name,min_ns,median_ns,calls_per_pass\n");
+	else if(json)
+		printf("{\"positions\": %d, \"reps\": %d, \"benches\": [", st_nfens, options.m_reps);
+	else
+		printf("%d positions from %s, %d warmup + %d reps, min and median ns per call\n"
+		       "  %-14s %9s %9s  %s\n", st_nfens, book, options.m_warmup, options.m_reps,
+		       "", "min", "median", "");
+
+	for(b = 0; b < NUM_BENCHES; ++b)
+	{
+		const t_microBench *bench = &stc_benches[b];
+		double minNs, medianNs;
+		long calls;
+
+		if(only && !strstr(bench->m_name, only))
+			continue;
+		runBench(bench, &options, &minNs, &medianNs, &calls);
+
+		if(csv)
+			printf("%s,%.2f,%.2f,%ld\n", bench->m_name, minNs, medianNs, calls);
+		else if(json)
+			printf("%s\n  {\"name\": \"%s\", \"min_ns\": %.2f, \"median_ns\": %.2f, \"calls\": %ld}",
+			       printed ? "," : "", bench->m_name, minNs, medianNs, calls);
+		else
+			printf("  %-14s %9.1f %9.1f  %s\n", bench->m_name, minNs, medianNs, bench->m_what);
+		++printed;
+	}
+
+	if(json)
+		printf("]}\n");
+	return 0;
+}
@@ -0,0 +1,437 @@
+/*
+ *	mkbook.c
+ *	cc65 Chess - test support
+ *
+ *	Builds the opening book from EPD and PGN.  One set of lines, two outputs:
+ *	a Polyglot-layout file with 64 bit keys for the host (tests/uci's BookFile),
+ *	and src/bookdata.h with 16 bit keys for the ports that build with BOOK_ON.
+ *
+ *	  ./mkbook [-p plies] [-o book.bin] [-c bookdata.h] input.epd|input.pgn ...
+ *	  ./mkbook -r book.bin "<fen>"		list a position's entries
+ *
+ *	EPD lines add each move in their "bm" operation at weight 1.  PGN games,
+ *	which is what gauntlet.py and sargon/match.py leave behind, add every move
+ *	of the first "plies" plies at Polyglot's usual weights: 2 for the side that
+ *	went on to win, 1 for a draw or an unfinished game, nothing for the loser.
+ *	A line that is only ever lost therefore never reaches the book, and the
+ *	more a move scored the more often it comes up.
+ *
+ *	The 16 bit output scales each position's weights into 1..255, which keeps
+ *	the proportions and fits a byte.  A 16 bit key is not unique across a
+ *	large book: two positions sharing one are reported, and book.c's legality
+ *	check is what makes a collision cost a search rather than a wrong move.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "eval.h"
+#include "book.h"
+#include "polybook.h"
+#include "testutil.h"
+
+#define LINE_MAX_LEN	4096
+#define DEFAULT_PLIES	16
+
+typedef struct tag_bookLine
+{
+	uint64_t		m_key64;
+	unsigned int	m_key16;
+	uint16_t		m_move;
+	char			m_from;
+	char			m_to;				// book.h's packed tile and promotion
+	unsigned long	m_weight;
+} t_bookLine;
+
+static t_bookLine	*st_lines;
+static long			sl_numLines, sl_maxLines;
+static long			sl_games, sl_skipped;
+
+/*-----------------------------------------------------------------------*/
+// One position and move.  Repeats are merged once everything is read
+static void addLine(char side, const t_engMove *move, unsigned long weight)
+{
+	if(sl_numLines == sl_maxLines)
+	{
+		sl_maxLines = sl_maxLines ? sl_maxLines * 2 : 1024;
+		st_lines = (t_bookLine *)realloc(st_lines, sl_maxLines * sizeof(t_bookLine));
+		if(!st_lines)
+		{
+			fprintf(stderr, "mkbook: out of memory\n");
+			exit(1);
+		}
+	}
+
+	{
+		t_bookLine *line = &st_lines[sl_numLines++];
+		char promo = move->m_flags & ENG_MF_PROMO;
+
+		line->m_key64 = polybook_Key(side);
+		line->m_key16 = book_Key(side);
+		line->m_move = polybook_EncodeMove(move);
+		line->m_from = ENG_TO_TILE(move->m_from);
+		line->m_to = ENG_TO_TILE(move->m_to) |
+		             (promo ? (char)((promo - 1) << BOOK_PROMO_SHIFT) : 0);
+		line->m_weight = weight;
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+static void readEPD(FILE *file)
+{
+	char text[LINE_MAX_LEN];
+
+	while(fgets(text, sizeof(text), file))
+	{
+		char *ops = strstr(text, " bm ");
+		char *end, *tok, side;
+
+		if(!ops)
+			continue;
+		side = test_EngineSetFEN(text);
+		ops += 4;
+		end = strchr(ops, ';');
+		if(end)
+			*end = '\0';
+
+		for(tok = strtok(ops, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n"))
+		{
+			t_engMove move;
+
+			if(test_ParseMove(side, tok, &move))
+				addLine(side, &move, 1);
+			else
+				++sl_skipped;
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+// Only the first "plies" plies of each game count.  The result is read from
+// the movetext terminator, which every PGN writer puts there, rather than the
+// header, which some leave as "*"
+static void playGame(char *movetext, int plies)
+{
+	static t_engMove moves[512];
+	static char sides[512];
+	unsigned long weights[2] = { 1, 1 };			// by side
+	char *tok, side = SIDE_WHITE, unreadable = 0;
+	int count = 0, i;
+
+	eng_SetStartPosition();
+
+	for(tok = strtok(movetext, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n"))
+	{
+		t_engMove move;
+		t_engUndo undo;
+
+		if(!strcmp(tok, "1-0"))			{ weights[SIDE_WHITE] = 2; weights[SIDE_BLACK] = 0; break; }
+		if(!strcmp(tok, "0-1"))			{ weights[SIDE_WHITE] = 0; weights[SIDE_BLACK] = 2; break; }
+		if(!strcmp(tok, "1/2-1/2") || !strcmp(tok, "*"))
+			break;
+		if(isdigit((unsigned char)tok[0]) || '$' == tok[0])
+		{
+			// "12." or "12..." or a NAG; "12.e4" with no space still has a move
+			while(*tok && (isdigit((unsigned char)*tok) || '.' == *tok || '$' == *tok))
+				++tok;
+			if(!*tok)
+				continue;
+		}
+		if(unreadable || count >= plies || count >= (int)(sizeof(moves) / sizeof(moves[0])))
+			continue;
+		if(!test_ParseMove(side, tok, &move))
+		{
+			++sl_skipped;
+			unreadable = 1;			// and so is the rest of the game
+			continue;
+		}
+		moves[count] = move;
+		sides[count++] = side;
+		eng_Make(&move, &undo);
+		side = 1 - side;
+	}
+
+	// replay, now the result says what each side's moves were worth
+	eng_SetStartPosition();
+	for(i = 0; i < count; ++i)
+	{
+		t_engUndo undo;
+
+		if(weights[(int)sides[i]])
+			addLine(sides[i], &moves[i], weights[(int)sides[i]]);
+		eng_Make(&moves[i], &undo);
+	}
+	++sl_games;
+}
+
+/*-----------------------------------------------------------------------*/
+// Headers are skipped, comments and variations are blanked, and a game ends
+// at the line after its movetext
+static void readPGN(FILE *file, int plies)
+{
+	static char movetext[65536];
+	char text[LINE_MAX_LEN];
+	size_t used = 0;
+	int depth = 0;
+
+	movetext[0] = '\0';
+	for(;;)
+	{
+		char *got = fgets(text, sizeof(text), file), *p;
+
+		if(!got || ('[' == text[0] && used))
+		{
+			if(used)
+				playGame(movetext, plies);
+			used = 0;
+			movetext[0] = '\0';
+			depth = 0;
+			if(!got)
+				break;
+		}
+		if('[' == text[0] || '%' == text[0])
+			continue;
+
+		for(p = text; *p; ++p)
+		{
+			if(!depth && ';' == *p)
+				break;							// comment to end of line
+			if('{' == *p || '(' == *p)
+			{
+				++depth;
+				continue;
+			}
+			if('}' == *p || ')' == *p)
+			{
+				if(depth)
+					--depth;
+				continue;
+			}
+			if(!depth && used < sizeof(movetext) - 2)
+				movetext[used++] = *p;
+		}
+		if(used < sizeof(movetext) - 2)
+			movetext[used++] = ' ';
+		movetext[used] = '\0';
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+static int compareKey64(const void *a, const void *b)
+{
+	const t_bookLine *x = (const t_bookLine *)a, *y = (const t_bookLine *)b;
+
+	if(x->m_key64 != y->m_key64)
+		return x->m_key64 < y->m_key64 ? -1 : 1;
+	return (int)x->m_move - (int)y->m_move;
+}
+
+/*-----------------------------------------------------------------------*/
+// The same move from the same position, from however many games, is one
+// entry carrying all their weight
+static void mergeLines(void)
+{
+	long i, out = 0;
+
+	qsort(st_lines, (size_t)sl_numLines, sizeof(t_bookLine), compareKey64);
+	for(i = 0; i < sl_numLines; ++i)
+	{
+		if(out && st_lines[out - 1].m_key64 == st_lines[i].m_key64 &&
+		   st_lines[out - 1].m_move == st_lines[i].m_move)
+			st_lines[out - 1].m_weight += st_lines[i].m_weight;
+		else
+			st_lines[out++] = st_lines[i];
+	}
+	sl_numLines = out;
+}
+
+/*-----------------------------------------------------------------------*/
+static int compareKey16(const void *a, const void *b)
+{
+	const t_bookLine *x = (const t_bookLine *)a, *y = (const t_bookLine *)b;
+
+	if(x->m_key16 != y->m_key16)
+		return x->m_key16 < y->m_key16 ? -1 : 1;
+	if(x->m_key64 != y->m_key64)
+		return x->m_key64 < y->m_key64 ? -1 : 1;
+	if(x->m_weight != y->m_weight)
+		return x->m_weight > y->m_weight ? -1 : 1;
+	return (int)x->m_move - (int)y->m_move;
+}
+
+/*-----------------------------------------------------------------------*/
+static int writeHeader(const char *path, int argc, char **argv, int first)
+{
+	FILE *file = fopen(path, "w");
+	long i, start, collisions = 0;
+	int a;
+
+	if(!file)
+		return 0;
+
+	qsort(st_lines, (size_t)sl_numLines, sizeof(t_bookLine), compareKey16);
+
+	fprintf(file, "/*\n *\tbookdata.h\n *\tcc65 Chess\n *\n");
+	fprintf(file, " *\tGenerated by tests/mkbook - do not edit.  Rebuild with\n *\t  ./mkbook -c ../src/bookdata.h");
+	for(a = first; a < argc; ++a)
+		fprintf(file, " %s", argv[a]);
+	fprintf(file, "\n *\n *\t%ld entries.  Sorted by key for book.c's binary search.\n */\n\n", sl_numLines);
+	fprintf(file, "const t_bookEntry gcBook[] =\n{\n");
+
+	for(start = 0; start < sl_numLines; )
+	{
+		unsigned long most = 0;
+		long end;
+
+		for(end = start; end < sl_numLines && st_lines[end].m_key16 == st_lines[start].m_key16; ++end)
+		{
+			if(st_lines[end].m_weight > most)
+				most = st_lines[end].m_weight;
+			if(st_lines[end].m_key64 != st_lines[start].m_key64)
+				++collisions;
+		}
+
+		for(i = start; i < end; ++i)
+		{
+			unsigned long weight = (st_lines[i].m_weight * 255 + most - 1) / most;
+			char from[3], to[3];
+
+			test_TileName(st_lines[i].m_from, from);
+			test_TileName(st_lines[i].m_to & BOOK_TILE_MASK, to);
+			fprintf(file, "\t{ 0x%04X, %2d, %3d, %3lu },\t// %s%s\n",
+			        st_lines[i].m_key16, st_lines[i].m_from, (unsigned char)st_lines[i].m_to,
+			        weight ? weight : 1, from, to);
+		}
+		start = end;
+	}
+
+	fprintf(file, "};\n");
+	fclose(file);
+
+	if(collisions)
+		fprintf(stderr, "mkbook: %ld entries share a 16 bit key with another position\n",
+		        collisions);
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+static int writeBin(const char *path)
+{
+	t_polyEntry *entries = (t_polyEntry *)malloc((sl_numLines ? sl_numLines : 1) * sizeof(t_polyEntry));
+	long i;
+	int ok;
+
+	if(!entries)
+		return 0;
+	for(i = 0; i < sl_numLines; ++i)
+	{
+		entries[i].m_key = st_lines[i].m_key64;
+		entries[i].m_move = st_lines[i].m_move;
+		entries[i].m_weight = (uint16_t)(st_lines[i].m_weight > 0xFFFF ? 0xFFFF : st_lines[i].m_weight);
+		entries[i].m_learn = 0;
+	}
+	ok = polybook_Write(path, entries, sl_numLines);
+	free(entries);
+	return ok;
+}
+
+/*-----------------------------------------------------------------------*/
+static int listPosition(const char *path, const char *fen)
+{
+	const t_polyEntry *entries;
+	char side;
+	long count, i;
+
+	if(polybook_Load(path) < 0)
+	{
+		fprintf(stderr, "mkbook: cannot read %s\n", path);
+		return 1;
+	}
+	side = test_EngineSetFEN(fen);
+	count = polybook_Find(polybook_Key(side), &entries);
+	printf("%016llX: %ld entries\n", (unsigned long long)polybook_Key(side), count);
+	for(i = 0; i < count; ++i)
+	{
+		t_engMove move;
+		char from[3], to[3];
+
+		if(!polybook_DecodeMove(side, entries[i].m_move, &move))
+		{
+			printf("  %04X (not legal here) %u\n", entries[i].m_move, entries[i].m_weight);
+			continue;
+		}
+		test_TileName(ENG_TO_TILE(move.m_from), from);
+		test_TileName(ENG_TO_TILE(move.m_to), to);
+		printf("  %s%s %u\n", from, to, entries[i].m_weight);
+	}
+	polybook_Free();
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	const char *binPath = NULL, *headerPath = NULL;
+	int plies = DEFAULT_PLIES, a;
+
+	if(argc > 3 && !strcmp(argv[1], "-r"))
+		return listPosition(argv[2], argv[3]);
+
+	for(a = 1; a < argc && '-' == argv[a][0]; a += 2)
+	{
+		if(a + 1 >= argc)
+			break;
+		if(!strcmp(argv[a], "-p"))		plies = atoi(argv[a + 1]);
+		else if(!strcmp(argv[a], "-o"))	binPath = argv[a + 1];
+		else if(!strcmp(argv[a], "-c"))	headerPath = argv[a + 1];
+	}
+
+	if(a >= argc || (!binPath && !headerPath))
+	{
+		fprintf(stderr, "usage: %s [-p plies] [-o book.bin] [-c bookdata.h] file.epd|file.pgn ...\n"
+		                "       %s -r book.bin \"<fen>\"\n", argv[0], argv[0]);
+		return 2;
+	}
+
+	{
+		int first = a;
+
+		for(; a < argc; ++a)
+		{
+			FILE *file = fopen(argv[a], "r");
+			size_t len = strlen(argv[a]);
+
+			if(!file)
+			{
+				fprintf(stderr, "mkbook: cannot read %s\n", argv[a]);
+				return 1;
+			}
+			if(len > 4 && !strcmp(argv[a] + len - 4, ".pgn"))
+				readPGN(file, plies);
+			else
+				readEPD(file);
+			fclose(file);
+		}
+
+		mergeLines();
+		fprintf(stderr, "mkbook: %ld entries, %ld games, %ld moves not understood\n",
+		        sl_numLines, sl_games, sl_skipped);
+
+		if(binPath && !writeBin(binPath))
+		{
+			fprintf(stderr, "mkbook: cannot write %s\n", binPath);
+			return 1;
+		}
+		if(headerPath && !writeHeader(headerPath, argc, argv, first))
+		{
+			fprintf(stderr, "mkbook: cannot write %s\n", headerPath);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -8,6 +8,11 @@
  *
  *	Runs every book.epd position at the four shipped budgets and prints
  *	probe stats plus nodes and completed-depth sums.
+ *
+ *	movecache-bank puts the table behind plat_Bank*, in tests/platStub.c's
+ *	simulated banks, and adds what that cost in bank switches.  Its nodes
+ *	and depths must match the same size built without banks to the digit.
+ *	movecache-heap is the same check for a table from plat_HeapAlloc.
  */
 
 #include <stdio.h>
@@ -16,6 +21,7 @@
 #include "engine.h"
 #include "search.h"
 #include "eval.h"
+#include "plat.h"
 #include "testutil.h"
 
 #ifndef SEARCH_MOVE_CACHE
@@ -69,6 +75,11 @@ int main(int argc, char **argv)
 
 	printf("F4 move cache: %d entries, %d positions\n",
 	       SEARCH_MOVE_CACHE, st_nbook);
+#if PLAT_HEAP
+	printf("from plat_HeapAlloc\n");
+#elif PLAT_BANKS
+	printf("in %d banks of %u bytes\n", PLAT_BANKS, PLAT_BANK_WINDOW);
+#endif
 	printf("level     nodes   depth  probes   occup    lock   found  useful\n");
 
 	search_MoveCacheReset();
@@ -98,5 +109,16 @@ int main(int argc, char **argv)
 	search_MoveCacheStats(&probes, &occupied, &locks, &found, &useful);
 	printf("all   %7lu %7lu %7lu %7lu %7lu  (cumulative)\n",
 	       probes, occupied, locks, found, useful);
+#if PLAT_BANKS
+	{
+		unsigned long selects, switches, bytes;
+
+		// the clears at the start of every search are in here too
+		test_BankStats(&selects, &switches, &bytes);
+		printf("banks: %lu selects, %lu switches, %lu bytes through the window"
+		       " (%.3f switches a probe)\n", selects, switches, bytes,
+		       probes ? (double)switches / probes : 0.0);
+	}
+#endif
 	return 0;
 }
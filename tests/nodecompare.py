@@ -4,9 +4,13 @@
 This is the cheap pre-gate for search changes.  Both engines search every
 position in book.epd at the shipped budgets; the report says whether a change
 buys enough nodes and completed depth to be detectable by the match gauntlet.
+
+The positions go through the adapter's "analyse" extension, one command a
+level, so the run costs the searches and not a round trip a position.
 """
 
 import argparse
+import os
 import re
 import subprocess
 import sys
@@ -15,8 +19,8 @@ from pathlib import Path
 
 
 TESTS = Path(__file__).resolve().parent
-INFO_RE = re.compile(
-	r"^info depth (\d+) score (cp|mate) (-?\d+) nodes (\d+) pv (\S+)"
+EPD_RE = re.compile(
+	r" bm (\S+); ce (-?\d+);(?: dm (-?\d+);)? acd (\d+); acn (\d+);"
 )
 
 
@@ -44,16 +48,15 @@ def option_commands(options):
 	return commands
 
 
-def run_engine(path, options, levels, fens):
+def run_engine(path, options, levels, book, positions, jobs):
 	commands = ["uci"] + option_commands(options)
 	for level in levels:
 		commands.append(f"setoption name Skill value {level}")
-		for fen in fens:
-			commands.extend((f"position fen {fen}", "go"))
+		commands.append(f"analyse {book} jobs {jobs}")
 	commands.append("quit")
 
 	completed = subprocess.run(
-		[str(path)], input="\n".join(commands) + "\n", text=True,
+		[str(path.resolve())], input="\n".join(commands) + "\n", text=True,
 		capture_output=True, timeout=300,
 	)
 	if completed.returncode:
@@ -63,25 +66,20 @@ def run_engine(path, options, levels, fens):
 		)
 
 	results = []
-	pending = None
 	for line in completed.stdout.splitlines():
-		match = INFO_RE.match(line)
-		if match:
-			pending = match
-		elif line.startswith("bestmove "):
-			if pending is None:
-				sys.exit(f"{path}: bestmove without preceding info: {line}")
+		match = EPD_RE.search(line)
+		if match and not line.startswith("info "):
+			mate = match.group(3)
 			results.append(Result(
-				depth=int(pending.group(1)),
-				score_kind=pending.group(2),
-				score=int(pending.group(3)),
-				nodes=int(pending.group(4)),
-				pv=pending.group(5),
-				bestmove=line.split()[1],
+				depth=int(match.group(4)),
+				score_kind="mate" if mate else "cp",
+				score=int(mate if mate else match.group(2)),
+				nodes=int(match.group(5)),
+				pv=match.group(1),
+				bestmove=match.group(1),
 			))
-			pending = None
 
-	expected = len(levels) * len(fens)
+	expected = len(levels) * positions
 	if len(results) != expected:
 		sys.exit(f"{path}: parsed {len(results)} searches, expected {expected}")
 	return results
@@ -103,6 +101,8 @@ def main():
 	                    help="require every search result to be identical")
 	parser.add_argument("--report-only", action="store_true",
 	                    help="report without enforcing the threshold")
+	parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+	                    help="analyse workers per engine (default: all cores)")
 	args = parser.parse_args()
 
 	levels = csv_ints(args.levels)
@@ -116,8 +116,11 @@ def main():
 			parser.error(f"not a file: {path}")
 
 	fens = [line.strip() for line in args.book.read_text().splitlines() if line.strip()]
-	baseline = run_engine(args.baseline, args.baseline_option, levels, fens)
-	candidate = run_engine(args.candidate, args.candidate_option, levels, fens)
+	book = args.book.resolve()
+	baseline = run_engine(args.baseline, args.baseline_option, levels, book, len(fens),
+	                      args.jobs)
+	candidate = run_engine(args.candidate, args.candidate_option, levels, book, len(fens),
+	                       args.jobs)
 
 	print(f"{len(fens)} positions at each shipped budget")
 	print("level   baseline  candidate   saving   depth b/c   deeper  shallower  moves  gate")
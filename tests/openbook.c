@@ -0,0 +1,230 @@
+/*
+ *	openbook.c
+ *	cc65 Chess - test support
+ *
+ *	The opening book, both halves.  src/book.c is what a port with BOOK_ON
+ *	plays from, so it is checked the way tests/opening.c checks the tables:
+ *	every move it offers is legal, the weights reach every entry, and a
+ *	position it does not hold gets no answer.  The host file format is checked
+ *	by writing a book, reading it back and finding the same moves in it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "search.h"
+#include "book.h"
+#include "polybook.h"
+#include "testutil.h"
+
+static int si_failures;
+
+/*-----------------------------------------------------------------------*/
+static void check(const char *what, long got, long want)
+{
+	if(got != want)
+	{
+		printf("    %-52s got %ld, wanted %ld\n", what, got, want);
+		++si_failures;
+	}
+}
+
+#if BOOK_ON
+/*-----------------------------------------------------------------------*/
+// Ask the book a few hundred times and record which of its moves came up.
+// Returns how many different ones did
+static int probeSpread(const char *fen, char *seen, int maxSeen)
+{
+	char side = test_EngineSetFEN(fen), seed;
+	int kinds = 0, i;
+
+	memset(seen, 0, maxSeen);
+	for(seed = 1; seed; ++seed)
+	{
+		t_engMove move;
+
+		search_SetSeed(seed);
+		if(!book_Probe(side, &move))
+			continue;
+
+		for(i = 0; i < (int)gcBookEntries; ++i)
+		{
+			if(gcBook[i].m_key == book_Key(side) &&
+			   ENG_FROM_TILE(gcBook[i].m_from) == move.m_from &&
+			   ENG_FROM_TILE(gcBook[i].m_to & BOOK_TILE_MASK) == move.m_to)
+			{
+				if(i < maxSeen && !seen[i])
+				{
+					seen[i] = 1;
+					++kinds;
+				}
+				break;
+			}
+		}
+		if(i == (int)gcBookEntries)
+			check("book move is one of the position's entries", 0, 1);
+	}
+	search_SetSeed(0);
+	return kinds;
+}
+
+/*-----------------------------------------------------------------------*/
+static void checkTargetBook(void)
+{
+	static char seen[1024];
+	unsigned int i;
+	t_engMove move;
+
+	for(i = 1; i < gcBookEntries; ++i)
+		if(gcBook[i].m_key < gcBook[i - 1].m_key)
+		{
+			check("bookdata.h is sorted by key", i, 0);
+			break;
+		}
+
+	// the seed book is the two cpu.c tables, so their move counts
+	check("start position offers all four first moves",
+	      probeSpread("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	                  seen, sizeof(seen)), 4);
+	check("1.f4 offers both replies",
+	      probeSpread("rnbqkbnr/pppppppp/8/8/5P2/8/PPPPP1PP/RNBQKBNR b KQkq f3 0 1",
+	                  seen, sizeof(seen)), 2);
+
+	// same placement, other side to move: not the same position
+	test_EngineSetFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1");
+	search_SetSeed(1);
+	check("start position with black to move is not in the book",
+	      book_Probe(SIDE_BLACK, &move), 0);
+
+	test_EngineSetFEN("r1bqkb1r/pp3ppp/2np1n2/4p3/2B1P3/2N2N2/PPP2PPP/R1BQK2R w KQkq - 0 7");
+	check("a middlegame is not in the book", book_Probe(SIDE_WHITE, &move), 0);
+	search_SetSeed(0);
+
+	printf("  target book: %u entries, %s\n", gcBookEntries,
+	       si_failures ? "FAILED" : "ok");
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+static void checkHostBook(void)
+{
+	static const char *name = "openbook-test.bin";
+	t_polyEntry entries[4];
+	const t_polyEntry *found;
+	t_engMove move;
+	char side;
+	int before = si_failures;
+
+	// castling and promotion are the two moves Polyglot's encoding is not
+	// just from and to; both have to come back as the engine's own move
+	side = test_EngineSetFEN("r3k2r/1P6/8/8/8/8/8/R3K2R w KQkq - 0 1");
+	test_ParseMove(side, "O-O", &move);
+	entries[0].m_key = polybook_Key(side);
+	entries[0].m_move = polybook_EncodeMove(&move);
+	entries[0].m_weight = 3;
+	entries[0].m_learn = 0;
+	check("white O-O encodes as e1h1", entries[0].m_move, (0 << 9) | (4 << 6) | (0 << 3) | 7);
+
+	test_ParseMove(side, "b8=N", &move);
+	entries[1] = entries[0];
+	entries[1].m_move = polybook_EncodeMove(&move);
+	entries[1].m_weight = 1;
+
+	test_ParseMove(side, "bxa8=Q", &move);
+	entries[2] = entries[0];
+	entries[2].m_move = polybook_EncodeMove(&move);
+	entries[2].m_weight = 7;
+
+	// a different position, to sit between them after the sort
+	side = test_EngineSetFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	test_ParseMove(side, "e4", &move);
+	entries[3].m_key = polybook_Key(side);
+	entries[3].m_move = polybook_EncodeMove(&move);
+	entries[3].m_weight = 1;
+	entries[3].m_learn = 0;
+	check("side to move is in the key", polybook_Key(SIDE_BLACK) != entries[3].m_key, 1);
+
+	check("book written", polybook_Write(name, entries, 4), 1);
+	check("book read back", polybook_Load(name), 4);
+	remove(name);
+
+	side = test_EngineSetFEN("r3k2r/1P6/8/8/8/8/8/R3K2R w KQkq - 0 1");
+	check("entries for the position", polybook_Find(polybook_Key(side), &found), 3);
+	check("heaviest first", found[0].m_weight, 7);
+	check("queen promotion decodes",
+	      polybook_DecodeMove(side, found[0].m_move, &move) &&
+	      (move.m_flags & ENG_MF_PROMO) == QUEEN, 1);
+	check("knight promotion decodes",
+	      polybook_DecodeMove(side, found[2].m_move, &move) &&
+	      (move.m_flags & ENG_MF_PROMO) == KNIGHT, 1);
+	check("castle decodes",
+	      polybook_DecodeMove(side, found[1].m_move, &move) &&
+	      (move.m_flags & ENG_MF_CASTLE_K), 1);
+	polybook_Free();
+
+	// the keys Polyglot's book format description publishes, which pin the
+	// table and the slot order; the last two have an en passant that counts
+	{
+		static const struct { const char *m_fen; uint64_t m_key; } sc_keys[] =
+		{
+			{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463B96181691FC9CULL },
+			{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823C9B50FD114196ULL },
+			{ "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756B94461C50FB0ULL },
+			{ "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662FAFB965DB29D4ULL },
+			{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22A48B5A8E47FF78ULL },
+			{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652A607CA3F242C1ULL },
+			{ "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00FDD303C946BDD9ULL },
+			{ "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3C8123EA7B067637ULL },
+			{ "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5C3F9B829B279560ULL },
+		};
+		int i;
+
+		for(i = 0; i < (int)(sizeof(sc_keys) / sizeof(sc_keys[0])); ++i)
+		{
+			char what[48];
+
+			side = test_EngineSetFEN(sc_keys[i].m_fen);
+			snprintf(what, sizeof(what), "published Polyglot key %d", i + 1);
+			check(what, polybook_Key(side) == sc_keys[i].m_key, 1);
+		}
+	}
+
+	// en passant is in the key only when it can be taken, as in Polyglot
+	test_EngineSetFEN("4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1");
+	{
+		uint64_t withEP = polybook_Key(SIDE_BLACK);
+
+		test_EngineSetFEN("4k3/8/8/8/4P3/8/8/4K3 b - - 0 1");
+		check("untakeable en passant leaves the key alone",
+		      withEP == polybook_Key(SIDE_BLACK), 1);
+	}
+	test_EngineSetFEN("4k3/8/8/8/3pP3/8/8/4K3 b - e3 0 1");
+	{
+		uint64_t withEP = polybook_Key(SIDE_BLACK);
+
+		test_EngineSetFEN("4k3/8/8/8/3pP3/8/8/4K3 b - - 0 1");
+		check("takeable en passant changes the key",
+		      withEP != polybook_Key(SIDE_BLACK), 1);
+	}
+
+	printf("  host book file: %s\n", si_failures == before ? "ok" : "FAILED");
+}
+
+/*-----------------------------------------------------------------------*/
+int test_RunBook(int verbose)
+{
+	(void)verbose;
+	si_failures = 0;
+	printf("opening book\n");
+
+#if BOOK_ON
+	checkTargetBook();
+#else
+	printf("  target book: compiled out (BOOK_ON=0)\n");
+#endif
+	checkHostBook();
+
+	return si_failures;
+}
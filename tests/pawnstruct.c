@@ -4,7 +4,8 @@
  *
  *	Purpose-built checks for the doubled/isolated term.  The score is rebuilt
  *	from the board at eval time, so these name positions and expected scores
- *	rather than file-count deltas.
+ *	rather than file-count deltas.  With the pawn hash compiled in, the
+ *	cached score is checked against the walk it stands in for.
  */
 
 #include <stdio.h>
@@ -67,6 +68,120 @@ static int checkLiveSwitch(void)
 	return 0;
 }
 
+#if EVAL_PAWN_HASH
+static const char *stc_pawnFens[] =
+{
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r1bqkb1r/pp3ppp/2np1n2/4p3/2B1P3/2N2N2/PPP2PPP/R1BQK2R w KQkq - 0 7",
+	"4k3/p7/p7/8/8/8/PP6/4K3 w - - 0 1",
+	"8/5pk1/6p1/3P4/1p6/1P4P1/5PK1/8 w - - 0 40",
+	"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+#define NUM_PAWN_FENS	((int)(sizeof(stc_pawnFens) / sizeof(stc_pawnFens[0])))
+
+/*-----------------------------------------------------------------------*/
+// The cached score has to be the walk's score.  A miss is the walk, so an
+// emptied table gives the reference; then a search fills the table, and every
+// skeleton it left behind must still answer the same when probed again
+static int checkPawnHash(int verbose)
+{
+	unsigned long probes, hits;
+	t_searchResult result;
+	int i, failures = 0;
+
+	for(i = 0; i < NUM_PAWN_FENS; ++i)
+	{
+		int walked, cached;
+		unsigned long full[2];
+		char side = test_EngineSetFEN(stc_pawnFens[i]);
+
+		eval_PawnHashReset();
+		eval_Position(SIDE_WHITE);
+		walked = gePawnStruct;
+
+		search_Best(side, 3, 2000, &result);
+		eng_PawnKeyOfBoard(full);
+		if(gePawnKey[SIDE_WHITE] != full[SIDE_WHITE] ||
+		   gePawnKey[SIDE_BLACK] != full[SIDE_BLACK])
+		{
+			printf("  pawn hash                  FAIL key after search %06lX/%06lX board %06lX/%06lX\n",
+			       gePawnKey[SIDE_WHITE], gePawnKey[SIDE_BLACK],
+			       full[SIDE_WHITE], full[SIDE_BLACK]);
+			++failures;
+		}
+
+		eval_Position(SIDE_WHITE);
+		cached = gePawnStruct;
+		eval_PawnHashStats(&probes, &hits);
+		if(cached != walked || !hits)
+		{
+			printf("  pawn hash                  FAIL position %d cached %d walked %d hits %lu\n",
+			       i, cached, walked, hits);
+			++failures;
+		}
+		else if(verbose)
+			printf("    position %d: %lu probes, %lu hits\n", i, probes, hits);
+	}
+
+	if(!failures)
+	{
+		char label[32];
+
+		sprintf(label, "pawn hash, %d entries", EVAL_PAWN_HASH);
+		printf("  %-27sok\n", label);
+	}
+	return failures;
+}
+
+/*-----------------------------------------------------------------------*/
+// The table may only make the score cheaper, never different, so the same
+// searches have to visit the same nodes with it and with the walk at every
+// evaluation.  Once a 16-bit lock let a few thousand skeletons in 7M probes
+// answer for each other, which moved selfplay by two nodes a move and passed
+// the check above
+static unsigned long searchPawnNodes(char useHash)
+{
+	unsigned int seed = search_SeedState();
+	unsigned long nodes = 0;
+	int i;
+
+	eval_PawnHashReset();
+	eval_PawnHashUse(useHash);
+	search_SetSeed(0);
+	for(i = 0; i < NUM_PAWN_FENS; ++i)
+	{
+		t_searchResult result;
+		char side = test_EngineSetFEN(stc_pawnFens[i]);
+
+		search_Best(side, 5, 65535U, &result);
+		nodes += result.m_nodes;
+	}
+	eval_PawnHashUse(1);
+	search_RestoreSeed(seed);
+	return nodes;
+}
+
+/*-----------------------------------------------------------------------*/
+static int checkPawnHashNodes(int verbose)
+{
+	unsigned long walked = searchPawnNodes(0);
+	unsigned long cached = searchPawnNodes(1);
+
+	if(walked != cached)
+	{
+		printf("  pawn hash nodes            FAIL %lu with the table, %lu without\n",
+		       cached, walked);
+		return 1;
+	}
+	if(verbose)
+		printf("    %lu nodes either way\n", walked);
+	printf("  pawn hash nodes            ok\n");
+	return 0;
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 int test_RunPawnStruct(int verbose)
 {
@@ -145,6 +260,10 @@ int test_RunPawnStruct(int verbose)
 		printf("  capture of enemy pawn      ok\n");
 
 	failures += checkLiveSwitch();
+#if EVAL_PAWN_HASH
+	failures += checkPawnHash(verbose);
+	failures += checkPawnHashNodes(verbose);
+#endif
 
 	printf("  %s\n", failures ? "FAILED" : "ok");
 	return failures;
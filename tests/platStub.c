@@ -5,9 +5,21 @@
  *	A do-nothing implementation of plat.h so the game logic can be linked and
  *	driven natively.  plat_AddToLogWin deliberately walks the undo stack the
  *	way the real ports do, because that call has the side effect of changing
- *	gTile/gPiece/gColor/gMove and the engine has to survive it
+ *	gTile/gPiece/gColor/gMove and the engine has to survive it.
+ *
+ *	With PLAT_BANKS set it also stands in for a machine's extra memory: the
+ *	banks are plain arrays, the window is whichever one was selected last,
+ *	and every select, real switch and byte moved is counted, so what a table
+ *	behind plat_Bank* costs in switches is known before it meets a real bank
+ *	register.  Going outside the window is a stop, not a wrap.  PLAT_HEAP is
+ *	calloc.  plat_DrawSquare, and plat_DrawSquares with PLAT_DRAW_SQUARES,
+ *	only note which tiles were drawn, and plat_ReadKeys only ever returns a
+ *	key a test queued
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "types.h"
 #include "globals.h"
 #include "undo.h"
@@ -17,13 +29,36 @@
 void plat_Init(void) {}
 void plat_UpdateScreen(void) {}
 void plat_DrawBoard(char clearLog) { (void)clearLog; }
-void plat_DrawSquare(char position) { (void)position; }
 void plat_ShowSideToGoLabel(char side) { (void)side; }
 void plat_Highlight(char position, char color, char cursor) { (void)position; (void)color; (void)cursor; }
 void plat_ShowMessage(char *str, char color) { (void)str; (void)color; }
 void plat_ClearMessage(void) {}
 void plat_Shutdown(void) {}
-int  plat_ReadKeys(char blocking) { (void)blocking; return 0; }
+
+/*-----------------------------------------------------------------------*/
+// Nobody is at the keys, unless a test has queued one with test_QueueKey.
+// Then that key is what the poll it named sees, and every other poll 0
+static int				si_key;
+static unsigned long	sl_keyPolls;
+
+int plat_ReadKeys(char blocking)
+{
+	int key;
+
+	(void)blocking;
+	if(!si_key || --sl_keyPolls)
+		return 0;
+
+	key = si_key;
+	si_key = 0;
+	return key;
+}
+
+void test_QueueKey(int keyMask, unsigned long polls)
+{
+	si_key = keyMask;
+	sl_keyPolls = polls;
+}
 
 /*-----------------------------------------------------------------------*/
 // Always picks the first item, which makes frontend_GetPromotion return a
@@ -49,3 +84,92 @@ void plat_AddToLogWinTop(void)
 {
 	plat_AddToLogWin();
 }
+
+#if PLAT_HEAP
+/*-----------------------------------------------------------------------*/
+void *plat_HeapAlloc(unsigned long size)
+{
+	return calloc(1, size);
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+// The tiles drawn one at a time or as a batch since test_TakeDrawn last
+// asked, so the fuzzer can hold board_DrawChanged to what actually changed
+static char sc_drawn[8];
+
+void plat_DrawSquare(char position)
+{
+	sc_drawn[(unsigned char)position >> 3] |= 1 << (position & 7);
+}
+
+#if PLAT_DRAW_SQUARES
+void plat_DrawSquares(const char *changed)
+{
+	char row;
+
+	for(row = 0; row < 8; ++row)
+		sc_drawn[row] |= changed[row];
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+void test_TakeDrawn(char *drawn)
+{
+	memcpy(drawn, sc_drawn, sizeof(sc_drawn));
+	memset(sc_drawn, 0, sizeof(sc_drawn));
+}
+
+#if PLAT_BANKS
+static unsigned char	sb_bank[PLAT_BANKS][PLAT_BANK_WINDOW];
+static char				sc_bank;
+static unsigned long	sl_bankSelects, sl_bankSwitches, sl_bankBytes;
+
+/*-----------------------------------------------------------------------*/
+void plat_BankSelect(char bank)
+{
+	if((unsigned char)bank >= PLAT_BANKS)
+	{
+		fprintf(stderr, "plat_BankSelect: bank %d of %d\n", bank, PLAT_BANKS);
+		abort();
+	}
+	++sl_bankSelects;
+	if(bank != sc_bank)
+		++sl_bankSwitches;
+	sc_bank = bank;
+}
+
+/*-----------------------------------------------------------------------*/
+static unsigned char *bankWindow(unsigned int offset, char size)
+{
+	if(offset + (unsigned char)size > PLAT_BANK_WINDOW)
+	{
+		fprintf(stderr, "plat_Bank: %u bytes at %u, window %u\n",
+		        (unsigned char)size, offset, PLAT_BANK_WINDOW);
+		abort();
+	}
+	sl_bankBytes += (unsigned char)size;
+	return &sb_bank[(unsigned char)sc_bank][offset];
+}
+
+/*-----------------------------------------------------------------------*/
+void plat_BankRead(unsigned int offset, void *dst, char size)
+{
+	memcpy(dst, bankWindow(offset, size), (unsigned char)size);
+}
+
+/*-----------------------------------------------------------------------*/
+void plat_BankWrite(unsigned int offset, const void *src, char size)
+{
+	memcpy(bankWindow(offset, size), src, (unsigned char)size);
+}
+
+/*-----------------------------------------------------------------------*/
+void test_BankStats(unsigned long *selects, unsigned long *switches,
+                    unsigned long *bytes)
+{
+	*selects = sl_bankSelects;
+	*switches = sl_bankSwitches;
+	*bytes = sl_bankBytes;
+}
+#endif
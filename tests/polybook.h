@@ -0,0 +1,58 @@
+/*
+ *	polybook.h
+ *	cc65 Chess - test support
+ *
+ *	The host side of the opening book: a file in Polyglot's layout - sixteen
+ *	byte big-endian records of key, move, weight and learn, sorted by key - so
+ *	the usual book tools can list, merge and weigh it.  The key is a 64 bit
+ *	Zobrist over Polyglot's 781 slots, in Polyglot's order, with Polyglot's
+ *	rule that an en passant file only counts when a pawn can take there.
+ *
+ *	The random table is Polyglot's published Random64, so a book written
+ *	here opens in other tools and a third-party book can be read by uci's
+ *	BookFile option.
+ *
+ *	The 8-bit ports never see any of this.  tests/mkbook writes the same lines
+ *	into src/bookdata.h with 16 bit keys for src/book.c - see book.h.
+ */
+
+#ifndef _POLYBOOK_H_
+#define _POLYBOOK_H_
+
+#include <stdint.h>
+#include "engine.h"
+
+typedef struct tag_polyEntry
+{
+	uint64_t	m_key;
+	uint16_t	m_move;
+	uint16_t	m_weight;
+	uint32_t	m_learn;
+} t_polyEntry;
+
+/*-----------------------------------------------------------------------*/
+// Key of the position on the board with "side" to move
+uint64_t polybook_Key(char side);
+
+// Polyglot's move word: to, from, promotion, and castling as king-takes-rook
+uint16_t polybook_EncodeMove(const t_engMove *move);
+// And back, through the legal list.  Returns 0 if no legal move matches
+char polybook_DecodeMove(char side, uint16_t word, t_engMove *move);
+
+/*-----------------------------------------------------------------------*/
+// Sort by key then weight, highest first, and write.  Returns 0 on failure
+int polybook_Write(const char *path, t_polyEntry *entries, long count);
+
+// Read a whole book into memory, replacing any loaded before.  Returns the
+// entry count, or -1 if the file could not be read
+long polybook_Load(const char *path);
+void polybook_Free(void);
+
+// The loaded entries for "key", as a pointer into the book and a count
+long polybook_Find(uint64_t key, const t_polyEntry **first);
+
+// A weighted pick for the position on the board, "roll" being any random
+// number.  Returns 0 when the position is not in the book
+char polybook_Pick(char side, unsigned long roll, t_engMove *move);
+
+#endif //_POLYBOOK_H_
@@ -0,0 +1,187 @@
+/*
+ *	posconv.c
+ *	cc65 Chess - test support
+ *
+ *	collectpos TSV to posfile.h binary, or binary back to TSV so a data set
+ *	can be read, grepped and diffed.  Which way is decided by the input: a
+ *	file with the posfile header goes to TSV, anything else is read as TSV.
+ *
+ *	  ./posconv train.tsv train.bin
+ *	  ./posconv train.bin - | head
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "posfile.h"
+#include "testutil.h"
+
+#define MAX_COLUMNS		16
+
+/*-----------------------------------------------------------------------*/
+static int toTSV(const char *inPath, FILE *out)
+{
+	const unsigned char *records;
+	size_t mapped;
+	long count, i;
+
+	records = posfile_Map(inPath, &count, &mapped);
+	if(!records)
+	{
+		fprintf(stderr, "posconv: cannot map %s\n", inPath);
+		return 1;
+	}
+
+	fprintf(out, "opening\tskill_nodes\tply\tstm\tresult\teval\tfen\n");
+	for(i = 0; i < count; ++i)
+	{
+		const unsigned char *record = records + i * POSFILE_RECORD;
+		char fen[96], side = posfile_Unpack(record);
+		float result = posfile_Result(record);
+
+		test_EngineGetFEN(side, fen);
+		fprintf(out, "%u\t%u\t%u\t%c\t%s\t%d\t%s\n",
+		        record[40] | (record[41] << 8), record[42] | (record[43] << 8), record[37],
+		        side == SIDE_WHITE ? 'w' : 'b',
+		        1.0f == result ? "1" : 0.0f == result ? "0" : "0.5",
+		        posfile_Eval(record), fen);
+	}
+
+	posfile_Unmap(records, mapped);
+	fprintf(stderr, "posconv: %ld records\n", count);
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// Split a line on tabs in place
+static int splitTabs(char *line, char **columns)
+{
+	int n = 0;
+
+	while(n < MAX_COLUMNS)
+	{
+		char *tab = strchr(line, '\t');
+
+		columns[n++] = line;
+		if(!tab)
+			break;
+		*tab = '\0';
+		line = tab + 1;
+	}
+	return n;
+}
+
+/*-----------------------------------------------------------------------*/
+static int findColumn(char **names, int count, const char *name)
+{
+	int i;
+
+	for(i = 0; i < count; ++i)
+		if(!strcmp(names[i], name))
+			return i;
+	return -1;
+}
+
+/*-----------------------------------------------------------------------*/
+static int toBinary(const char *inPath, FILE *out)
+{
+	FILE *in = fopen(inPath, "r");
+	static char line[512], header[512];
+	char *names[MAX_COLUMNS], *columns[MAX_COLUMNS];
+	int nNames = 0, opening = -1, nodes = -1, ply = -1, result = -1, eval = -1, fen = -1;
+	long count = 0;
+
+	if(!in)
+	{
+		fprintf(stderr, "posconv: cannot open %s\n", inPath);
+		return 1;
+	}
+	if(!posfile_WriteHeader(out))
+	{
+		fclose(in);
+		return 1;
+	}
+
+	while(fgets(line, sizeof(line), in))
+	{
+		unsigned char record[POSFILE_RECORD];
+		char *nl = strpbrk(line, "\r\n"), side, outcome;
+		int n;
+
+		if(nl)
+			*nl = '\0';
+		if(!line[0] || line[0] == '#')
+			continue;
+
+		if(!nNames)
+		{
+			strcpy(header, line);
+			nNames = splitTabs(header, names);
+			opening = findColumn(names, nNames, "opening");
+			nodes = findColumn(names, nNames, "skill_nodes");
+			ply = findColumn(names, nNames, "ply");
+			result = findColumn(names, nNames, "result");
+			eval = findColumn(names, nNames, "eval");
+			fen = findColumn(names, nNames, "fen");
+			if(result < 0 || eval < 0 || fen < 0)
+			{
+				fprintf(stderr, "posconv: %s has no result, eval and fen columns\n", inPath);
+				fclose(in);
+				return 1;
+			}
+			continue;
+		}
+
+		n = splitTabs(line, columns);
+		if(fen >= n || result >= n || eval >= n)
+			continue;
+
+		side = test_EngineSetFEN(columns[fen]);
+		geHalfmove = test_FENHalfmove(columns[fen]);
+		outcome = !strcmp(columns[result], "1") ? 2 : !strcmp(columns[result], "0") ? 0 : 1;
+		posfile_Pack(side, outcome, atoi(columns[eval]),
+		             (ply >= 0 && ply < n) ? atoi(columns[ply]) : 0,
+		             (opening >= 0 && opening < n) ? atoi(columns[opening]) : 0,
+		             (nodes >= 0 && nodes < n) ? (unsigned int)atoi(columns[nodes]) : 0,
+		             record);
+		if(!posfile_Append(out, record))
+		{
+			fclose(in);
+			return 1;
+		}
+		++count;
+	}
+
+	fclose(in);
+	fprintf(stderr, "posconv: %ld records\n", count);
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	int binaryIn, failed;
+	FILE *out;
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: posconv IN OUT    (OUT may be - for stdout)\n");
+		return 2;
+	}
+
+	binaryIn = posfile_IsPosFile(argv[1]);
+	out = strcmp(argv[2], "-") ? fopen(argv[2], binaryIn ? "w" : "wb") : stdout;
+	if(!out)
+	{
+		fprintf(stderr, "posconv: cannot write %s\n", argv[2]);
+		return 1;
+	}
+
+	failed = binaryIn ? toTSV(argv[1], out) : toBinary(argv[1], out);
+	if(out != stdout && fclose(out))
+		failed = 1;
+	return failed;
+}
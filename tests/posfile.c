@@ -0,0 +1,223 @@
+/*
+ *	posfile.c
+ *	cc65 Chess - test support
+ *
+ *	See posfile.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "eval.h"
+#include "posfile.h"
+
+static const unsigned char sc_magic[8] = { 'C', 'C', '6', '5', 'P', 'O', 'S', 1 };
+
+/*-----------------------------------------------------------------------*/
+static void putLE(unsigned char *out, unsigned int value, int bytes)
+{
+	while(bytes--)
+	{
+		*out++ = (unsigned char)value;
+		value >>= 8;
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+static unsigned int getLE(const unsigned char *in, int bytes)
+{
+	unsigned int value = 0;
+
+	while(bytes--)
+		value = (value << 8) | in[bytes];
+	return value;
+}
+
+/*-----------------------------------------------------------------------*/
+void posfile_Pack(char side, char result, int eval, int ply, int opening,
+                  unsigned int nodes, unsigned char *record)
+{
+	char tile;
+
+	memset(record, 0, POSFILE_RECORD);
+	for(tile = 0; tile < 64; ++tile)
+	{
+		char piece = geBoard[ENG_FROM_TILE(tile)];
+		unsigned char nibble = (unsigned char)(piece & PIECE_DATA);
+
+		if(nibble && (piece & PIECE_WHITE))
+			nibble |= 8;
+		record[tile >> 1] |= (tile & 1) ? (unsigned char)(nibble << 4) : nibble;
+	}
+
+	record[32] = (unsigned char)(SIDE_WHITE == side);
+	record[33] = (unsigned char)geCastle;
+	record[34] = (unsigned char)(ENG_NO_SQUARE == geEP ? POSFILE_NO_EP : ENG_TO_TILE(geEP));
+	record[35] = (unsigned char)result;
+	record[36] = (unsigned char)geHalfmove;
+	record[37] = (unsigned char)(ply > 255 ? 255 : ply);
+	putLE(record + 38, (unsigned int)eval, 2);
+	putLE(record + 40, (unsigned int)opening, 2);
+	putLE(record + 42, nodes > 65535u ? 65535u : nodes, 2);
+}
+
+/*-----------------------------------------------------------------------*/
+char posfile_Unpack(const unsigned char *record)
+{
+	char tile;
+
+	eng_Clear();
+	for(tile = 0; tile < 64; ++tile)
+	{
+		unsigned char nibble = (tile & 1) ? record[tile >> 1] >> 4 : record[tile >> 1] & 15;
+		char kind = nibble & 7, sq = ENG_FROM_TILE(tile);
+
+		if(!kind)
+			continue;
+		geBoard[sq] = kind | ((nibble & 8) ? PIECE_WHITE : 0);
+		if(KING == kind)
+			geKing[(nibble & 8) ? SIDE_WHITE : SIDE_BLACK] = sq;
+	}
+
+	geCastle = (char)record[33];
+	geEP = (POSFILE_NO_EP == record[34]) ? ENG_NO_SQUARE : ENG_FROM_TILE(record[34]);
+	geHalfmove = (char)record[36];
+
+	// straight onto the board, as from a FEN, so the same two rebuilds
+	eval_Refresh();
+	eng_HashReset();
+
+	return record[32] ? SIDE_WHITE : SIDE_BLACK;
+}
+
+/*-----------------------------------------------------------------------*/
+void posfile_SetResult(unsigned char *record, char result)
+{
+	record[35] = (unsigned char)result;
+}
+
+/*-----------------------------------------------------------------------*/
+float posfile_Result(const unsigned char *record)
+{
+	return record[35] * 0.5f;
+}
+
+/*-----------------------------------------------------------------------*/
+int posfile_Eval(const unsigned char *record)
+{
+	return (short)getLE(record + 38, 2);
+}
+
+/*-----------------------------------------------------------------------*/
+void posfile_SetScore(unsigned char *record, int score)
+{
+	if(score > 32767)
+		score = 32767;
+	else if(score < -32767)
+		score = -32767;
+	putLE(record + 44, (unsigned int)score, 2);
+}
+
+/*-----------------------------------------------------------------------*/
+int posfile_Score(const unsigned char *record)
+{
+	return (short)getLE(record + 44, 2);
+}
+
+/*-----------------------------------------------------------------------*/
+unsigned long long posfile_Key(const unsigned char *record)
+{
+	unsigned long long key = 14695981039346656037ULL;
+	int i;
+
+	// bytes 0 .. 34 are the position; 35 on are what was said about it
+	for(i = 0; i < 35; ++i)
+	{
+		key ^= record[i];
+		key *= 1099511628211ULL;
+	}
+	return key ? key : 1;
+}
+
+/*-----------------------------------------------------------------------*/
+int posfile_WriteHeader(FILE *file)
+{
+	unsigned char header[POSFILE_HEADER];
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, sc_magic, sizeof(sc_magic));
+	putLE(header + 8, POSFILE_RECORD, 4);
+	return 1 == fwrite(header, sizeof(header), 1, file);
+}
+
+/*-----------------------------------------------------------------------*/
+int posfile_Append(FILE *file, const unsigned char *record)
+{
+	return 1 == fwrite(record, POSFILE_RECORD, 1, file);
+}
+
+/*-----------------------------------------------------------------------*/
+static int headerOk(const unsigned char *header)
+{
+	return !memcmp(header, sc_magic, sizeof(sc_magic)) &&
+	       POSFILE_RECORD == getLE(header + 8, 4);
+}
+
+/*-----------------------------------------------------------------------*/
+int posfile_IsPosFile(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	unsigned char header[POSFILE_HEADER];
+	int ok;
+
+	if(!file)
+		return 0;
+	ok = 1 == fread(header, sizeof(header), 1, file) && headerOk(header);
+	fclose(file);
+	return ok;
+}
+
+/*-----------------------------------------------------------------------*/
+const unsigned char *posfile_Map(const char *path, long *count, size_t *mapped)
+{
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	const unsigned char *map;
+
+	*count = 0;
+	*mapped = 0;
+	if(fd < 0)
+		return 0;
+	if(fstat(fd, &info) < 0 || info.st_size < POSFILE_HEADER)
+	{
+		close(fd);
+		return 0;
+	}
+
+	map = (const unsigned char *)mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(MAP_FAILED == (void *)map)
+		return 0;
+	if(!headerOk(map))
+	{
+		munmap((void *)map, (size_t)info.st_size);
+		return 0;
+	}
+
+	*mapped = (size_t)info.st_size;
+	*count = (long)((info.st_size - POSFILE_HEADER) / POSFILE_RECORD);
+	return map + POSFILE_HEADER;
+}
+
+/*-----------------------------------------------------------------------*/
+void posfile_Unmap(const unsigned char *records, size_t mapped)
+{
+	if(records && mapped)
+		munmap((void *)(records - POSFILE_HEADER), mapped);
+}
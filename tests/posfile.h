@@ -0,0 +1,81 @@
+/*
+ *	posfile.h
+ *	cc65 Chess - test support
+ *
+ *	Training positions as fixed-size binary records, so a data set is mapped
+ *	and indexed instead of parsed.  A file is a 16 byte header and then
+ *	records, nothing else; the count is the file size.
+ *
+ *	Header:
+ *	   0  8  "CC65POS" and a version byte, 1
+ *	   8  4  record size, 48, little-endian
+ *	  12  4  0
+ *
+ *	Record, 48 bytes, every multi-byte field little-endian:
+ *	   0 32  board, two squares a byte, a8 first, even square in the low
+ *	         nibble.  A nibble is the engine's piece kind (types.h: rook 1
+ *	         .. pawn 6), plus 8 for white; 0 is empty
+ *	  32  1  side to move, 1 = white
+ *	  33  1  castling rights, the ENG_CASTLE_* bits
+ *	  34  1  en passant target as a tile (a8 = 0), or 255
+ *	  35  1  result, white's point of view: 0 = 0-1, 1 = draw, 2 = 1-0
+ *	  36  1  halfmove clock
+ *	  37  1  ply of the game the position came from (saturates at 255)
+ *	  38  2  eval_Position(white) when it was written, signed
+ *	  40  2  opening index
+ *	  42  2  node budget the game was played at (saturates at 65535)
+ *	  44  2  the search's score for the position, white's view, signed; 0
+ *	         from a writer that did not search it (collectpos, posconv)
+ *	  46  2  0
+ *
+ *	tests/posfile.py reads the same layout through numpy.memmap.
+ */
+
+#ifndef _POSFILE_H_
+#define _POSFILE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define POSFILE_HEADER		16
+#define POSFILE_RECORD		48
+#define POSFILE_NO_EP		255
+
+/*-----------------------------------------------------------------------*/
+// The position on the board as a record
+void posfile_Pack(char side, char result, int eval, int ply, int opening,
+                  unsigned int nodes, unsigned char *record);
+
+// And back onto the board, with the evaluation and history rebuilt the way
+// test_EngineSetFEN does.  Returns the side to move
+char posfile_Unpack(const unsigned char *record);
+
+// For a writer that only learns the result once the game is over
+void posfile_SetResult(unsigned char *record, char result);
+
+// White's score, 1 / 0.5 / 0, and the stored evaluation
+float posfile_Result(const unsigned char *record);
+int posfile_Eval(const unsigned char *record);
+
+// The search score, white-positive, clamped to what 16 bits hold
+void posfile_SetScore(unsigned char *record, int score);
+int posfile_Score(const unsigned char *record);
+
+// 64 bits of FNV-1a over the position - board, side, castling, ep - and none
+// of the labels, for telling repeats apart.  Never 0
+unsigned long long posfile_Key(const unsigned char *record);
+
+/*-----------------------------------------------------------------------*/
+// Streaming: the header once, then a record at a time.  Return 0 on failure
+int posfile_WriteHeader(FILE *file);
+int posfile_Append(FILE *file, const unsigned char *record);
+
+// 1 if the file starts with the header
+int posfile_IsPosFile(const char *path);
+
+// The whole file mapped read-only.  Returns the first record, or 0 if the
+// file is not a position file, and the record count through *count
+const unsigned char *posfile_Map(const char *path, long *count, size_t *mapped);
+void posfile_Unmap(const unsigned char *records, size_t mapped);
+
+#endif //_POSFILE_H_
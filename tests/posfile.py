@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+posfile.h records through numpy.memmap: the whole file is an array the
+moment it is opened, and nothing is parsed until a field is read.
+
+  import posfile
+  pos = posfile.load("train.bin")
+  pos["eval"].mean(), (pos["result"] == 2).sum()
+  posfile.fen(pos[0])
+
+  ./posfile.py train.bin          counts, and the first few as FEN
+"""
+
+from __future__ import annotations
+
+import sys
+
+import numpy as np
+
+HEADER = 16
+MAGIC = b"CC65POS\x01"
+
+# The layout in posfile.h, field for field
+RECORD = np.dtype([
+    ("board", "u1", 32),    # two squares a byte, a8 first, low nibble even
+    ("stm", "u1"),          # 1 = white
+    ("castle", "u1"),       # ENG_CASTLE_* bits: 1 K, 2 Q, 4 k, 8 q
+    ("ep", "u1"),           # tile, a8 = 0, or 255
+    ("result", "u1"),       # 0 = 0-1, 1 = draw, 2 = 1-0
+    ("halfmove", "u1"),
+    ("ply", "u1"),
+    ("eval", "<i2"),        # eval_Position(white) when written
+    ("opening", "<u2"),
+    ("nodes", "<u2"),
+    ("score", "<i2"),       # search score, white's view; 0 if not searched
+    ("pad", "u1", 2),
+])
+assert RECORD.itemsize == 48
+
+# Engine piece kinds, types.h order: none, rook, knight, bishop, queen, king, pawn
+PIECES = " RNBQKP"
+
+
+def load(path: str) -> np.memmap:
+    with open(path, "rb") as fp:
+        head = fp.read(HEADER)
+    if head[:8] != MAGIC or int.from_bytes(head[8:12], "little") != RECORD.itemsize:
+        raise ValueError(f"{path}: not a cc65 position file")
+    return np.memmap(path, dtype=RECORD, mode="r", offset=HEADER)
+
+
+def squares(record) -> list[int]:
+    """The 64 nibbles, a8 first."""
+    out = []
+    for byte in record["board"]:
+        out.append(int(byte) & 15)
+        out.append(int(byte) >> 4)
+    return out
+
+
+def fen(record) -> str:
+    rows = []
+    cells = squares(record)
+    for row in range(8):
+        text, empty = "", 0
+        for nibble in cells[row * 8:row * 8 + 8]:
+            if not nibble & 7:
+                empty += 1
+                continue
+            if empty:
+                text += str(empty)
+                empty = 0
+            letter = PIECES[nibble & 7]
+            text += letter if nibble & 8 else letter.lower()
+        rows.append(text + (str(empty) if empty else ""))
+    castle = "".join(c for bit, c in ((1, "K"), (2, "Q"), (4, "k"), (8, "q"))
+                     if record["castle"] & bit) or "-"
+    ep = record["ep"]
+    ep_text = "-" if ep == 255 else "abcdefgh"[ep & 7] + str(8 - (ep >> 3))
+    side = "w" if record["stm"] else "b"
+    return f"{'/'.join(rows)} {side} {castle} {ep_text} {record['halfmove']} 1"
+
+
+def main() -> int:
+    if len(sys.argv) != 2:
+        print(__doc__.strip())
+        return 2
+    pos = load(sys.argv[1])
+    wins = int((pos["result"] == 2).sum())
+    losses = int((pos["result"] == 0).sum())
+    print(f"{len(pos)} positions  W/L/D {wins}/{losses}/{len(pos) - wins - losses}  "
+          f"openings {len(np.unique(pos['opening']))}")
+    for record in pos[:5]:
+        print(f"  {int(record['eval']):6d}  {fen(record)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
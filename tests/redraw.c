@@ -0,0 +1,146 @@
+/*
+ *	redraw.c
+ *	cc65 Chess - test support
+ *
+ *	board_DrawChanged against tiles worked out by hand.  A move draws the
+ *	squares it touched - two, four for castling, three for en passant - an
+ *	undo or redo the same ones again, and B going on or off every tile.  With
+ *	B on a move also draws the tiles whose counts it changed, and no others.
+ *	The fuzzer holds the same call to the board it mirrors over thousands of
+ *	positions; these are the few where the answer can be written down.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "undo.h"
+#include "board.h"
+#include "testutil.h"
+
+static int si_failures;
+
+/*-----------------------------------------------------------------------*/
+// Draw what changed and compare it with "tiles", a space separated list of
+// square names, or "all"
+static void expectDrawn(const char *what, const char *tiles)
+{
+	char want[8], got[8], tile, name[3];
+
+	memset(want, 0, sizeof(want));
+	if(!strcmp(tiles, "all"))
+		memset(want, 0xFF, sizeof(want));
+	else
+	{
+		for(; *tiles; tiles += tiles[2] ? 3 : 2)
+		{
+			tile = test_Square(tiles);
+			want[tile >> 3] |= 1 << (tile & 7);
+		}
+	}
+
+	board_DrawChanged();
+	test_TakeDrawn(got);
+	if(!memcmp(want, got, sizeof(want)))
+		return;
+
+	printf("    %-40s", what);
+	for(tile = 0; tile < 64; ++tile)
+	{
+		char w = (want[tile >> 3] >> (tile & 7)) & 1;
+		char g = (got[tile >> 3] >> (tile & 7)) & 1;
+
+		if(w == g)
+			continue;
+		test_TileName(tile, name);
+		printf(" %s%s", w ? "-" : "+", name);
+	}
+	printf("  (- not drawn, + drawn unasked)\n");
+	++si_failures;
+}
+
+/*-----------------------------------------------------------------------*/
+// Put up a position the way a new game would be: mirrored, counted if B is
+// on, and drawn whole, so nothing is left over for the first check
+static void position(const char *fen)
+{
+	char drawn[8];
+
+	test_EngineSetFEN(fen);
+	undo_Init();
+	board_SyncDisplay();
+	board_DrawChanged();
+	test_TakeDrawn(drawn);
+}
+
+/*-----------------------------------------------------------------------*/
+static void play(const char *from, const char *to)
+{
+	t_engMove move;
+
+	if(!board_FindMove(test_Square(from), test_Square(to), QUEEN, &move))
+	{
+		printf("    %s-%s not found\n", from, to);
+		++si_failures;
+		return;
+	}
+	board_ApplyMove(&move, (geBoard[move.m_from] & PIECE_WHITE) ? SIDE_WHITE : SIDE_BLACK);
+}
+
+/*-----------------------------------------------------------------------*/
+int test_RunRedraw(int verbose)
+{
+	si_failures = 0;
+	(void)verbose;
+
+	printf("changed tiles (board_DrawChanged)\n");
+
+	board_Init();
+	gShowAttackBoard = 0;
+	position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	expectDrawn("nothing moved", "");
+
+	play("e2", "e4");
+	expectDrawn("e2-e4", "e2 e4");
+	undo_Undo();
+	board_SyncDisplay();
+	expectDrawn("undo e2-e4", "e2 e4");
+	undo_Redo();
+	board_SyncDisplay();
+	expectDrawn("redo e2-e4", "e2 e4");
+
+	position("4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+	play("e1", "g1");
+	expectDrawn("O-O moves the rook too", "e1 f1 g1 h1");
+
+	position("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+	play("e5", "d6");
+	expectDrawn("en passant clears d5", "e5 d6 d5");
+
+	// the toggle changes how every tile looks, whatever the counts are
+	position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	gShowAttackBoard = 1;
+	board_SyncDisplay();
+	expectDrawn("B on", "all");
+	gShowAttackBoard = 0;
+	board_SyncDisplay();
+	expectDrawn("B off", "all");
+
+	// Kings only, B on.  From a1 the king covers a2, b1, b2; from b1 it
+	// covers a1, a2, b2, c1, c2.  a2 and b2 keep a count of 1, so they stay
+	gShowAttackBoard = 1;
+	position("7k/8/8/8/8/8/8/K7 w - - 0 1");
+	expectDrawn("B on, nothing moved", "");
+	play("a1", "b1");
+	expectDrawn("B on, Ka1-b1", "a1 b1 c1 c2");
+	undo_Undo();
+	board_SyncDisplay();
+	expectDrawn("B on, undo Ka1-b1", "a1 b1 c1 c2");
+	gShowAttackBoard = 0;
+	board_SyncDisplay();
+	expectDrawn("B off again", "all");
+
+	printf("  -> %d failing\n", si_failures);
+	return si_failures;
+}
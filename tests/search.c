@@ -19,6 +19,7 @@
 #include "board.h"
 #include "undo.h"
 #include "testutil.h"
+#include "bench.h"
 
 /*-----------------------------------------------------------------------*/
 typedef struct tag_Tactic
@@ -412,6 +413,259 @@ int test_RunSearchAspiration(int verbose)
 	return failures;
 }
 
+#if SEARCH_STATS
+/*-----------------------------------------------------------------------*/
+// The dashboard's counters have to add up before anyone tunes against them:
+// no class outgrows the budget, the subsets stay inside their sets, the arena
+// peak is a real one, and the same search counts the same twice
+int test_RunSearchStats(int verbose)
+{
+	static const char *sc_fens[] =
+	{
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	};
+	int i, level, failures = 0;
+
+	printf("search statistics\n");
+	for(i = 0; i < (int)(sizeof(sc_fens) / sizeof(sc_fens[0])); ++i)
+	{
+		for(level = 0; level < SEARCH_NUM_SKILLS; ++level)
+		{
+			t_searchResult result;
+			t_searchStats stats, again;
+			unsigned long classes;
+			char side = test_EngineSetFEN(sc_fens[i]);
+			int d, bad = 0;
+
+			search_Best(side, gcSearchSkill[level].m_depth,
+			            gcSearchSkill[level].m_nodes, &result);
+			search_Stats(&stats);
+			search_Best(side, gcSearchSkill[level].m_depth,
+			            gcSearchSkill[level].m_nodes, &result);
+			search_Stats(&again);
+
+			classes = stats.m_pvNodes + stats.m_cutNodes + stats.m_allNodes +
+			          stats.m_drawNodes + stats.m_horizonNodes + stats.m_qNodes;
+			if(classes > result.m_nodes)
+				bad |= 1;
+			if(stats.m_firstCuts > stats.m_cutNodes ||
+			   stats.m_killerCuts > stats.m_quietCuts ||
+			   stats.m_quietCuts > stats.m_cutNodes ||
+			   stats.m_searched > stats.m_genMoves)
+				bad |= 2;
+			if(!stats.m_arenaPeak || stats.m_arenaPeak > stats.m_arenaSize)
+				bad |= 4;
+			for(d = 2; d <= result.m_depth; ++d)
+				if(stats.m_iterNodes[d] < stats.m_iterNodes[d - 1])
+					bad |= 8;
+			if(stats.m_iterNodes[result.m_depth] > result.m_nodes ||
+			   (!stats.m_aborted &&
+			    stats.m_iterNodes[result.m_depth] != result.m_nodes))
+				bad |= 8;
+			if(memcmp(&stats, &again, sizeof(stats)))
+				bad |= 16;
+
+			if(verbose || bad)
+				printf("  %d level %d: nodes %u q %lu cut %lu first %lu killer %lu arena %u%s\n",
+				       i + 1, level + 1, result.m_nodes, stats.m_qNodes,
+				       stats.m_cutNodes, stats.m_firstCuts, stats.m_killerCuts,
+				       stats.m_arenaPeak, bad ? "   FAIL" : "");
+			if(bad)
+				++failures;
+		}
+	}
+
+	printf("  -> %d failing\n", failures);
+	return failures;
+}
+#endif
+
+#if SEARCH_IDLE
+/*-----------------------------------------------------------------------*/
+// Every depth search_Idle reported, in order
+static char sc_idleDepths[SEARCH_MAX_PLY + 1];
+static int si_idleShown;
+
+static void idleShown(const t_searchResult *result)
+{
+	if(si_idleShown < (int)sizeof(sc_idleDepths))
+		sc_idleDepths[si_idleShown] = result->m_depth;
+	++si_idleShown;
+}
+
+/*-----------------------------------------------------------------------*/
+// Left alone, the idle search is search_Best at the deepest level's depth,
+// and reports each depth it finishes on the way.  A key stops it at the next
+// slice and comes back.  Neither way may it leave anything behind on the board
+int test_RunSearchIdle(int verbose)
+{
+	// a rook ending: deep enough in a moment, and plenty to choose between
+	static const char *sc_fen = "8/5k2/3p4/1p1P4/1P3K2/8/4R3/6r1 w - -";
+	static const unsigned long sc_polls = 50;
+	t_searchResult idle, best;
+	unsigned int key;
+	unsigned long lo, hi;
+	char side, maxDepth = gcSearchSkill[SEARCH_NUM_SKILLS - 1].m_depth;
+	int failures = 0, got, i;
+
+	printf("idle search, %u nodes a slice\n", (unsigned)SEARCH_IDLE_SLICE);
+
+	side = test_EngineSetFEN(sc_fen);
+	key = eng_PositionKey();
+	si_idleShown = 0;
+	got = search_Idle(side, &idle, idleShown);
+	search_Best(side, maxDepth, (unsigned int)~0u, &best);
+
+	if(verbose || got || idle.m_depth != maxDepth)
+		printf("  no key: key %d, depth %d of %d, %u nodes%s\n", got, idle.m_depth,
+		       maxDepth, idle.m_nodes, got || idle.m_depth != maxDepth ? "   FAIL" : "");
+	if(got || idle.m_depth != maxDepth)
+		++failures;
+
+	if(verbose || memcmp(&idle.m_move, &best.m_move, sizeof(idle.m_move)) ||
+	   idle.m_score != best.m_score || idle.m_nodes != best.m_nodes)
+		printf("  search_Best: score %d/%d, nodes %u/%u%s\n", idle.m_score, best.m_score,
+		       idle.m_nodes, best.m_nodes,
+		       memcmp(&idle.m_move, &best.m_move, sizeof(idle.m_move)) ||
+		       idle.m_score != best.m_score || idle.m_nodes != best.m_nodes ? "   FAIL" : "");
+	if(memcmp(&idle.m_move, &best.m_move, sizeof(idle.m_move)) ||
+	   idle.m_score != best.m_score || idle.m_nodes != best.m_nodes)
+		++failures;
+
+	// one report a depth, 1 to the last
+	for(i = 0; i < si_idleShown && i < (int)sizeof(sc_idleDepths); ++i)
+	{
+		if(sc_idleDepths[i] != i + 1)
+			break;
+	}
+	if(verbose || si_idleShown != maxDepth || i != si_idleShown)
+		printf("  reported %d depths%s\n", si_idleShown,
+		       si_idleShown != maxDepth || i != si_idleShown ? "   FAIL" : "");
+	if(si_idleShown != maxDepth || i != si_idleShown)
+		++failures;
+
+	// the key on the 50th poll: the poll at node 0 is the first, so the
+	// search has done 49 slices and no more
+	side = test_EngineSetFEN(sc_fen);
+	test_QueueKey(INPUT_HINT, sc_polls);
+	si_idleShown = 0;
+	got = search_Idle(side, &idle, idleShown);
+	lo = (sc_polls - 1) * SEARCH_IDLE_SLICE;
+	hi = sc_polls * SEARCH_IDLE_SLICE;
+	if(verbose || got != INPUT_HINT || idle.m_nodes < lo || idle.m_nodes >= hi ||
+	   !idle.m_haveMove)
+		printf("  key on poll %lu: key %d, %u nodes, depth %d%s\n", sc_polls, got,
+		       idle.m_nodes, idle.m_depth,
+		       got != INPUT_HINT || idle.m_nodes < lo || idle.m_nodes >= hi ||
+		       !idle.m_haveMove ? "   FAIL" : "");
+	if(got != INPUT_HINT || idle.m_nodes < lo || idle.m_nodes >= hi || !idle.m_haveMove)
+		++failures;
+
+	if(verbose || si_idleShown != idle.m_depth)
+		printf("  reported %d depths before the key%s\n", si_idleShown,
+		       si_idleShown != idle.m_depth ? "   FAIL" : "");
+	if(si_idleShown != idle.m_depth)
+		++failures;
+
+	test_QueueKey(0, 0);
+	if(verbose || eng_PositionKey() != key || search_Interrupted())
+		printf("  position key %04x/%04x, interrupted %d%s\n", eng_PositionKey(), key,
+		       search_Interrupted(),
+		       eng_PositionKey() != key || search_Interrupted() ? "   FAIL" : "");
+	if(eng_PositionKey() != key || search_Interrupted())
+		++failures;
+
+	printf("  -> %d failing\n", failures);
+	return failures;
+}
+#endif
+
+#if SEARCH_TRACE
+static char sc_traceStack[64];
+static int si_traceTop, si_traceBad, si_traceRootScore;
+static unsigned long sl_traceEvents;
+static unsigned int si_traceNode;
+
+/*-----------------------------------------------------------------------*/
+// Every ENTER is one ply below the node it comes from and is closed by its
+// own LEAVE, and the node count never runs backwards
+static void traceCheck(const t_searchTrace *event)
+{
+	char kind = event->m_event & ~SEARCH_TRACE_QUIESCE;
+
+	++sl_traceEvents;
+	if(event->m_node < si_traceNode)
+		si_traceBad |= 1;
+	si_traceNode = event->m_node;
+
+	if(SEARCH_TRACE_ENTER == kind)
+	{
+		if(si_traceTop >= (int)sizeof(sc_traceStack) ||
+		   (si_traceTop ? event->m_ply != sc_traceStack[si_traceTop - 1] + 1
+		                : event->m_ply != 0))
+			si_traceBad |= 2;
+		else
+			sc_traceStack[si_traceTop++] = event->m_ply;
+	}
+	else if(SEARCH_TRACE_LEAVE == kind)
+	{
+		if(!si_traceTop || sc_traceStack[si_traceTop - 1] != event->m_ply)
+			si_traceBad |= 4;
+		else
+			--si_traceTop;
+		if(!event->m_ply)
+			si_traceRootScore = event->m_score;
+	}
+	else
+		si_traceBad |= 8;
+}
+
+/*-----------------------------------------------------------------------*/
+// The stream tests/searchtrace writes has to be well formed before a diff of
+// two of them means anything
+int test_RunSearchTrace(int verbose)
+{
+	static const char *sc_fens[] =
+	{
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2P5/8/8/3k4/8/5p2/4K3 w - - 0 1",
+	};
+	int i, failures = 0;
+
+	printf("search trace\n");
+	for(i = 0; i < (int)(sizeof(sc_fens) / sizeof(sc_fens[0])); ++i)
+	{
+		t_searchResult result;
+		char side = test_EngineSetFEN(sc_fens[i]);
+
+		si_traceTop = si_traceBad = 0;
+		si_traceNode = 0;
+		sl_traceEvents = 0;
+		search_SetTrace(traceCheck);
+		search_Best(side, gcSearchSkill[1].m_depth, gcSearchSkill[1].m_nodes, &result);
+		search_SetTrace(NULL);
+
+		if(si_traceTop)
+			si_traceBad |= 16;
+		if(result.m_depth && si_traceRootScore != result.m_score &&
+		   result.m_nodes < gcSearchSkill[1].m_nodes)
+			si_traceBad |= 32;
+
+		if(verbose || si_traceBad)
+			printf("  %d: %lu events, %u nodes%s (%d)\n", i + 1, sl_traceEvents,
+			       result.m_nodes, si_traceBad ? "   FAIL" : "", si_traceBad);
+		if(si_traceBad)
+			++failures;
+	}
+
+	printf("  -> %d failing\n", failures);
+	return failures;
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 int test_RunSearchMateInOne(int verbose)
 {
@@ -580,39 +834,28 @@ int test_RunSearchAlwaysMoves(int verbose)
 }
 
 /*-----------------------------------------------------------------------*/
-// Nodes per second from the host, which is only useful next to the C64
-// measurement in tests/c64perft.c - but it does show what the search costs
-// per node relative to perft
-int test_RunSearchBench(int verbose)
+// bench.c's list, twice.  The numbers are the point and are printed either
+// way; the pass/fail is that the second run visits exactly the nodes the first
+// did, because a signature that wanders from run to run gates nothing
+int test_RunSearchBench(int verbose, int json)
 {
-	static const char *positions[] =
+	t_benchTotals first, second;
+
+	if(json)
 	{
-		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
-		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
-		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
-	};
-	int p;
+		bench_Run(stdout, 0, 1, &first);
+		return 0;
+	}
 
-	(void)verbose;
 	printf("search bench (host)\n");
-	printf("  %-11s %6s %8s %8s %10s\n", "position", "depth", "nodes", "score", "nodes/sec");
-
-	for(p = 0; p < 3; ++p)
+	bench_Run(stdout, verbose, 0, &first);
+	bench_Run(stdout, 0, 0, &second);
+	if(first.m_nodes != second.m_nodes)
 	{
-		t_searchResult result;
-		char side = test_EngineSetFEN(positions[p]);
-		clock_t taken;
-		double secs;
-
-		taken = clock();
-		search_Best(side, 5, 60000, &result);
-		taken = clock() - taken;
-		secs = (double)taken / CLOCKS_PER_SEC;
-
-		printf("  %-11d %6d %8u %8d %10.0f\n", p + 1, result.m_depth,
-		       result.m_nodes, result.m_score, secs > 0 ? result.m_nodes / secs : 0);
+		printf("    FAIL signature moved between runs: %lu, then %lu\n",
+		       first.m_nodes, second.m_nodes);
+		return 1;
 	}
-
 	return 0;
 }
 
@@ -808,3 +1051,66 @@ int test_RunSearchConversion(int verbose)
 	printf("  -> %d failing\n", failures);
 	return failures;
 }
+
+#if SEARCH_NUM_TIMED
+/*-----------------------------------------------------------------------*/
+// The timed levels' arithmetic: seconds times the rate, never under level
+// 1's budget, and with SEARCH_RECALIBRATE a rate that moves a quarter of the
+// way toward each search long enough to time.  The budgets are the suite's
+// SEARCH_NPS of 27 worked out by hand, and the rate is put back afterwards
+int test_RunSearchTimed(int verbose)
+{
+	static const unsigned int sc_budget[SEARCH_NUM_TIMED] = { 405, 810, 1620 };
+	unsigned int rate = search_NodeRate(), got;
+	int failures = 0, i;
+
+	printf("timed levels at %u nodes/sec\n", rate);
+	if(rate != 27)
+	{
+		printf("  starting rate %u, wanted the suite's 27   FAIL\n", rate);
+		return 1;
+	}
+	for(i = 0; i < SEARCH_NUM_TIMED; ++i)
+	{
+		got = search_TimedBudget(gcSearchSeconds[i]);
+
+		if(verbose || got != sc_budget[i])
+			printf("  %2us a move: %u nodes%s\n", (unsigned)gcSearchSeconds[i], got,
+			       got != sc_budget[i] ? "   FAIL" : "");
+		if(got != sc_budget[i])
+			++failures;
+	}
+
+#if SEARCH_RECALIBRATE
+	// too short to say anything, then 500 a second, then nothing at all
+	search_Calibrate(60000u, CLOCKS_PER_SEC - 1);
+	got = search_NodeRate();
+	if(verbose || got != 27)
+		printf("  under a second: %u%s\n", got, got != 27 ? "   FAIL" : "");
+	if(got != 27)
+		++failures;
+
+	// (3 * 27 + 500) / 4
+	search_Calibrate(1000, 2 * CLOCKS_PER_SEC);
+	got = search_NodeRate();
+	if(verbose || got != 145)
+		printf("  after 500/sec: %u%s\n", got, got != 145 ? "   FAIL" : "");
+	if(got != 145)
+		++failures;
+
+	for(i = 0; i < 64; ++i)
+		search_Calibrate(0, 100 * CLOCKS_PER_SEC);
+	got = search_TimedBudget(gcSearchSeconds[SEARCH_NUM_TIMED - 1]);
+	if(verbose || search_NodeRate() != 1 || got != 400)
+		printf("  stalled: %u, budget %u%s\n", search_NodeRate(), got,
+		       search_NodeRate() != 1 || got != 400 ? "   FAIL" : "");
+	if(search_NodeRate() != 1 || got != 400)
+		++failures;
+
+	search_TestSetNodeRate(rate);
+#endif
+
+	printf("  -> %d failing\n", failures);
+	return failures;
+}
+#endif
@@ -0,0 +1,427 @@
+/*
+ *	searchtrace.c
+ *	cc65 Chess - test support
+ *
+ *	Where two builds first search differently.  nodecompare.py can say that
+ *	two builds disagree about a position's node count or best move; this says
+ *	at which node.  "record" runs a list of positions with SEARCH_TRACE on and
+ *	writes every ENTER and LEAVE search.c reports; "diff" walks two such files
+ *	in step and stops at the first event that is not the same, with the moves
+ *	that led there and the position they lead to.
+ *
+ *	A speed candidate that claims to be exact - ENGINE_FAST_LEGAL,
+ *	DEDICATED_CAPTURES, SCORE_FIRST - claims the whole stream is identical,
+ *	not just the root.  Build once per side of the claim:
+ *
+ *	  make searchtrace && mv searchtrace trace-a
+ *	  make -B searchtrace TRACEFLAGS=-DENGINE_FAST_LEGAL=1 && mv searchtrace trace-b
+ *	  ./trace-a record a.trc --skill 2 && ./trace-b record b.trc --skill 2
+ *	  ./trace-a diff a.trc b.trc
+ *
+ *	The file is a magic, then for each position one 'P' record followed by
+ *	its FEN padded to whole records, then one record an event.  A record is
+ *	16 bytes, little-endian, whatever the host:
+ *
+ *	  0-3 node   4 event   5 ply   6 depth   7 from   8 to   9 flags
+ *	  10-11 alpha   12-13 beta   14-15 score
+ *
+ *	A 'P' record keeps the position's index in "node", its depth in "depth",
+ *	the FEN's length in "alpha" and the node budget in "beta".  The move's
+ *	ordering score is left out: it is the one field an exact candidate is
+ *	allowed to change.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "types.h"
+#include "globals.h"
+#include "engine.h"
+#include "search.h"
+#include "testutil.h"
+
+#if !SEARCH_TRACE
+#error searchtrace needs -DSEARCH_TRACE=1
+#endif
+
+#define TRACE_RECORD	16
+#define TRACE_POSITION	'P'
+#define TRACE_FEN_MAX	128
+#define TRACE_MAX_PLY	64		// quiescence has no ply cap of its own
+
+static const char sc_magic[8] = { 'c', 'c', '6', '5', 't', 'r', 'c', '1' };
+static const char sc_promoChar[] = ".rnbqkp";
+
+static FILE *sf_out;
+
+/*-----------------------------------------------------------------------*/
+static void put16(unsigned char *at, int value)
+{
+	at[0] = (unsigned char)value;
+	at[1] = (unsigned char)(value >> 8);
+}
+
+/*-----------------------------------------------------------------------*/
+static int get16(const unsigned char *at)
+{
+	return (short)(at[0] | (at[1] << 8));
+}
+
+/*-----------------------------------------------------------------------*/
+static unsigned long get32(const unsigned char *at)
+{
+	return at[0] | ((unsigned long)at[1] << 8) | ((unsigned long)at[2] << 16) |
+	       ((unsigned long)at[3] << 24);
+}
+
+/*-----------------------------------------------------------------------*/
+static void pack(unsigned char *rec, unsigned long node, char event, char ply,
+                 char depth, const t_engMove *move, int alpha, int beta, int score)
+{
+	rec[0] = (unsigned char)node;
+	rec[1] = (unsigned char)(node >> 8);
+	rec[2] = (unsigned char)(node >> 16);
+	rec[3] = (unsigned char)(node >> 24);
+	rec[4] = event;
+	rec[5] = ply;
+	rec[6] = depth;
+	rec[7] = move ? move->m_from : ENG_NO_SQUARE;
+	rec[8] = move ? move->m_to : ENG_NO_SQUARE;
+	rec[9] = move ? move->m_flags : 0;
+	put16(rec + 10, alpha);
+	put16(rec + 12, beta);
+	put16(rec + 14, score);
+}
+
+/*-----------------------------------------------------------------------*/
+static void record(const t_searchTrace *event)
+{
+	unsigned char rec[TRACE_RECORD];
+
+	pack(rec, event->m_node, event->m_event, event->m_ply, event->m_depth,
+	     event->m_ply ? &event->m_move : NULL, event->m_alpha, event->m_beta,
+	     event->m_score);
+	fwrite(rec, TRACE_RECORD, 1, sf_out);
+}
+
+/*-----------------------------------------------------------------------*/
+// "e2e4", "e7e8q", "--" for the root's empty move
+static void moveName(const unsigned char *rec, char *out6)
+{
+	char promo = rec[9] & ENG_MF_PROMO;
+
+	memset(out6, 0, 6);
+	if(ENG_NO_SQUARE == rec[7])
+	{
+		strcpy(out6, "--");
+		return;
+	}
+	test_TileName(ENG_TO_TILE(rec[7]), out6);
+	test_TileName(ENG_TO_TILE(rec[8]), out6 + 2);
+	if(promo)
+		out6[4] = sc_promoChar[(int)promo];
+}
+
+/*-----------------------------------------------------------------------*/
+static void printEvent(const char *tag, long index, const unsigned char *rec)
+{
+	char move[6];
+	char event = rec[4] & ~SEARCH_TRACE_QUIESCE;
+
+	moveName(rec, move);
+	printf("  %s #%ld  %s ply %d %s %-5s depth %d window [%d, %d]",
+	       tag, index, SEARCH_TRACE_ENTER == event ? "enter" : "leave", rec[5],
+	       (rec[4] & SEARCH_TRACE_QUIESCE) ? "q" : " ", move, rec[6],
+	       get16(rec + 10), get16(rec + 12));
+	if(SEARCH_TRACE_LEAVE == event)
+		printf(" score %d", get16(rec + 14));
+	printf(" node %lu\n", get32(rec));
+}
+
+/*-----------------------------------------------------------------------*/
+static int recordSearch(int index, const char *fen, int depth, unsigned int nodes)
+{
+	unsigned char rec[TRACE_RECORD], pad[TRACE_RECORD];
+	int len = (int)strlen(fen);
+	t_searchResult result;
+	char side;
+
+	pack(rec, index, TRACE_POSITION, 0, depth, NULL, len, nodes, 0);
+	fwrite(rec, TRACE_RECORD, 1, sf_out);
+	fwrite(fen, len, 1, sf_out);
+	memset(pad, 0, sizeof(pad));
+	if(len % TRACE_RECORD)
+		fwrite(pad, TRACE_RECORD - len % TRACE_RECORD, 1, sf_out);
+
+	side = test_EngineSetFEN(fen);
+	geHalfmove = test_FENHalfmove(fen);
+	search_SetTrace(record);
+	search_Best(side, depth, nodes, &result);
+	search_SetTrace(NULL);
+	return result.m_nodes;
+}
+
+/*-----------------------------------------------------------------------*/
+static int cmdRecord(const char *path, const char *fen, const char *epd,
+                     int depth, unsigned int nodes, int count)
+{
+	unsigned long total = 0;
+	int positions = 0;
+
+	sf_out = fopen(path, "wb");
+	if(!sf_out)
+	{
+		perror(path);
+		return 1;
+	}
+	fwrite(sc_magic, sizeof(sc_magic), 1, sf_out);
+
+	// the game's opening randomisation is the one thing that would make a
+	// search depend on anything but the position and this build
+	search_SetSeed(0);
+
+	if(fen)
+		total += recordSearch(positions++, fen, depth, nodes);
+	else
+	{
+		FILE *in = fopen(epd, "r");
+		char line[TRACE_FEN_MAX];
+
+		if(!in)
+		{
+			perror(epd);
+			fclose(sf_out);
+			return 1;
+		}
+		while((count <= 0 || positions < count) && fgets(line, sizeof(line), in))
+		{
+			line[strcspn(line, "\r\n")] = '\0';
+			if(!line[0] || '#' == line[0])
+				continue;
+			total += recordSearch(positions++, line, depth, nodes);
+		}
+		fclose(in);
+	}
+
+	fclose(sf_out);
+	printf("%s: %d positions, %lu nodes, depth %d, budget %u\n", path, positions,
+	       total, depth, nodes);
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// One record, or a 'P' record and the FEN that follows it.  0 at the end
+static int readRecord(FILE *in, unsigned char *rec, char *fen)
+{
+	if(1 != fread(rec, TRACE_RECORD, 1, in))
+		return 0;
+	if(TRACE_POSITION == rec[4])
+	{
+		int len = get16(rec + 10);
+		int padded = (len + TRACE_RECORD - 1) / TRACE_RECORD * TRACE_RECORD;
+
+		if(len <= 0 || padded >= TRACE_FEN_MAX || 1 != fread(fen, padded, 1, in))
+			return 0;
+		fen[len] = '\0';
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+static FILE *openTrace(const char *path)
+{
+	char magic[sizeof(sc_magic)];
+	FILE *in = fopen(path, "rb");
+
+	if(!in)
+	{
+		perror(path);
+		return NULL;
+	}
+	if(1 != fread(magic, sizeof(magic), 1, in) || memcmp(magic, sc_magic, sizeof(magic)))
+	{
+		fprintf(stderr, "%s: not a search trace\n", path);
+		fclose(in);
+		return NULL;
+	}
+	return in;
+}
+
+/*-----------------------------------------------------------------------*/
+// The moves from the root to the parent of the divergent node, and the
+// position they reach.  Moves are matched against the legal list rather than
+// rebuilt, since the flags are all a record keeps
+static void printPath(const char *fen, unsigned char path[][3], int plies)
+{
+	char side = test_EngineSetFEN(fen), name[6], out[TRACE_FEN_MAX];
+	unsigned char rec[TRACE_RECORD];
+	int p;
+
+	printf("  root   %s\n  path  ", fen);
+	if(!plies)
+		printf(" (the root)");
+	for(p = 1; p <= plies; ++p)
+	{
+		t_engMove moves[ENG_MAX_MOVES];
+		t_engUndo undo;
+		char count = eng_GenLegalMoves(side, moves), i;
+
+		memset(rec, 0, sizeof(rec));
+		rec[7] = path[p][0];
+		rec[8] = path[p][1];
+		rec[9] = path[p][2];
+		moveName(rec, name);
+		printf(" %s", name);
+
+		for(i = 0; i < count; ++i)
+			if(moves[i].m_from == path[p][0] && moves[i].m_to == path[p][1] &&
+			   moves[i].m_flags == path[p][2])
+				break;
+		if(i == count)
+		{
+			printf(" (not legal here)");
+			break;
+		}
+		eng_Make(&moves[i], &undo);
+		side = 1 - side;
+	}
+	test_EngineGetFEN(side, out);
+	printf("\n  node   %s\n", out);
+}
+
+/*-----------------------------------------------------------------------*/
+static int cmdDiff(const char *pathA, const char *pathB)
+{
+	unsigned char recA[TRACE_RECORD], recB[TRACE_RECORD];
+	unsigned char path[TRACE_MAX_PLY][3];
+	char fenA[TRACE_FEN_MAX], fenB[TRACE_FEN_MAX];
+	FILE *a, *b;
+	long index = 0;
+	int positions = 0, diverged = 0;
+
+	a = openTrace(pathA);
+	if(!a)
+		return 2;
+	b = openTrace(pathB);
+	if(!b)
+	{
+		fclose(a);
+		return 2;
+	}
+	fenA[0] = fenB[0] = '\0';
+
+	for(;; ++index)
+	{
+		int haveA = readRecord(a, recA, fenA);
+		int haveB = readRecord(b, recB, fenB);
+
+		if(!haveA && !haveB)
+			break;
+		if(haveA != haveB)
+		{
+			printf("%s ends at record %ld, %d positions in\n", haveA ? pathB : pathA,
+			       index, positions);
+			if(haveA)
+				printEvent("a", index, recA);
+			else
+				printEvent("b", index, recB);
+			diverged = 1;
+			break;
+		}
+		if(memcmp(recA, recB, TRACE_RECORD) ||
+		   (TRACE_POSITION == recA[4] && strcmp(fenA, fenB)))
+		{
+			int ply = TRACE_POSITION == recA[4] ? 0 : recA[5];
+
+			printf("first difference at record %ld, position %d\n", index,
+			       TRACE_POSITION == recA[4] ? positions : positions - 1);
+			if(ply > TRACE_MAX_PLY)
+				ply = TRACE_MAX_PLY;
+			printPath(fenA, path, ply > 0 ? ply - 1 : 0);
+			printEvent("a", index, recA);
+			printEvent("b", index, recB);
+			diverged = 1;
+			break;
+		}
+
+		if(TRACE_POSITION == recA[4])
+			++positions;
+		else if(SEARCH_TRACE_ENTER == (recA[4] & ~SEARCH_TRACE_QUIESCE) &&
+		        recA[5] > 0 && recA[5] < TRACE_MAX_PLY)
+		{
+			path[recA[5]][0] = recA[7];
+			path[recA[5]][1] = recA[8];
+			path[recA[5]][2] = recA[9];
+		}
+	}
+
+	if(!diverged)
+		printf("identical: %ld records over %d positions\n", index, positions);
+	fclose(a);
+	fclose(b);
+	return diverged;
+}
+
+/*-----------------------------------------------------------------------*/
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+	        "usage: %s record <out> [--fen FEN | --epd FILE] [--count N]\n"
+	        "                 [--skill 1-%d | --depth D --nodes N]\n"
+	        "       %s diff <a> <b>\n", argv0, SEARCH_NUM_SKILLS, argv0);
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	const char *fen = NULL, *epd = "book.epd";
+	int level = 2, depth = 0, count = 0, i;
+	long nodes = 0;
+
+	if(argc == 4 && !strcmp(argv[1], "diff"))
+		return cmdDiff(argv[2], argv[3]);
+
+	if(argc < 3 || strcmp(argv[1], "record"))
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	for(i = 3; i < argc; ++i)
+	{
+		if(!strcmp(argv[i], "--fen") && i + 1 < argc)
+			fen = argv[++i];
+		else if(!strcmp(argv[i], "--epd") && i + 1 < argc)
+			epd = argv[++i];
+		else if(!strcmp(argv[i], "--count") && i + 1 < argc)
+			count = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--skill") && i + 1 < argc)
+			level = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--depth") && i + 1 < argc)
+			depth = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--nodes") && i + 1 < argc)
+			nodes = atol(argv[++i]);
+		else
+		{
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if(level < 1 || level > SEARCH_NUM_SKILLS)
+	{
+		fprintf(stderr, "searchtrace: skill is 1 to %d\n", SEARCH_NUM_SKILLS);
+		return 2;
+	}
+
+	// --depth and --nodes beat the skill level, as go depth / go nodes do in
+	// tests/uci; 65535 is what a 16 bit budget can hold on the target
+	if(depth <= 0)
+		depth = gcSearchSkill[level - 1].m_depth;
+	if(nodes <= 0)
+		nodes = gcSearchSkill[level - 1].m_nodes;
+	if(depth > SEARCH_MAX_PLY)
+		depth = SEARCH_MAX_PLY;
+	if(nodes > 65535L)
+		nodes = 65535L;
+
+	return cmdRecord(argv[2], fen, epd, depth, (unsigned int)nodes, count);
+}
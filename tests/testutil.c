@@ -4,6 +4,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "types.h"
 #include "globals.h"
 #include "engine.h"
@@ -113,3 +114,109 @@ void test_DumpBoard(const char *tag)
 	}
 	printf("    abcdefgh\n");
 }
+
+/*-----------------------------------------------------------------------*/
+// Long algebraic or SAN, checked against the legal list either way, which is
+// the only place the castling and en passant flags can come from.  SAN is
+// what the match runners write into their PGNs, with check marks, captures
+// and annotations that say nothing about which move it was; those are skipped
+char test_ParseMove(char side, const char *text, t_engMove *out)
+{
+	t_engMove moves[ENG_MAX_MOVES];
+	char san[16], count, i, len, kind = PAWN, promo = NONE;
+	char toFile, toRank, fromFile = 0, fromRank = 0, found = 0;
+	const char *pieces = "RNBQK";
+
+	for(len = 0; *text && len < (char)sizeof(san) - 1; ++text)
+		if(!strchr("+#!?x:=", *text))
+			san[len++] = *text;
+	san[len] = '\0';
+	if(len < 2)
+		return 0;
+
+	count = eng_GenLegalMoves(side, moves);
+
+	if(!strcmp(san, "O-O") || !strcmp(san, "0-0") ||
+	   !strcmp(san, "O-O-O") || !strcmp(san, "0-0-0"))
+	{
+		char flag = (len > 3) ? ENG_MF_CASTLE_Q : ENG_MF_CASTLE_K;
+
+		for(i = 0; i < count; ++i)
+			if(moves[i].m_flags & flag)
+			{
+				*out = moves[i];
+				return 1;
+			}
+		return 0;
+	}
+
+	// e2e4 / e7e8q: the UCI form, and the one EPD files written here use
+	if(len >= 4 && san[0] >= 'a' && san[0] <= 'h' && san[1] >= '1' && san[1] <= '8' &&
+	   san[2] >= 'a' && san[2] <= 'h' && san[3] >= '1' && san[3] <= '8')
+	{
+		char from = ENG_FROM_TILE(test_Square(san));
+		char to = ENG_FROM_TILE(test_Square(san + 2));
+
+		if(len > 4)
+		{
+			const char *p = strchr(".rnbqkp", san[4] | 0x20);
+			promo = p ? (char)(p - ".rnbqkp") : NONE;
+		}
+		for(i = 0; i < count; ++i)
+		{
+			char mp = moves[i].m_flags & ENG_MF_PROMO;
+
+			if(moves[i].m_from == from && moves[i].m_to == to && (!mp || mp == promo))
+			{
+				*out = moves[i];
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	if(strchr(pieces, san[0]))
+	{
+		kind = (char)(strchr(pieces, san[0]) - pieces) + ROOK;
+		memmove(san, san + 1, len--);
+	}
+
+	// a trailing piece letter is a promotion, with or without its "="
+	if(len && strchr("RNBQ", san[len - 1]))
+	{
+		promo = (char)(strchr(pieces, san[len - 1]) - pieces) + ROOK;
+		san[--len] = '\0';
+	}
+	if(len < 2)
+		return 0;
+
+	toFile = san[len - 2];
+	toRank = san[len - 1];
+	for(i = 0; i < len - 2; ++i)
+	{
+		if(san[i] >= 'a' && san[i] <= 'h') fromFile = san[i];
+		else if(san[i] >= '1' && san[i] <= '8') fromRank = san[i];
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		char name[3];
+		char from = ENG_TO_TILE(moves[i].m_from);
+
+		if(kind != (geBoard[moves[i].m_from] & PIECE_DATA) ||
+		   (moves[i].m_flags & ENG_MF_PROMO) != promo)
+			continue;
+		test_TileName(ENG_TO_TILE(moves[i].m_to), name);
+		if(name[0] != toFile || name[1] != toRank)
+			continue;
+		test_TileName(from, name);
+		if((fromFile && name[0] != fromFile) || (fromRank && name[1] != fromRank))
+			continue;
+		if(found)
+			return 0;			// ambiguous - a PGN writer never leaves that
+		*out = moves[i];
+		found = 1;
+	}
+
+	return found;
+}
@@ -10,6 +10,8 @@
 #ifndef _TESTUTIL_H_
 #define _TESTUTIL_H_
 
+#include "engine.h"
+
 /*-----------------------------------------------------------------------*/
 // Tile <-> algebraic, in the UI's 0..63 numbering where tile 0 is a8
 char test_Square(const char *algebraic);
@@ -22,22 +24,40 @@ void test_DumpBoard(const char *tag);
 /*-----------------------------------------------------------------------*/
 // Set the engine from a FEN; returns the side to move
 char test_EngineSetFEN(const char *fen);
+// The FEN's halfmove clock, which test_EngineSetFEN leaves alone
+char test_FENHalfmove(const char *fen);
 // The other direction, for writing an opening book or lifting a position out
 // of a game to look at.  "out" needs 90 bytes
 void test_EngineGetFEN(char side, char *out);
-// Per-move node counts, for tracking down a perft mismatch
-void test_EnginePerftDivide(const char *fen, int depth);
+// A move as text - SAN from a PGN or long algebraic - matched against the
+// legal moves of the position on the board.  Returns 0 if nothing matches
+char test_ParseMove(char side, const char *text, t_engMove *out);
+// Legal leaf count to "depth" from the position on the board, with the
+// perft hash and in this process.  1 at depth 0
+unsigned long long test_EnginePerft(char side, int depth);
+// Per-move node counts, for tracking down a perft mismatch.  The root moves
+// are shared over "jobs" forked workers
+void test_EnginePerftDivide(const char *fen, int depth, int jobs);
+// Perft hash per worker in megabytes, 0 for none.  64 until set
+void test_PerftHashSize(int megabytes);
 
 /*-----------------------------------------------------------------------*/
 // The suites.  Each returns the number of failures
-int test_RunEnginePerft(int maxDepth, int verbose);
+// Lines whose reference count is over budget * jobs are left out; 0 runs all
+int test_RunEnginePerft(int maxDepth, int jobs, long budget, int verbose);
 int test_RunQuiescenceGen(int verbose);
 int test_RunBudgetSurvey(int verbose);
 int test_RunGameFuzz(int seed, int games, int verbose);
+// The games from seeds first..last over "jobs" forked workers
+int test_RunGameFuzzSeeds(int first, int last, int jobs, int verbose);
 int test_RunCastle(int verbose);
+int test_RunRedraw(int verbose);
 int test_RunLegality(int verbose);
 int test_RunRepetition(int verbose);
 int test_RunOpening(int verbose);
+int test_RunBook(int verbose);
+int test_RunEvalFit(int verbose);
+int test_RunCApi(int verbose);
 int test_RunSelfPlay(int games, int maxPlies, int verbose);
 int test_RunSearchTactics(int verbose);
 int test_RunSearchOrder(int verbose);
@@ -45,10 +65,22 @@ int test_RunSearchFollowPV(int verbose);
 int test_RunSearchRootScores(int verbose);
 int test_RunSearchHistory(int verbose);
 int test_RunSearchAspiration(int verbose);
+#if SEARCH_STATS
+int test_RunSearchStats(int verbose);
+#endif
+#if SEARCH_TRACE
+int test_RunSearchTrace(int verbose);
+#endif
+#if SEARCH_NPS
+int test_RunSearchTimed(int verbose);
+#endif
+#if SEARCH_IDLE
+int test_RunSearchIdle(int verbose);
+#endif
 int test_RunSearchAlwaysMoves(int verbose);
 int test_RunSearchMateInOne(int verbose);
 int test_RunSearchConversion(int verbose);
-int test_RunSearchBench(int verbose);
+int test_RunSearchBench(int verbose, int json);
 int test_RunMatchSanity(int verbose);
 int test_RunMatchTerms(int verbose);
 int test_RunMatchDepth(int verbose);
@@ -63,4 +95,20 @@ int test_RunMatchDev(int verbose);
 int test_RunPawnStruct(int verbose);
 int test_RunDev(int verbose);
 
+// The tiles tests/platStub.c was asked to draw since the last call, as
+// eight row bytes; asking starts the record again
+void test_TakeDrawn(char *drawn);
+
+// Have tests/platStub.c's plat_ReadKeys return "keyMask" on the "polls"th
+// call from now, counting from 1.  One key at a time; 0 cancels it
+void test_QueueKey(int keyMask, unsigned long polls);
+
+#if PLAT_BANKS
+// What tests/platStub.c's simulated banks have seen: plat_BankSelect calls,
+// the ones that changed bank, and bytes read or written through the window
+void test_BankStats(unsigned long *selects, unsigned long *switches,
+                    unsigned long *bytes);
+int test_RunBanks(int verbose);
+#endif
+
 #endif //_TESTUTIL_H_
@@ -0,0 +1,614 @@
+/*
+ *	texel.c
+ *	cc65 Chess - test support
+ *
+ *	See texel.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "types.h"
+#include "engine.h"
+#include "eval.h"
+#include "posfile.h"
+#include "texel.h"
+#include "testutil.h"
+
+#define MAX_THREADS		64
+
+// Stay near the existing family.  Piece values in centipawns; scales round 1
+static const double sc_bound[TEXEL_PARAMS][2] =
+{
+	{ 260, 400 }, { 260, 400 }, { 420, 600 }, { 800, 1100 },
+	{ 0.5, 1.5 }, { 0.5, 1.5 }, { 0.5, 1.5 }, { 0.5, 1.5 }, { 0.5, 1.5 }, { 0.5, 1.5 },
+	{ 0.5, 1.5 }, { 0.5, 1.5 },
+};
+
+static const char *sc_name[TEXEL_PARAMS] =
+{
+	"N", "B", "R", "Q", "sP", "sN", "sB", "sR", "sQ", "sK", "sEndP", "sEndK",
+};
+
+// The kind each piece value and each middlegame scale applies to
+static const char sc_valueKind[4] = { KNIGHT, BISHOP, ROOK, QUEEN };
+static const char sc_tableKind[6] = { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+
+/*-----------------------------------------------------------------------*/
+void texel_Sample(float result, t_texelSample *sample)
+{
+	t_evalCoeffs coeffs;
+	char kind;
+
+	eval_Coefficients(&coeffs);
+
+	sample->m_result = result;
+	for(kind = 0; kind <= PAWN; ++kind)
+	{
+		sample->m_count[kind] = (short)coeffs.m_count[kind];
+		sample->m_phaseCount[kind] = (unsigned char)coeffs.m_phaseCount[kind];
+		sample->m_pst[kind] = (short)coeffs.m_pst[kind];
+	}
+	sample->m_endPawn = (short)coeffs.m_endPawn;
+	sample->m_endKing = (short)coeffs.m_endKing;
+	sample->m_drive[SIDE_BLACK] = (short)coeffs.m_drive[SIDE_BLACK];
+	sample->m_drive[SIDE_WHITE] = (short)coeffs.m_drive[SIDE_WHITE];
+	sample->m_fixed = (short)coeffs.m_fixed;
+	sample->m_eval = (short)eval_Position(SIDE_WHITE);
+}
+
+/*-----------------------------------------------------------------------*/
+// The column of "name" in a tab-separated header line, or -1
+static int findColumn(const char *line, const char *end, const char *name)
+{
+	size_t length = strlen(name);
+	int column = 0;
+
+	while(line < end)
+	{
+		const char *tab = memchr(line, '\t', (size_t)(end - line));
+		const char *stop = tab ? tab : end;
+
+		if((size_t)(stop - line) == length && !memcmp(line, name, length))
+			return column;
+		if(!tab)
+			break;
+		line = tab + 1;
+		++column;
+	}
+	return -1;
+}
+
+/*-----------------------------------------------------------------------*/
+// Start and length of one column of a row
+static const char *field(const char *line, const char *end, int column, int *length)
+{
+	const char *tab;
+
+	while(column-- > 0)
+	{
+		tab = memchr(line, '\t', (size_t)(end - line));
+		if(!tab)
+			return 0;
+		line = tab + 1;
+	}
+	tab = memchr(line, '\t', (size_t)(end - line));
+	*length = (int)((tab ? tab : end) - line);
+	return line;
+}
+
+/*-----------------------------------------------------------------------*/
+static long loadTSV(const char *path, t_texelSet *set, long *stale)
+{
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+	const char *map, *line, *end;
+	int resultCol = -1, evalCol = -1, fenCol = -1;
+	long rows;
+
+	if(fd < 0 || fstat(fd, &info) < 0)
+	{
+		if(fd >= 0)
+			close(fd);
+		return -1;
+	}
+	if(!info.st_size)
+	{
+		close(fd);
+		return 0;
+	}
+
+	map = (const char *)mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(MAP_FAILED == map)
+		return -1;
+	end = map + info.st_size;
+
+	// one pass to size the array, so the load never reallocates
+	rows = 1;
+	for(line = map; (line = memchr(line, '\n', (size_t)(end - line))) != 0; ++line)
+		++rows;
+	set->m_samples = (t_texelSample *)malloc((size_t)rows * sizeof(t_texelSample));
+	if(!set->m_samples)
+	{
+		munmap((void *)map, (size_t)info.st_size);
+		return -1;
+	}
+
+	for(line = map; line < end; )
+	{
+		const char *nl = memchr(line, '\n', (size_t)(end - line));
+		const char *stop = nl ? nl : end;
+		const char *text;
+		char fen[128];
+		int length;
+
+		if(stop > line && '\r' == stop[-1])
+			--stop;
+
+		if(stop == line || '#' == *line)
+			;
+		else if(fenCol < 0)
+		{
+			resultCol = findColumn(line, stop, "result");
+			evalCol = findColumn(line, stop, "eval");
+			fenCol = findColumn(line, stop, "fen");
+			if(resultCol < 0 || fenCol < 0)
+				break;
+		}
+		else if((text = field(line, stop, fenCol, &length)) != 0 && length < (int)sizeof(fen))
+		{
+			t_texelSample *sample = &set->m_samples[set->m_count];
+			float result;
+
+			memcpy(fen, text, (size_t)length);
+			fen[length] = '\0';
+			text = field(line, stop, resultCol, &length);
+			result = text ? (float)strtod(text, 0) : 0.5f;
+
+			test_EngineSetFEN(fen);
+			texel_Sample(result, sample);
+			if(evalCol >= 0 && (text = field(line, stop, evalCol, &length)) != 0 &&
+			   strtol(text, 0, 10) != sample->m_eval)
+				++*stale;
+
+			if(1.0f == result)
+				++set->m_wins;
+			else if(0.0f == result)
+				++set->m_losses;
+			++set->m_count;
+		}
+
+		line = nl ? nl + 1 : end;
+	}
+
+	munmap((void *)map, (size_t)info.st_size);
+	if(fenCol < 0)
+	{
+		texel_Free(set);
+		return -1;
+	}
+	return set->m_count;
+}
+
+/*-----------------------------------------------------------------------*/
+// The binary form: no parsing at all, each record goes straight onto the
+// board and is sampled there
+static long loadBinary(const char *path, t_texelSet *set, long *stale)
+{
+	const unsigned char *records;
+	size_t mapped;
+	long count, i;
+
+	records = posfile_Map(path, &count, &mapped);
+	if(!records)
+		return -1;
+	set->m_samples = (t_texelSample *)malloc((size_t)(count ? count : 1) * sizeof(t_texelSample));
+	if(!set->m_samples)
+	{
+		posfile_Unmap(records, mapped);
+		return -1;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		const unsigned char *record = records + i * POSFILE_RECORD;
+		t_texelSample *sample = &set->m_samples[i];
+		float result = posfile_Result(record);
+
+		posfile_Unpack(record);
+		texel_Sample(result, sample);
+		if(posfile_Eval(record) != sample->m_eval)
+			++*stale;
+		if(1.0f == result)
+			++set->m_wins;
+		else if(0.0f == result)
+			++set->m_losses;
+	}
+	set->m_count = count;
+
+	posfile_Unmap(records, mapped);
+	return count;
+}
+
+/*-----------------------------------------------------------------------*/
+long texel_Load(const char *path, t_texelSet *set, long *stale)
+{
+	memset(set, 0, sizeof(*set));
+	*stale = 0;
+	return posfile_IsPosFile(path) ? loadBinary(path, set, stale) : loadTSV(path, set, stale);
+}
+
+/*-----------------------------------------------------------------------*/
+void texel_Free(t_texelSet *set)
+{
+	free(set->m_samples);
+	memset(set, 0, sizeof(*set));
+}
+
+/*-----------------------------------------------------------------------*/
+void texel_Shipping(double *params)
+{
+	int i;
+
+	for(i = TEXEL_N; i <= TEXEL_Q; ++i)
+		params[i] = gcPieceValue[(int)sc_valueKind[i]];
+	for(i = TEXEL_SP; i < TEXEL_PARAMS; ++i)
+		params[i] = 1.0;
+}
+
+/*-----------------------------------------------------------------------*/
+void texel_Clamp(double *params)
+{
+	int i;
+
+	for(i = 0; i < TEXEL_PARAMS; ++i)
+	{
+		if(params[i] < sc_bound[i][0])
+			params[i] = sc_bound[i][0];
+		else if(params[i] > sc_bound[i][1])
+			params[i] = sc_bound[i][1];
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+const char *texel_Name(int param)
+{
+	return sc_name[param];
+}
+
+/*-----------------------------------------------------------------------*/
+// The score, and through "weight" how much of the endgame difference the
+// blend step took.  The blend threshold scales with the starting material, so
+// a fit that moves the piece values keeps the four steps where they fall now
+static int modelScore(const double *p, const t_texelSample *s, double *weight)
+{
+	double mid = gcPieceValue[PAWN] * (double)s->m_count[PAWN], end, phase = 0;
+	double start, shipped;
+	int i, score, phaseInt, phaseEnd;
+
+	for(i = TEXEL_N; i <= TEXEL_Q; ++i)
+	{
+		mid += p[i] * s->m_count[(int)sc_valueKind[i]];
+		phase += p[i] * s->m_phaseCount[(int)sc_valueKind[i]];
+	}
+	for(i = TEXEL_SP; i <= TEXEL_SK; ++i)
+		mid += p[i] * s->m_pst[(int)sc_tableKind[i - TEXEL_SP]];
+
+	end = p[TEXEL_SENDP] * s->m_endPawn + p[TEXEL_SENDK] * s->m_endKing -
+	      p[TEXEL_SP] * s->m_pst[PAWN] - p[TEXEL_SK] * s->m_pst[KING];
+
+	start = 4 * (p[TEXEL_N] + p[TEXEL_B] + p[TEXEL_R]) + 2 * p[TEXEL_Q];
+	shipped = 4 * (gcPieceValue[KNIGHT] + gcPieceValue[BISHOP] + gcPieceValue[ROOK]) +
+	          2 * gcPieceValue[QUEEN];
+	phaseEnd = (int)lround(PHASE_ENDGAME * start / shipped);
+	phaseInt = (int)lround(phase);
+
+	score = (int)lround(mid) + s->m_fixed;
+	*weight = 0;
+	if(phaseInt < phaseEnd)
+	{
+		int adj = (int)lround(end);
+
+		switch((phaseEnd - phaseInt) >> 10)
+		{
+			case 0:  score += adj >> 2;               *weight = 0.25; break;
+			case 1:  score += adj >> 1;               *weight = 0.5;  break;
+			case 2:  score += (adj >> 1) + (adj >> 2); *weight = 0.75; break;
+			default: score += adj;                    *weight = 1;    break;
+		}
+
+		if(phaseInt <= DRIVE_PHASE)
+		{
+			if(score > DRIVE_GATE)
+				score += s->m_drive[SIDE_WHITE];
+			else if(score < -DRIVE_GATE)
+				score -= s->m_drive[SIDE_BLACK];
+		}
+	}
+	return score;
+}
+
+/*-----------------------------------------------------------------------*/
+int texel_Eval(const double *params, const t_texelSample *sample)
+{
+	double weight;
+
+	return modelScore(params, sample, &weight);
+}
+
+/*-----------------------------------------------------------------------*/
+long texel_Verify(const t_texelSet *set)
+{
+	double shipping[TEXEL_PARAMS];
+	long i, bad = 0;
+
+	texel_Shipping(shipping);
+	for(i = 0; i < set->m_count; ++i)
+		if(texel_Eval(shipping, &set->m_samples[i]) != set->m_samples[i].m_eval)
+			++bad;
+	return bad;
+}
+
+/*-----------------------------------------------------------------------*/
+// One worker's share of an epoch.  Each sums its own slice into its own
+// totals, so nothing is shared while they run
+typedef struct tag_texelWork
+{
+	const t_texelSet	*m_set;
+	const double		*m_params;
+	double				m_k;
+	long				m_from;
+	long				m_to;
+	char				m_wantGrad;
+	double				m_loss;
+	double				m_grad[TEXEL_PARAMS];
+} t_texelWork;
+
+/*-----------------------------------------------------------------------*/
+static void *epochSlice(void *arg)
+{
+	t_texelWork *work = (t_texelWork *)arg;
+	const double *p = work->m_params;
+	double scale = work->m_k * log(10.0) / 400.0;
+	long i;
+
+	work->m_loss = 0;
+	memset(work->m_grad, 0, sizeof(work->m_grad));
+
+	for(i = work->m_from; i < work->m_to; ++i)
+	{
+		const t_texelSample *s = &work->m_set->m_samples[i];
+		double weight, sigmoid, diff, g;
+		int score = modelScore(p, s, &weight), j;
+
+		sigmoid = 1.0 / (1.0 + exp(-scale * score));
+		diff = s->m_result - sigmoid;
+		work->m_loss += diff * diff;
+		if(!work->m_wantGrad)
+			continue;
+
+		// d(diff^2)/d(score), then the score's own slope in each number.
+		// Between blend steps the weight is constant and the score linear
+		g = -2.0 * diff * sigmoid * (1.0 - sigmoid) * scale;
+		for(j = TEXEL_N; j <= TEXEL_Q; ++j)
+			work->m_grad[j] += g * s->m_count[(int)sc_valueKind[j]];
+		for(j = TEXEL_SN; j <= TEXEL_SQ; ++j)
+			work->m_grad[j] += g * s->m_pst[(int)sc_tableKind[j - TEXEL_SP]];
+		work->m_grad[TEXEL_SP] += g * (1.0 - weight) * s->m_pst[PAWN];
+		work->m_grad[TEXEL_SK] += g * (1.0 - weight) * s->m_pst[KING];
+		work->m_grad[TEXEL_SENDP] += g * weight * s->m_endPawn;
+		work->m_grad[TEXEL_SENDK] += g * weight * s->m_endKing;
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+// Split the set into "threads" slices and add the slices up in order, so the
+// answer does not depend on which worker finished first
+static double runEpoch(const t_texelSet *set, const double *params, double k,
+                       double *grad, int threads)
+{
+	t_texelWork work[MAX_THREADS];
+	pthread_t ids[MAX_THREADS];
+	char started[MAX_THREADS];
+	double loss = 0;
+	int t, j;
+
+	if(threads < 1)
+		threads = 1;
+	if(threads > MAX_THREADS)
+		threads = MAX_THREADS;
+	if(threads > set->m_count)
+		threads = set->m_count ? (int)set->m_count : 1;
+
+	for(t = 0; t < threads; ++t)
+	{
+		work[t].m_set = set;
+		work[t].m_params = params;
+		work[t].m_k = k;
+		work[t].m_from = set->m_count * t / threads;
+		work[t].m_to = set->m_count * (t + 1) / threads;
+		work[t].m_wantGrad = grad != 0;
+	}
+
+	// the calling thread takes the first slice; a worker that cannot be
+	// started has its slice run here too, so the answer is the same either way
+	for(t = 1; t < threads; ++t)
+		started[t] = !pthread_create(&ids[t], 0, epochSlice, &work[t]);
+	epochSlice(&work[0]);
+
+	if(grad)
+		memset(grad, 0, TEXEL_PARAMS * sizeof(double));
+	for(t = 0; t < threads; ++t)
+	{
+		if(t && started[t])
+			pthread_join(ids[t], 0);
+		else if(t)
+			epochSlice(&work[t]);
+		loss += work[t].m_loss;
+		for(j = 0; grad && j < TEXEL_PARAMS; ++j)
+			grad[j] += work[t].m_grad[j];
+	}
+
+	if(set->m_count)
+	{
+		loss /= set->m_count;
+		for(j = 0; grad && j < TEXEL_PARAMS; ++j)
+			grad[j] /= set->m_count;
+	}
+	return loss;
+}
+
+/*-----------------------------------------------------------------------*/
+double texel_Loss(const t_texelSet *set, const double *params, double k, int threads)
+{
+	return runEpoch(set, params, k, 0, threads);
+}
+
+/*-----------------------------------------------------------------------*/
+// Piece values are hundreds of centipawns from where they start and scales
+// are fractions, so the prior measures both in about the same units
+static double priorScale(int param)
+{
+	return param <= TEXEL_Q ? 100.0 : 1.0;
+}
+
+/*-----------------------------------------------------------------------*/
+double texel_Gradient(const t_texelSet *set, const double *params, double k,
+                      double lambda, double *grad, int threads)
+{
+	double shipping[TEXEL_PARAMS], loss;
+	int i;
+
+	texel_Shipping(shipping);
+	loss = runEpoch(set, params, k, grad, threads);
+	for(i = 0; i < TEXEL_PARAMS; ++i)
+	{
+		double d = (params[i] - shipping[i]) / priorScale(i);
+
+		loss += lambda * d * d;
+		grad[i] += lambda * 2.0 * d / priorScale(i);
+	}
+	return loss;
+}
+
+/*-----------------------------------------------------------------------*/
+double texel_FitK(const t_texelSet *set, int threads)
+{
+	double shipping[TEXEL_PARAMS], best = 1e9, bestK = 1.0;
+	int step;
+
+	texel_Shipping(shipping);
+	for(step = 0; step <= 56; ++step)
+	{
+		double k = 0.2 + 0.05 * step;
+		double loss = texel_Loss(set, shipping, k, threads);
+
+		if(loss < best)
+		{
+			best = loss;
+			bestK = k;
+		}
+	}
+	return bestK;
+}
+
+/*-----------------------------------------------------------------------*/
+void texel_Fit(const t_texelSet *set, double k, double lambda, int steps,
+               int threads, int verbose, double *params)
+{
+	const double rate = 0.08, beta1 = 0.9, beta2 = 0.999, eps = 1e-8;
+	double m[TEXEL_PARAMS] = { 0 }, v[TEXEL_PARAMS] = { 0 }, grad[TEXEL_PARAMS];
+	int t, i;
+
+	texel_Shipping(params);
+	for(t = 1; t <= steps; ++t)
+	{
+		double objective = texel_Gradient(set, params, k, lambda, grad, threads);
+
+		for(i = 0; i < TEXEL_PARAMS; ++i)
+		{
+			m[i] = beta1 * m[i] + (1 - beta1) * grad[i];
+			v[i] = beta2 * v[i] + (1 - beta2) * grad[i] * grad[i];
+			params[i] -= rate * (m[i] / (1 - pow(beta1, t))) /
+			             (sqrt(v[i] / (1 - pow(beta2, t))) + eps);
+		}
+		// keep piece values on a pawn=100 scale; do not let a scale explode
+		texel_Clamp(params);
+
+		if(verbose && (1 == t || 0 == t % 20))
+			printf("  step %3d  train-obj %.6f\n", t, objective);
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+// The largest scale a table can take before a cell no longer fits
+static double maxScale(int param)
+{
+	int peak = (param >= TEXEL_SENDP)
+	         ? eval_TablePeak(TEXEL_SENDP == param ? PAWN : KING, 1)
+	         : eval_TablePeak(sc_tableKind[param - TEXEL_SP], 0);
+
+	return peak ? 127.0 / peak : sc_bound[param][1];
+}
+
+/*-----------------------------------------------------------------------*/
+static double hundredths(double value)
+{
+	return floor(value * 100.0 + 0.5) / 100.0;
+}
+
+/*-----------------------------------------------------------------------*/
+void texel_Quantize(const double *params, double *quant)
+{
+	int i;
+
+	for(i = TEXEL_N; i <= TEXEL_Q; ++i)
+		quant[i] = 5.0 * floor(params[i] / 5.0 + 0.5);
+	for(i = TEXEL_SP; i < TEXEL_PARAMS; ++i)
+	{
+		double limit = hundredths(maxScale(i));
+
+		quant[i] = hundredths(params[i]);
+		if(quant[i] > limit)
+			quant[i] = limit;
+	}
+	texel_Clamp(quant);
+}
+
+/*-----------------------------------------------------------------------*/
+char texel_TablesFit(const double *params)
+{
+	int i;
+
+	for(i = TEXEL_SP; i < TEXEL_PARAMS; ++i)
+	{
+		int peak = (i >= TEXEL_SENDP)
+		         ? eval_TablePeak(TEXEL_SENDP == i ? PAWN : KING, 1)
+		         : eval_TablePeak(sc_tableKind[i - TEXEL_SP], 0);
+
+		if(lround(peak * params[i]) > 127)
+			return 0;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+char texel_NearShipping(const double *params)
+{
+	double shipping[TEXEL_PARAMS];
+	int i;
+
+	texel_Shipping(shipping);
+	for(i = 0; i < TEXEL_PARAMS; ++i)
+		if(fabs(params[i] - shipping[i]) > (i <= TEXEL_Q ? 10.0 : 0.05))
+			return 0;
+	return 1;
+}
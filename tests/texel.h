@@ -0,0 +1,113 @@
+/*
+ *	texel.h
+ *	cc65 Chess - test support
+ *
+ *	The E2 fit in C: one constrained Texel fit of the numbers that already
+ *	ship.  Pawn stays 100; the other piece values move, and each middlegame
+ *	and endgame table may scale as a whole, but no cell is free.  That is the
+ *	family tune_eval.py fitted, with the same bounds, prior and freeze.
+ *
+ *	What changed is where the evaluation comes from.  The Python fit carried
+ *	its own copy of every table and drive constant and had to be checked
+ *	against the engine before it could be trusted.  Here each position is
+ *	turned into coefficients by eval_Coefficients - eval.c's tables, read by
+ *	eval.c - once at load, and every epoch after that is arithmetic on those.
+ *	texel_Verify proves the rebuilt score is eval_Position's at the shipping
+ *	numbers, for every position loaded rather than a sample.
+ *
+ *	Needs EVAL_TUNING for the coefficients.  Host only.
+ */
+
+#ifndef _TEXEL_H_
+#define _TEXEL_H_
+
+#include "types.h"
+#include "engine.h"
+
+// The fitted numbers, in this order everywhere
+enum
+{
+	TEXEL_N, TEXEL_B, TEXEL_R, TEXEL_Q,
+	TEXEL_SP, TEXEL_SN, TEXEL_SB, TEXEL_SR, TEXEL_SQ, TEXEL_SK,
+	TEXEL_SENDP, TEXEL_SENDK,
+	TEXEL_PARAMS
+};
+
+// One position, as coefficients.  Small on purpose: an epoch streams the
+// whole set through the cache once per step
+typedef struct tag_texelSample
+{
+	float			m_result;				// white's score: 1, 0.5 or 0
+	short			m_count[PAWN+1];		// see t_evalCoeffs
+	unsigned char	m_phaseCount[PAWN+1];
+	short			m_pst[PAWN+1];
+	short			m_endPawn;
+	short			m_endKing;
+	short			m_drive[2];
+	short			m_fixed;
+	short			m_eval;					// eval_Position(SIDE_WHITE) when sampled
+} t_texelSample;
+
+typedef struct tag_texelSet
+{
+	t_texelSample	*m_samples;
+	long			m_count;
+	long			m_wins;
+	long			m_losses;
+} t_texelSet;
+
+/*-----------------------------------------------------------------------*/
+// The position on the board, labelled with white's result
+void texel_Sample(float result, t_texelSample *sample);
+
+// Load collectpos output, either the TSV (a header line naming result, eval
+// and fen columns) or a posfile.h binary, mapping the file rather than
+// reading it.  Rows whose stored eval differs from this build's
+// eval_Position are counted into *stale: the file came from another
+// evaluation and fitting it would fit the wrong one.  Returns the row count,
+// or -1 if the file could not be read
+long texel_Load(const char *path, t_texelSet *set, long *stale);
+void texel_Free(t_texelSet *set);
+
+/*-----------------------------------------------------------------------*/
+// The shipping numbers, the bounds a fit stays inside, and a name to print
+void texel_Shipping(double *params);
+void texel_Clamp(double *params);
+const char *texel_Name(int param);
+
+// The score eval_Position would give at these numbers, white-positive.  The
+// same integer steps as eval.c: rounded totals, the four-step blend, the
+// drive gate read after it
+int texel_Eval(const double *params, const t_texelSample *sample);
+
+// How many samples the model does not score exactly as the engine did
+long texel_Verify(const t_texelSet *set);
+
+/*-----------------------------------------------------------------------*/
+// Mean squared error of the sigmoid of the score against the result, split
+// over "threads" workers
+double texel_Loss(const t_texelSet *set, const double *params, double k, int threads);
+
+// That plus lambda times the L2 pull toward the shipping numbers, and its
+// gradient.  The score is linear in every number between blend steps, so the
+// gradient is exact there rather than a finite difference
+double texel_Gradient(const t_texelSet *set, const double *params, double k,
+                      double lambda, double *grad, int threads);
+
+// The K that best fits the shipping numbers, scanned 0.2 .. 3.0 by 0.05
+double texel_FitK(const t_texelSet *set, int threads);
+
+// One Adam run from the shipping point.  Not a search over candidates
+void texel_Fit(const t_texelSet *set, double k, double lambda, int steps,
+               int threads, int verbose, double *params);
+
+/*-----------------------------------------------------------------------*/
+// The shipping form: piece values to 5, scales to hundredths and no larger
+// than a signed char table can hold
+void texel_Quantize(const double *params, double *quant);
+// 1 if every scaled cell still fits a signed char
+char texel_TablesFit(const double *params);
+// 1 if inside the band where a freeze is the table that already ships
+char texel_NearShipping(const double *params);
+
+#endif //_TEXEL_H_
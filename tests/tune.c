@@ -0,0 +1,238 @@
+/*
+ *	tune.c
+ *	cc65 Chess - test support
+ *
+ *	The E2 fit, native.  Reads collectpos output, TSV or --bin, checks that every position
+ *	still scores what the engine that wrote it said, fits once from the
+ *	shipping point and reports the freeze - the same report tune_eval.py gave,
+ *	at a speed where a whole data set is an epoch in milliseconds.
+ *
+ *	Built with EVAL_TUNING for the coefficients, but with every extra term
+ *	left at its shipping default, so the evaluation fitted is the one
+ *	collectpos played with.
+ *
+ *	It also answers "why did this position score that": --trace prints every
+ *	term of every FEN in a file, white-positive, one eval_Trace per line.
+ *
+ *	  ./tune --check train.tsv
+ *	  ./tune --trace book.epd
+ *	  ./tune --train train.tsv --val val.tsv [--lambda 0.02] [--steps 80]
+ *	         [--threads N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "types.h"
+#include "engine.h"
+#include "eval.h"
+#include "texel.h"
+#include "testutil.h"
+
+/*-----------------------------------------------------------------------*/
+static double nowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/*-----------------------------------------------------------------------*/
+static int load(const char *path, t_texelSet *set)
+{
+	double start = nowMs();
+	long stale, bad;
+
+	if(texel_Load(path, set, &stale) < 0)
+	{
+		fprintf(stderr, "tune: cannot read %s\n", path);
+		return 0;
+	}
+	printf("loaded %s: %ld positions in %.0f ms\n", path, set->m_count, nowMs() - start);
+
+	// the file has to be this evaluation's, and the model has to be this
+	// evaluation - both, for every position, or the fit means nothing
+	if(stale)
+	{
+		printf("  FAIL: %ld positions score differently in this build than in the file\n",
+		       stale);
+		return 0;
+	}
+	bad = texel_Verify(set);
+	if(bad)
+	{
+		printf("  FAIL: the model misses eval_Position on %ld positions\n", bad);
+		return 0;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+static void printParams(const double *p)
+{
+	printf("  N=%.1f B=%.1f R=%.1f Q=%.1f  sP=%.2f sN=%.2f sB=%.2f sR=%.2f sQ=%.2f "
+	       "sK=%.2f  sEndP=%.2f sEndK=%.2f\n",
+	       p[TEXEL_N], p[TEXEL_B], p[TEXEL_R], p[TEXEL_Q],
+	       p[TEXEL_SP], p[TEXEL_SN], p[TEXEL_SB], p[TEXEL_SR], p[TEXEL_SQ],
+	       p[TEXEL_SK], p[TEXEL_SENDP], p[TEXEL_SENDK]);
+}
+
+/*-----------------------------------------------------------------------*/
+static double report(const char *name, const t_texelSet *set, const double *p,
+                     double k, int threads)
+{
+	double mse = texel_Loss(set, p, k, threads);
+
+	printf("  %s: %ld positions  W/L/D pos %ld/%ld/%ld  mse %.6f  K=%.2f\n",
+	       name, set->m_count, set->m_wins, set->m_losses,
+	       set->m_count - set->m_wins - set->m_losses, mse, k);
+	return mse;
+}
+
+/*-----------------------------------------------------------------------*/
+// One line per position, tab-separated so it reads straight into anything
+static int traceFile(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char line[256];
+
+	if(!fp)
+	{
+		fprintf(stderr, "tune: cannot open %s\n", path);
+		return 1;
+	}
+	printf("total\tmaterial\tpst\tendgame\tdrive\tkbn\tdev\tpawnstruct\tphase\tstm\tfen\n");
+	while(fgets(line, sizeof(line), fp))
+	{
+		char *nl = strpbrk(line, "\r\n");
+		t_evalTrace trace;
+		char side;
+
+		if(nl)
+			*nl = '\0';
+		if(!line[0] || line[0] == '#')
+			continue;
+		side = test_EngineSetFEN(line);
+		eval_Trace(SIDE_WHITE, &trace);
+		printf("%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%c\t%s\n", trace.m_total,
+		       trace.m_material, trace.m_pst, trace.m_endgame, trace.m_mateDrive,
+		       trace.m_kbn, trace.m_dev, trace.m_pawnStruct, trace.m_phase,
+		       side == SIDE_WHITE ? 'w' : 'b', line);
+	}
+	fclose(fp);
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: tune --train FILE --val FILE [--lambda L] [--steps N] [--threads N]\n"
+		"       tune --check FILE\n"
+		"       tune --trace FILE\n");
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	const char *trainPath = 0, *valPath = 0, *checkPath = 0;
+	double lambda = 0.02, k, start, tr0, va0, tr1, va1;
+	double base[TEXEL_PARAMS], fitted[TEXEL_PARAMS], quant[TEXEL_PARAMS];
+	double grad[TEXEL_PARAMS];
+	int steps = 80, threads = (int)sysconf(_SC_NPROCESSORS_ONLN), i;
+	t_texelSet train, val;
+
+	for(i = 1; i < argc; ++i)
+	{
+		if(0 == strcmp(argv[i], "--train") && i + 1 < argc)
+			trainPath = argv[++i];
+		else if(0 == strcmp(argv[i], "--val") && i + 1 < argc)
+			valPath = argv[++i];
+		else if(0 == strcmp(argv[i], "--check") && i + 1 < argc)
+			checkPath = argv[++i];
+		else if(0 == strcmp(argv[i], "--trace") && i + 1 < argc)
+			return traceFile(argv[++i]);
+		else if(0 == strcmp(argv[i], "--lambda") && i + 1 < argc)
+			lambda = atof(argv[++i]);
+		else if(0 == strcmp(argv[i], "--steps") && i + 1 < argc)
+			steps = atoi(argv[++i]);
+		else if(0 == strcmp(argv[i], "--threads") && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+	if(threads < 1)
+		threads = 1;
+
+	if(checkPath)
+	{
+		if(!load(checkPath, &train))
+			return 1;
+		printf("eval check: %ld/%ld match\n", train.m_count, train.m_count);
+		texel_Free(&train);
+		return 0;
+	}
+	if(!trainPath || !valPath)
+	{
+		usage();
+		return 2;
+	}
+
+	if(!load(trainPath, &train) || !load(valPath, &val))
+		return 1;
+	printf("model matches eval_Position on all %ld positions\n", train.m_count + val.m_count);
+
+	texel_Shipping(base);
+	start = nowMs();
+	texel_Gradient(&train, base, 1.0, lambda, grad, threads);
+	start = nowMs() - start;
+	printf("one epoch: %.1f ms on %d threads, %.0f positions/ms\n", start, threads,
+	       train.m_count / (start > 0 ? start : 1e-3));
+
+	k = texel_FitK(&train, threads);
+	printf("baseline (shipping numbers)\n");
+	tr0 = report("train", &train, base, k, threads);
+	va0 = report("val  ", &val, base, k, threads);
+
+	printf("fit: one Adam run, lambda=%g, K frozen at %.2f\n", lambda, k);
+	texel_Fit(&train, k, lambda, steps, threads, 1, fitted);
+	printf("continuous fit\n");
+	printParams(fitted);
+	report("train", &train, fitted, k, threads);
+	report("val  ", &val, fitted, k, threads);
+
+	texel_Quantize(fitted, quant);
+	printf("quantized candidate (the freeze)\n");
+	printParams(quant);
+	if(!texel_TablesFit(quant))
+		printf("  note: a scale was clamped so every cell still fits a signed char\n");
+	tr1 = report("train", &train, quant, k, threads);
+	va1 = report("val  ", &val, quant, k, threads);
+
+	printf("delta vs shipping\n");
+	printf("  train mse %.6f -> %.6f  (%+.6f)\n", tr0, tr1, tr1 - tr0);
+	printf("  val   mse %.6f -> %.6f  (%+.6f)\n", va0, va1, va1 - va0);
+
+	if(texel_NearShipping(quant))
+	{
+		printf("NEAR_SHIPPING: the constrained minimum is the table that already ships.\n");
+		printf("A null is done - do not spend a gauntlet on a no-op.\n");
+	}
+	else
+	{
+		printf("CANDIDATE\n");
+		printf("  piece values: P=100 N=%d B=%d R=%d Q=%d\n", (int)quant[TEXEL_N],
+		       (int)quant[TEXEL_B], (int)quant[TEXEL_R], (int)quant[TEXEL_Q]);
+		printf("  PST scales stay a shape-preserving multiply of the existing tables.\n");
+	}
+
+	texel_Free(&train);
+	texel_Free(&val);
+	return 0;
+}
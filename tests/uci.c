@@ -22,21 +22,40 @@
  *
  *	Node budgets are clamped to 65535 because cc65's unsigned int is 16 bits.
  *	Asking for more natively would measure a configuration no C64 can reach.
+ *
+ *	Two extensions are not UCI, at the prompt or as the first argument:
+ *
+ *	  bench [json]
+ *	  analyse <file.epd> [depth N] [nodes N] [jobs N] [out <file>]
+ *
+ *	"analyse" searches every position in the file at one budget, with the
+ *	options set so far, and writes the file back with the engine's verdict
+ *	on each as EPD opcodes - moves in the long algebraic form, as every EPD
+ *	written in tests/ has them.  Screening a book through it costs the
+ *	searches and nothing else, and "jobs" shares those over forked workers.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
 #include "types.h"
 #include "globals.h"
 #include "engine.h"
 #include "eval.h"
 #include "search.h"
 #include "cpu.h"
+#include "polybook.h"
+#include "bench.h"
 #include "testutil.h"
 
 #define UCI_LINE_MAX	16384		// a 400 ply "position ... moves" line and room over
 #define UCI_MAX_NODES	65535L		// what a 16 bit unsigned int can hold on the target
+#define UCI_MAX_JOBS	64			// analyse workers
+#define UCI_EPD_MAX		256			// one EPD line
 
 /*-----------------------------------------------------------------------*/
 // The piece enum indexed directly: ROOK 1, KNIGHT 2, BISHOP 3, QUEEN 4
@@ -58,6 +77,10 @@ static long s_optNodes;						// 0 = take it from the skill level
 static char s_ownBook;
 static char s_bookSeed = 1;
 
+// A book file from tests/mkbook, asked after the tables at any ply.  Only
+// with OwnBook on, so naming a file changes nothing until a runner asks
+static char s_haveBookFile;
+
 // what cmdPosition replayed: how many moves, and white's first, as 0..63 tiles
 static char s_ply;
 static char s_firstFrom, s_firstTo;
@@ -125,25 +148,6 @@ static char findMove(const char *text, t_engMove *out)
 	return 0;
 }
 
-/*-----------------------------------------------------------------------*/
-// The test FEN parser stops at the en passant field, but the halfmove clock
-// after it is what the fifty move rule runs on, so pick it up here
-static void readHalfmove(const char *fen)
-{
-	const char *p = fen;
-	int field = 0;
-
-	while(*p && field < 4)
-	{
-		while(*p == ' ') ++p;
-		while(*p && *p != ' ') ++p;
-		++field;
-	}
-	while(*p == ' ') ++p;
-
-	geHalfmove = (*p >= '0' && *p <= '9') ? (char)atoi(p) : 0;
-}
-
 /*-----------------------------------------------------------------------*/
 static void cmdPosition(char *args)
 {
@@ -165,7 +169,7 @@ static void cmdPosition(char *args)
 	else if(0 == strncmp(args, "fen ", 4))
 	{
 		s_side = test_EngineSetFEN(args + 4);
-		readHalfmove(args + 4);
+		geHalfmove = test_FENHalfmove(args + 4);
 		// a game that did not start at the start position has no move one for
 		// the tables to answer, so put the ply count out of their reach
 		s_ply = 2;
@@ -203,6 +207,60 @@ static void cmdPosition(char *args)
 	}
 }
 
+#ifdef EVAL_TUNING
+/*-----------------------------------------------------------------------*/
+// Not UCI: the score of the current position term by term, from the side to
+// move's point of view, the way Stockfish answers "eval"
+static void cmdEval(void)
+{
+	t_evalTrace trace;
+
+	eval_Trace(s_side, &trace);
+	printf("info string eval material %d pst %d endgame %d drive %d kbn %d dev %d "
+	       "pawnstruct %d phase %d total %d\n",
+	       trace.m_material, trace.m_pst, trace.m_endgame, trace.m_mateDrive,
+	       trace.m_kbn, trace.m_dev, trace.m_pawnStruct, trace.m_phase, trace.m_total);
+	fflush(stdout);
+}
+#endif
+
+#if SEARCH_STATS
+/*-----------------------------------------------------------------------*/
+// The last search's dashboard on one line.  Percentages are of the nodes the
+// class is drawn from: q of all nodes, first and killer of the cuts.  ebf is
+// the growth of the last finished iteration over the one before it
+static void printStats(unsigned int nodes)
+{
+	t_searchStats stats;
+	unsigned long grew = 0, was = 0;
+	int d;
+
+	search_Stats(&stats);
+	for(d = SEARCH_MAX_PLY; d >= 2; --d)
+	{
+		if(!stats.m_iterNodes[d] || !stats.m_iterNodes[d - 1])
+			continue;
+		grew = stats.m_iterNodes[d] - stats.m_iterNodes[d - 1];
+		was = stats.m_iterNodes[d - 1] - stats.m_iterNodes[d - 2];
+		break;
+	}
+
+	printf("info string stats pv %lu cut %lu all %lu draw %lu horizon %lu q %lu (%.1f%%)"
+	       " first %.1f%% killer %.1f%% gen %.2f searched %.2f arena %u/%u"
+	       " researches %d ebf %.2f%s\n",
+	       stats.m_pvNodes, stats.m_cutNodes, stats.m_allNodes, stats.m_drawNodes,
+	       stats.m_horizonNodes, stats.m_qNodes,
+	       nodes ? 100.0 * stats.m_qNodes / nodes : 0.0,
+	       stats.m_cutNodes ? 100.0 * stats.m_firstCuts / stats.m_cutNodes : 0.0,
+	       stats.m_cutNodes ? 100.0 * stats.m_killerCuts / stats.m_cutNodes : 0.0,
+	       stats.m_genNodes ? (double)stats.m_genMoves / stats.m_genNodes : 0.0,
+	       stats.m_genNodes ? (double)stats.m_searched / stats.m_genNodes : 0.0,
+	       stats.m_arenaPeak, stats.m_arenaSize, stats.m_researches,
+	       was ? (double)grew / was : 0.0,
+	       stats.m_userStop ? " stopped" : stats.m_aborted ? " aborted" : "");
+}
+#endif
+
 /*-----------------------------------------------------------------------*/
 // go depth N / go nodes N beat the options, the options beat the skill level.
 // Every clock the GUI sends is ignored on purpose - see the file header
@@ -253,7 +311,31 @@ static void cmdGo(char *args)
 		}
 	}
 
+	// The roll comes from the seed and the position rather than from
+	// search_Random: reseeding here would restart the search's own opening
+	// randomisation on every move the book does not answer
+	if(s_ownBook && s_haveBookFile)
+	{
+		uint64_t key = polybook_Key(s_side);
+
+		if(polybook_Pick(s_side, (unsigned long)(key ^ (key >> 32)) * (s_bookSeed | 1),
+		                 &result.m_move))
+		{
+			char bookName[8];
+
+			memset(bookName, 0, sizeof(bookName));
+			moveName(&result.m_move, bookName);
+			printf("info depth 0 score cp 0 nodes 0 string book\n");
+			printf("bestmove %s\n", bookName);
+			fflush(stdout);
+			return;
+		}
+	}
+
 	search_Best(s_side, depth, (unsigned int)nodes, &result);
+#if SEARCH_STATS
+	printStats(result.m_nodes);
+#endif
 
 	if(!result.m_haveMove)
 	{
@@ -319,6 +401,14 @@ static void cmdSetOption(char *args)
 		s_optNodes = atol(value);
 	else if(0 == strcmp(name, "OwnBook"))
 		s_ownBook = (char)(0 == strcmp(value, "true") || atoi(value));
+	else if(0 == strcmp(name, "BookFile"))
+	{
+		long entries = (*value && strcmp(value, "<empty>")) ? polybook_Load(value) : -1;
+
+		s_haveBookFile = (char)(entries > 0);
+		if(*value && strcmp(value, "<empty>"))
+			printf("info string BookFile %s: %ld entries\n", value, entries < 0 ? 0L : entries);
+	}
 	else if(0 == strcmp(name, "BookSeed"))
 	{
 		// zero is the randomiser's dead state and means "do not randomise", so
@@ -399,6 +489,7 @@ static void cmdUci(void)
 	// comes up, and is the game's plat_GetSeed byte by another name
 	printf("option name OwnBook type check default false\n");
 	printf("option name BookSeed type spin default 1 min 0 max 255\n");
+	printf("option name BookFile type string default <empty>\n");
 #ifdef EVAL_TUNING
 	printf("option name Repetition type check default true\n");
 	printf("option name CheckEvasion type check default true\n");
@@ -416,10 +507,272 @@ static void cmdUci(void)
 }
 
 /*-----------------------------------------------------------------------*/
-int main(void)
+// What a worker sends back for one position: the whole output line, so the
+// parent only has to put them in order
+typedef struct tag_analyseLine
+{
+	int				m_index;
+	unsigned long	m_nodes;
+	double			m_seconds;
+	char			m_text[UCI_EPD_MAX + 64];
+} t_analyseLine;
+
+/*-----------------------------------------------------------------------*/
+static double wallClock(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*-----------------------------------------------------------------------*/
+// The first four fields of an EPD or FEN line are the position; a FEN's
+// halfmove clock comes along when it is there, and any opcodes are dropped
+static void analyseOne(int index, const char *epd, char depth, long nodes,
+                       t_analyseLine *out)
+{
+	t_searchResult result;
+	char fen[UCI_EPD_MAX], name[8], *p = fen;
+	const char *at = epd;
+	int fields = 0;
+	clock_t taken;
+
+	while(*at && p < fen + sizeof(fen) - 1)
+	{
+		if(' ' == *at && ++fields == 4)
+			break;
+		*p++ = *at++;
+	}
+	*p = '\0';
+
+	s_side = test_EngineSetFEN(fen);
+	geHalfmove = test_FENHalfmove(epd);
+	taken = clock();
+	search_Best(s_side, depth, (unsigned int)nodes, &result);
+	taken = clock() - taken;
+
+	out->m_index = index;
+	out->m_nodes = result.m_nodes;
+	out->m_seconds = (double)taken / CLOCKS_PER_SEC;
+
+	memset(name, 0, sizeof(name));
+	if(result.m_haveMove)
+		moveName(&result.m_move, name);
+	else
+		strcpy(name, "0000");
+
+	p = out->m_text + sprintf(out->m_text, "%s bm %s; ce %d;", fen, name, result.m_score);
+	if(result.m_score > EVAL_MATE - SEARCH_MAX_PLY)
+		p += sprintf(p, " dm %d;", (EVAL_MATE - result.m_score + 1) / 2);
+	else if(result.m_score < -(EVAL_MATE - SEARCH_MAX_PLY))
+		p += sprintf(p, " dm %d;", -((EVAL_MATE + result.m_score + 1) / 2));
+	sprintf(p, " acd %d; acn %u; acs %.3f;", result.m_depth, result.m_nodes,
+	        out->m_seconds);
+}
+
+/*-----------------------------------------------------------------------*/
+static int readLine(int fd, t_analyseLine *line)
+{
+	char *at = (char *)line;
+	size_t left = sizeof(*line);
+
+	while(left)
+	{
+		ssize_t got = read(fd, at, left);
+
+		if(got <= 0)
+			return 0;
+		at += got;
+		left -= (size_t)got;
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+// analyse <file.epd> [depth N] [nodes N] [jobs N] [out <file>].  Depth and
+// nodes default the way "go" does.  Worker w searches positions w, w + jobs
+// and so on, and position i is always the next thing on pipe i mod jobs, so
+// the output comes back in file order with no reorder buffer.  The search is
+// unseeded, as bench's is, so the same file gives the same answers at any
+// job count; the session's seed and position are left as they were
+static void cmdAnalyse(char *args)
+{
+	char depth = gcSearchSkill[s_skill - 1].m_depth;
+	long nodes = gcSearchSkill[s_skill - 1].m_nodes;
+	int jobs = 1, count = 0, i, w, failed = 0;
+	int fds[UCI_MAX_JOBS];
+	char **lines = NULL, buf[UCI_EPD_MAX];
+	char *path = strtok(args, " \t\r\n"), *outPath = NULL, *tok;
+	unsigned long total = 0;
+	unsigned int seed = search_SeedState();
+	double searching = 0, start;
+	FILE *in, *out = stdout;
+
+	if(s_optDepth) depth = (char)s_optDepth;
+	if(s_optNodes) nodes = s_optNodes;
+	while((tok = strtok(NULL, " \t\r\n")) != NULL)
+	{
+		char *val = strtok(NULL, " \t\r\n");
+
+		if(!val)
+			break;
+		if(0 == strcmp(tok, "depth")) depth = (char)atoi(val);
+		else if(0 == strcmp(tok, "nodes")) nodes = atol(val);
+		else if(0 == strcmp(tok, "jobs")) jobs = atoi(val);
+		else if(0 == strcmp(tok, "out")) outPath = val;
+	}
+	if(depth < 1) depth = 1;
+	if(depth > SEARCH_MAX_PLY) depth = SEARCH_MAX_PLY;
+	if(nodes < 1) nodes = 1;
+	if(nodes > UCI_MAX_NODES) nodes = UCI_MAX_NODES;
+	if(jobs < 1) jobs = 1;
+	if(jobs > UCI_MAX_JOBS) jobs = UCI_MAX_JOBS;
+
+	in = path ? fopen(path, "r") : NULL;
+	if(!in)
+	{
+		printf("info string analyse: cannot read %s\n", path ? path : "(no file)");
+		fflush(stdout);
+		return;
+	}
+	while(fgets(buf, sizeof(buf), in))
+	{
+		buf[strcspn(buf, "\r\n")] = '\0';
+		if(!buf[0] || '#' == buf[0])
+			continue;
+		lines = realloc(lines, (count + 1) * sizeof(*lines));
+		lines[count++] = strdup(buf);
+	}
+	fclose(in);
+
+	if(outPath && !(out = fopen(outPath, "w")))
+	{
+		printf("info string analyse: cannot write %s\n", outPath);
+		out = stdout;
+		count = 0;
+	}
+	if(jobs > count)
+		jobs = count ? count : 1;
+
+	// nothing buffered may be copied into the children, to be flushed twice
+	fflush(out);
+	fflush(stdout);
+	search_SetSeed(0);
+	start = wallClock();
+	for(w = 0; w < jobs && count; ++w)
+	{
+		int pipeFds[2];
+		pid_t pid = -1;
+
+		// a pipe with no worker on the other end is closed again
+		if(!pipe(pipeFds) && (pid = fork()) < 0)
+		{
+			close(pipeFds[0]);
+			close(pipeFds[1]);
+		}
+		if(pid < 0)
+		{
+			printf("info string analyse: cannot start worker %d\n", w);
+			jobs = w;
+			failed = 1;
+			break;
+		}
+		if(!pid)
+		{
+			close(pipeFds[0]);
+			for(i = 0; i < w; ++i)
+				close(fds[i]);
+			for(i = w; i < count; i += jobs)
+			{
+				t_analyseLine line;
+
+				memset(&line, 0, sizeof(line));
+				analyseOne(i, lines[i], depth, nodes, &line);
+				if(write(pipeFds[1], &line, sizeof(line)) != (ssize_t)sizeof(line))
+					break;
+			}
+			_exit(0);
+		}
+		close(pipeFds[1]);
+		fds[w] = pipeFds[0];
+	}
+
+	for(i = 0; i < count && !failed; ++i)
+	{
+		t_analyseLine line;
+
+		if(!readLine(fds[i % jobs], &line) || line.m_index != i)
+		{
+			printf("info string analyse: worker %d stopped before position %d\n",
+			       i % jobs, i + 1);
+			failed = 1;
+			break;
+		}
+		fprintf(out, "%s\n", line.m_text);
+		total += line.m_nodes;
+		searching += line.m_seconds;
+	}
+
+	for(w = 0; w < jobs; ++w)
+		close(fds[w]);
+	while(wait(NULL) > 0)
+		;
+	if(out != stdout)
+		fclose(out);
+
+	printf("info string analyse %d positions depth %d nodes %ld jobs %d:"
+	       " %lu nodes %.1f s searching %.1f s wall\n", failed ? i : count, depth,
+	       nodes, jobs, total, searching, wallClock() - start);
+	fflush(stdout);
+
+	for(i = 0; i < count; ++i)
+		free(lines[i]);
+	free(lines);
+	search_RestoreSeed(seed);
+}
+
+/*-----------------------------------------------------------------------*/
+// Not UCI either: bench.h's signature and speed for this build, the way
+// Stockfish's "bench" reports them.  "bench json" for a script to read
+static void cmdBench(const char *args)
+{
+	t_benchTotals totals;
+
+	bench_Run(stdout, 1, 0 == strcmp(args, "json"), &totals);
+	fflush(stdout);
+	eng_SetStartPosition();
+	s_side = SIDE_WHITE;
+	s_ply = 0;
+}
+
+/*-----------------------------------------------------------------------*/
+int main(int argc, char **argv)
 {
 	static char line[UCI_LINE_MAX];
 
+	// ./uci bench [json], for a gate to run without a session
+	if(argc > 1 && 0 == strcmp(argv[1], "bench"))
+	{
+		cmdBench(argc > 2 ? argv[2] : "");
+		return 0;
+	}
+
+	// ./uci analyse <file.epd> [depth N] ..., the same words as at the prompt
+	if(argc > 2 && 0 == strcmp(argv[1], "analyse"))
+	{
+		int i;
+
+		line[0] = '\0';
+		for(i = 2; i < argc; ++i)
+		{
+			strncat(line, argv[i], sizeof(line) - strlen(line) - 2);
+			strcat(line, " ");
+		}
+		cmdAnalyse(line);
+		return 0;
+	}
+
 	// nothing is switched here.  The shipping build has no switches at all -
 	// EVAL_HAS is a constant 1 and every term is always in - and the tuning
 	// build starts with everything on, so an unconfigured match plays the same
@@ -443,6 +796,12 @@ int main(void)
 		else if(0 == strncmp(line, "go ", 3))				cmdGo(line + 3);
 		else if(0 == strcmp(line, "stop"))					/* never searching */;
 		else if(0 == strcmp(line, "d"))						test_DumpBoard("position");
+		else if(0 == strcmp(line, "bench"))					cmdBench("");
+		else if(0 == strncmp(line, "bench ", 6))			cmdBench(line + 6);
+		else if(0 == strncmp(line, "analyse ", 8))			cmdAnalyse(line + 8);
+#ifdef EVAL_TUNING
+		else if(0 == strcmp(line, "eval"))					cmdEval();
+#endif
 		else if(0 == strcmp(line, "quit"))					break;
 	}
 	return 0;
@@ -0,0 +1,118 @@
+/*
+ *	zxsearch.c
+ *	cc65 Chess - test support
+ *
+ *	The Spectrum's c64perft and c64search in one: perft from the start
+ *	position, then the same three search budgets c64search runs, each timed
+ *	in frames.  Build it twice, with and without the Z80 kernels in
+ *	src/spectrum/engineZ80.asm, and the counts have to be identical line for
+ *	line - perft, the depth, the nodes and the move chosen.  Only then is the
+ *	time column worth reading.
+ *
+ *	FRAMES (23672) is the ROM's 50 Hz counter, so like the C64's jiffies it is
+ *	emulated time and warp mode does not change it.  Only the low 16 bits are
+ *	read; that is 21 minutes, longer than any line here takes.
+ *
+ *	Build (not part of the game Makefile):
+ *	  zcc +zx -vn -O3 -clib=default -DSEARCH_ARENA=256 -I../src \
+ *	      -o zxsearch -create-app \
+ *	      ../src/engine.c ../src/eval.c ../src/search.c zxsearch.c
+ *	and with the kernels:
+ *	  zcc +zx -vn -O3 -clib=default -DSEARCH_ARENA=256 -DENGINE_ASM=1 \
+ *	      -I../src -o zxsearchz80 -create-app \
+ *	      ../src/engine.c ../src/eval.c ../src/search.c \
+ *	      ../src/spectrum/engineZ80.asm zxsearch.c
+ */
+
+#include <stdio.h>
+#include "types.h"
+#include "engine.h"
+#include "eval.h"
+#include "search.h"
+
+#define FRAMES		(*(volatile unsigned int *)23672)
+
+// depth 3 needs 3 plies of move list; one spare
+#define PLIES	4
+
+static t_engMove st_arena[PLIES][ENG_MAX_MOVES];
+
+/*-----------------------------------------------------------------------*/
+// search.c polls this for RUN/STOP; nobody is at the keyboard here
+int plat_ReadKeys(char blocking)
+{
+	(void)blocking;
+	return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+static unsigned long perft(char side, char depth, char ply)
+{
+	t_engMove *moves = st_arena[ply];
+	t_engUndo undo;
+	char count, i;
+	unsigned long nodes = 0;
+
+	if(!depth)
+		return 1;
+
+	count = eng_GenMoves(side, moves, ENG_MAX_MOVES);
+
+	for(i = 0; i < count; ++i)
+	{
+		eng_Make(&moves[i], &undo);
+
+		if(!eng_IsAttacked(geKing[side], 1 - side))
+			nodes += (depth == 1) ? 1 : perft(1 - side, depth - 1, ply + 1);
+
+		eng_Unmake(&moves[i], &undo);
+	}
+
+	return nodes;
+}
+
+/*-----------------------------------------------------------------------*/
+int main(void)
+{
+	static const unsigned int budgets[3] = { 400, 1600, 6000 };
+	unsigned int start, taken;
+	char b;
+
+	printf("cc65 chess zx bench\n");
+	printf("engine asm %u\n\n", (unsigned)ENGINE_ASM);
+
+	for(b = 1; b <= 3; ++b)
+	{
+		unsigned long nodes;
+
+		eng_SetStartPosition();
+
+		start = FRAMES;
+		nodes = perft(SIDE_WHITE, b, 0);
+		taken = FRAMES - start;
+
+		printf("d%u n=%lu t=%u\n", (unsigned)b, nodes, taken);
+	}
+	printf("\n");
+
+	for(b = 0; b < 3; ++b)
+	{
+		t_searchResult result;
+
+		eng_SetStartPosition();
+
+		start = FRAMES;
+		search_Best(SIDE_WHITE, 6, budgets[b], &result);
+		taken = FRAMES - start;
+
+		printf("b=%u d=%u n=%u m=%02x%02x t=%u\n",
+		       budgets[b], (unsigned)result.m_depth, result.m_nodes,
+		       (unsigned)result.m_move.m_from, (unsigned)result.m_move.m_to,
+		       taken);
+	}
+
+	printf("\ndone.\n");
+
+	for(;;)
+		;
+}